@@ -0,0 +1,466 @@
+#include "stdafx.h"
+#define _SILENCE_ALL_CXX17_DEPRECATION_WARNINGS
+#define _SCL_SECURE_NO_WARNINGS
+#include "..\Twitch_C++_IRC_bot\TwitchMessage.h"
+#include "..\Twitch_C++_IRC_bot\IRC_Bot.h"
+#include "..\Twitch_C++_IRC_bot\Capture.h"
+#include "..\ParserTest\MockServer.h"
+#include "..\ParserTest\ParserTestCases.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#ifdef _MSC_VER
+#include <malloc.h>
+#endif
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// every allocation in the process goes through here
+namespace {
+	std::atomic<std::size_t> allocations{ 0 };
+}
+
+void* operator new(std::size_t size) {
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	if (void* ptr = std::malloc(size == 0 ? 1 : size)) { return ptr; }
+	throw std::bad_alloc{};
+}
+void operator delete(void* ptr) noexcept {
+	std::free(ptr);
+}
+void operator delete(void* ptr, std::size_t) noexcept {
+	std::free(ptr);
+}
+// std::pmr::new_delete_resource allocates through the aligned overloads
+// the MSVC CRT has no std::aligned_alloc, and what _aligned_malloc returns must not go to std::free
+namespace {
+	void* aligned_malloc(std::size_t size, std::size_t alignment) noexcept {
+		size = size == 0 ? 1 : size;
+#ifdef _MSC_VER
+		return _aligned_malloc(size, alignment);
+#else
+		return std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+#endif
+	}
+	void aligned_free(void* ptr) noexcept {
+#ifdef _MSC_VER
+		_aligned_free(ptr);
+#else
+		std::free(ptr);
+#endif
+	}
+}
+
+void* operator new(std::size_t size, std::align_val_t align) {
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	if (void* ptr = aligned_malloc(size, static_cast<std::size_t>(align))) { return ptr; }
+	throw std::bad_alloc{};
+}
+void operator delete(void* ptr, std::align_val_t) noexcept {
+	aligned_free(ptr);
+}
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept {
+	aligned_free(ptr);
+}
+
+namespace {
+	namespace capture    = Twitch::irc::capture;
+	namespace message    = Twitch::irc::message;
+	namespace commands   = Twitch::irc::message::cap::commands;
+	namespace membership = Twitch::irc::message::cap::membership;
+	namespace tags       = Twitch::irc::message::cap::tags;
+
+	using bench_clock = std::chrono::steady_clock;
+	using corpus_t = std::vector<std::string>;
+
+	// prevents the optimizer from dropping benchmarked calls
+	std::atomic<std::size_t> sink{ 0 };
+
+	struct Result
+	{
+		std::string name;
+		std::size_t messages;
+		double ns_per_message;
+		double messages_per_sec;
+		double allocations_per_message;
+	};
+
+	template<class Fn>
+	Result measure(std::string name, const corpus_t& corpus, std::size_t iterations, Fn&& fn) {
+		for (const auto& line : corpus) { fn(line); } // warm up
+
+		std::size_t local_sink{ 0 };
+		const auto allocations_before = allocations.load();
+		const auto start = bench_clock::now();
+
+		for (std::size_t i{ 0 }; i < iterations; ++i) {
+			for (const auto& line : corpus) {
+				local_sink += fn(line);
+			}
+		}
+
+		const auto elapsed = std::chrono::duration<double, std::nano>(bench_clock::now() - start);
+		const auto allocations_made = allocations.load() - allocations_before;
+		sink += local_sink;
+
+		const auto messages = corpus.size() * iterations;
+		const auto ns = elapsed.count() / static_cast<double>(messages);
+		return Result{
+			std::move(name),
+			messages,
+			ns,
+			1e9 / ns,
+			static_cast<double>(allocations_made) / static_cast<double>(messages)
+		};
+	}
+
+	void print_header() {
+		std::cout
+			<< std::left  << std::setw(28) << "benchmark"
+			<< std::right << std::setw(12) << "messages"
+			<< std::right << std::setw(12) << "ns/msg"
+			<< std::right << std::setw(14) << "msgs/sec"
+			<< std::right << std::setw(12) << "allocs/msg"
+			<< '\n';
+	}
+
+	void print(const Result& result) {
+		std::cout
+			<< std::left  << std::setw(28) << result.name
+			<< std::right << std::setw(12) << result.messages
+			<< std::fixed << std::setprecision(1)
+			<< std::right << std::setw(12) << result.ns_per_message
+			<< std::setprecision(0)
+			<< std::right << std::setw(14) << result.messages_per_sec
+			<< std::setprecision(2)
+			<< std::right << std::setw(12) << result.allocations_per_message
+			<< '\n';
+	}
+
+	// raw throughput of a pass over every byte of the corpus
+	template<class Fn>
+	void measure_bytes(const std::string& name, const corpus_t& corpus, std::size_t iterations, Fn&& fn) {
+		std::size_t bytes{ 0 };
+		for (const auto& line : corpus) { bytes += line.size(); fn(line); } // warm up
+
+		std::size_t local_sink{ 0 };
+		const auto start = bench_clock::now();
+		for (std::size_t i{ 0 }; i < iterations; ++i) {
+			for (const auto& line : corpus) {
+				local_sink += fn(line);
+			}
+		}
+		const auto elapsed = std::chrono::duration<double>(bench_clock::now() - start);
+		sink += local_sink;
+
+		const auto total = static_cast<double>(bytes) * static_cast<double>(iterations);
+		std::cout
+			<< std::left  << std::setw(28) << name
+			<< std::right << std::setw(12) << bytes * iterations
+			<< std::fixed << std::setprecision(2)
+			<< std::right << std::setw(12) << total / elapsed.count() / 1e9 << " GB/s"
+			<< '\n';
+	}
+
+	// a capture taken with --capture, or raw lines one per line
+	corpus_t read_corpus(const char* path) {
+		corpus_t corpus;
+		if (capture::Reader::is_capture(path)) {
+			capture::Reader reader{ path };
+			while (const auto record = reader.next()) { corpus.emplace_back(record->line); }
+			return corpus;
+		}
+
+		std::ifstream file{ path };
+		for (std::string line; std::getline(file, line); ) {
+			if (!line.empty()) { corpus.push_back(std::move(line)); }
+		}
+		return corpus;
+	}
+
+	template<class Message_t>
+	corpus_t lines_of(const std::vector<std::pair<std::string, Message_t>>& tests) {
+		corpus_t lines;
+		for (const auto& test : tests) { lines.push_back(test.first); }
+		return lines;
+	}
+
+	template<class Message_t>
+	void append(corpus_t& corpus, const std::vector<std::pair<std::string, Message_t>>& tests) {
+		for (const auto& test : tests) { corpus.push_back(test.first); }
+	}
+
+	// every raw line MessageParser::process is expected to handle
+	corpus_t fixture_corpus() {
+		corpus_t corpus;
+		append(corpus, doc::ping::tests);
+		append(corpus, doc::cap::commands::hosttarget::tests);
+		append(corpus, doc::cap::commands::notice::tests);
+		append(corpus, doc::cap::commands::reconnect::tests);
+		append(corpus, doc::cap::membership::join::tests);
+		append(corpus, doc::cap::membership::mode::tests);
+		append(corpus, doc::cap::membership::names::tests);
+		append(corpus, doc::cap::membership::part::tests);
+		append(corpus, doc::cap::tags::clearchat::tests);
+		append(corpus, doc::cap::tags::globaluserstate::tests);
+		append(corpus, doc::cap::tags::privmsg::tests);
+		append(corpus, doc::cap::tags::roomstate::tests);
+		append(corpus, doc::cap::tags::usernotice::tests);
+		append(corpus, doc::cap::tags::userstate::tests);
+		return corpus;
+	}
+
+	// weighted like real chat: ~85% PRIVMSG, rest JOIN/PART/USERNOTICE
+	corpus_t chat_corpus(std::size_t size) {
+		const auto privmsg    = lines_of(doc::cap::tags::privmsg::tests);
+		const auto join       = lines_of(doc::cap::membership::join::tests);
+		const auto part       = lines_of(doc::cap::membership::part::tests);
+		const auto usernotice = lines_of(doc::cap::tags::usernotice::tests);
+
+		std::mt19937 gen{ 0x7417C4 }; // fixed seed, runs have to be comparable
+		std::discrete_distribution<int> kind{ 85, 6, 6, 3 };
+		const auto pick = [&](const corpus_t& from) -> const std::string& {
+			return from[std::uniform_int_distribution<std::size_t>{ 0, from.size() - 1 }(gen)];
+		};
+
+		corpus_t corpus;
+		corpus.reserve(size);
+		for (std::size_t i{ 0 }; i < size; ++i) {
+			switch (kind(gen)) {
+			case 0:  corpus.push_back(pick(privmsg));    break;
+			case 1:  corpus.push_back(pick(join));       break;
+			case 2:  corpus.push_back(pick(part));       break;
+			default: corpus.push_back(pick(usernotice)); break;
+			}
+		}
+		return corpus;
+	}
+
+	// corpus read 16 lines at a time, as many times as iterations
+	std::string write_capture(const corpus_t& corpus, std::size_t iterations) {
+		constexpr std::size_t lines_per_read{ 16 };
+		const auto path = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()).string();
+
+		capture::Writer writer{ path };
+		std::vector<std::string_view> read;
+		for (std::size_t i{ 0 }; i < iterations; ++i) {
+			for (const auto& line : corpus) {
+				read.push_back(line);
+				if (read.size() == lines_per_read) {
+					writer.write(capture::clock_t::now(), read);
+					read.clear();
+				}
+			}
+		}
+		writer.write(capture::clock_t::now(), read);
+		return path;
+	}
+
+	// TwitchBot over a capture as fast as it goes, reads, parser, visitor and all
+	Result measure_replay(std::string name, const std::string& path) {
+		auto controller = std::make_shared<capture::ReplayController>(path, capture::ReplayController::as_fast_as_possible);
+		Twitch::irc::TwitchBot bot(
+			std::make_shared<Twitch::irc::Commands>(std::initializer_list<Twitch::irc::Commands::value_type>{}),
+			controller,
+			std::make_unique<message::MessageParser>(message::ParserVisitor::subscription())
+		);
+
+		const auto allocations_before = allocations.load();
+		const auto start = bench_clock::now();
+		bot.run_async();
+		const auto elapsed = std::chrono::duration<double, std::nano>(bench_clock::now() - start);
+		const auto allocations_made = allocations.load() - allocations_before;
+
+		const auto messages = std::max<std::size_t>(1, controller->connection_metrics().lines_read);
+		const auto ns = elapsed.count() / static_cast<double>(messages);
+		return Result{
+			std::move(name),
+			messages,
+			ns,
+			1e9 / ns,
+			static_cast<double>(allocations_made) / static_cast<double>(messages)
+		};
+	}
+
+	// TwitchBot against MockServer over loopback: PRIVMSGs the bot gets through, and how fast it answers commands
+	// latency quantiles are upper bounds of log2 buckets
+	void end_to_end(const std::string& name, std::size_t channels, Twitch::irc::testing::MockServer::Flood flood) {
+		using Twitch::irc::testing::MockServer;
+		using namespace std::chrono_literals;
+
+		MockServer server;
+		auto controller = std::make_shared<Twitch::irc::Controller>(
+			"127.0.0.1", server.port(), MockServer::channel_names(channels), "bench", "oauth:bench"
+		);
+		Twitch::irc::TwitchBot bot(
+			std::make_shared<Twitch::irc::Commands>(std::initializer_list<Twitch::irc::Commands::value_type>{
+				{ "!Hello", [](const tags::PRIVMSG& msg) { return '@' + std::string{ msg.display_name } + " World!"; } }
+			}),
+			controller,
+			std::make_unique<message::MessageParser>(message::ParserVisitor::subscription()),
+			std::make_shared<Twitch::irc::CommandExecutor>(2, 1024, Twitch::irc::CommandExecutor::Overflow::block)
+		);
+		std::thread thread([&bot]() { bot.run_async(); });
+
+		const auto privmsgs = [&bot]() {
+			std::uint64_t count{ 0 };
+			for (const auto& kind : bot.metrics({}).parser.kinds) {
+				if (kind.name == tags::PRIVMSG::name) { count += kind.count; }
+			}
+			return count;
+		};
+
+		const auto commands = flood.command_every == 0 ? 0 : flood.messages / flood.command_every;
+		bool done = server.wait_until([&](const auto& stats) { return stats.joins == channels; }, 60s);
+		const auto start = bench_clock::now();
+		server.flood(flood);
+		while (done && privmsgs() < flood.messages) {
+			done = bench_clock::now() - start < 60s;
+			std::this_thread::sleep_for(100us);
+		}
+		const auto elapsed = std::chrono::duration<double>(bench_clock::now() - start);
+		done = done && server.wait_until([&](const auto& stats) { return stats.responses == commands; }, 60s);
+
+		const auto stats = server.stats();
+		server.disconnect();
+		thread.join();
+
+		std::cout
+			<< std::left  << std::setw(28) << name
+			<< std::right << std::setw(10) << channels
+			<< std::right << std::setw(12) << flood.messages
+			<< std::fixed << std::setprecision(0)
+			<< std::right << std::setw(14) << static_cast<double>(flood.messages) / elapsed.count()
+			<< std::right << std::setw(10) << static_cast<double>(stats.latency.quantile(0.5)) / 1e3
+			<< std::right << std::setw(10) << static_cast<double>(stats.latency.quantile(0.99)) / 1e3
+			<< (done ? "" : "  (timed out)")
+			<< '\n';
+	}
+
+	template<class M, class Message_t>
+	Result measure_is(std::string name, const std::vector<std::pair<std::string, Message_t>>& tests, std::size_t iterations) {
+		return measure(std::move(name), lines_of(tests), iterations, [](const std::string& line) {
+			return static_cast<std::size_t>(M::is(line).has_value());
+		});
+	}
+}
+
+// usage: ParserBench [iterations] [capture, or recorded raw lines one per line]
+int main(int argc, char* argv[]) {
+	const std::size_t iterations = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 2000;
+	const auto recorded = argc > 2 ? read_corpus(argv[2]) : chat_corpus(1000);
+
+	message::MessageParser parser;
+	const auto process = [&](const std::string& line) {
+		return parser.process(line).index();
+	};
+	// one line per batch, same as the worst case of TwitchBot::process
+	Twitch::irc::BatchArena arena;
+	const auto process_batch = [&](const std::string& line) {
+		Twitch::irc::BatchArena::Scope batch{ arena };
+		return parser.process(line).index();
+	};
+
+	std::cout << "sizeof(MessageParser::result_t): " << sizeof(message::MessageParser::result_t) << '\n';
+	print_header();
+	print(measure("process (fixtures)", fixture_corpus(), iterations, process));
+	print(measure("process (chat mix)", chat_corpus(1000), iterations / 10 + 1, process));
+	print(measure("process (chat mix, arena)", chat_corpus(1000), iterations / 10 + 1, process_batch));
+
+	// what ConnectionPool runs: JOIN/PART and the other trace-only kinds are skipped
+	message::MessageParser subscribed{ message::ParserVisitor::subscription() };
+	const auto process_subscribed = [&](const std::string& line) {
+		Twitch::irc::BatchArena::Scope batch{ arena };
+		return subscribed.process(line).index();
+	};
+	print(measure("process (mix, subscribed)", chat_corpus(1000), iterations / 10 + 1, process_subscribed));
+
+	auto flood = lines_of(doc::cap::membership::join::tests);
+	append(flood, doc::cap::membership::part::tests);
+	print(measure("process (JOIN/PART, all)", flood, iterations, process));
+	print(measure("process (JOIN/PART, skip)", flood, iterations, process_subscribed));
+
+	const auto chat_capture = write_capture(chat_corpus(1000), iterations / 10 + 1);
+	print(measure_replay("replay (chat mix)", chat_capture));
+	boost::filesystem::remove(chat_capture);
+	if (argc > 2 && capture::Reader::is_capture(argv[2])) { print(measure_replay("replay (capture)", argv[2])); }
+
+	print(measure_is<message::PING>           ("PING",                    doc::ping::tests,                         iterations));
+	print(measure_is<message::PRIVMSG>        ("PRIVMSG",                 doc::privmsg::tests,                      iterations));
+	print(measure_is<commands::CLEARCHAT>     ("commands::CLEARCHAT",     doc::cap::commands::clearchat::tests,     iterations));
+	print(measure_is<commands::HOSTTARGET>    ("commands::HOSTTARGET",    doc::cap::commands::hosttarget::tests,    iterations));
+	print(measure_is<commands::NOTICE>        ("commands::NOTICE",        doc::cap::commands::notice::tests,        iterations));
+	print(measure_is<commands::RECONNECT>     ("commands::RECONNECT",     doc::cap::commands::reconnect::tests,     iterations));
+	print(measure_is<commands::ROOMSTATE>     ("commands::ROOMSTATE",     doc::cap::commands::roomstate::tests,     iterations));
+	print(measure_is<commands::USERNOTICE>    ("commands::USERNOTICE",    doc::cap::commands::usernotice::tests,    iterations));
+	print(measure_is<commands::USERSTATE>     ("commands::USERSTATE",     doc::cap::commands::userstate::tests,     iterations));
+	print(measure_is<membership::JOIN>        ("membership::JOIN",        doc::cap::membership::join::tests,        iterations));
+	print(measure_is<membership::MODE>        ("membership::MODE",        doc::cap::membership::mode::tests,        iterations));
+	print(measure_is<membership::NAMES>       ("membership::NAMES",       doc::cap::membership::names::tests,       iterations));
+	print(measure_is<membership::PART>        ("membership::PART",        doc::cap::membership::part::tests,        iterations));
+	print(measure_is<tags::CLEARCHAT>         ("tags::CLEARCHAT",         doc::cap::tags::clearchat::tests,         iterations));
+	print(measure_is<tags::GLOBALUSERSTATE>   ("tags::GLOBALUSERSTATE",   doc::cap::tags::globaluserstate::tests,   iterations));
+	print(measure_is<tags::PRIVMSG>           ("tags::PRIVMSG",           doc::cap::tags::privmsg::tests,           iterations));
+	print(measure_is<tags::ROOMSTATE>         ("tags::ROOMSTATE",         doc::cap::tags::roomstate::tests,         iterations));
+	print(measure_is<tags::USERNOTICE>        ("tags::USERNOTICE",        doc::cap::tags::usernotice::tests,        iterations));
+	print(measure_is<tags::USERSTATE>         ("tags::USERSTATE",         doc::cap::tags::userstate::tests,         iterations));
+	print(measure_is<message::view::PRIVMSG>  ("view::PRIVMSG",           doc::cap::tags::privmsg::tests,           iterations));
+
+	using message::StructuralScanner;
+	std::cout << "\nscan over " << (argc > 2 ? argv[2] : "chat mix") << ", block_mask is " << StructuralScanner::implementation() << '\n';
+	measure_bytes("StructuralScanner::next", recorded, iterations / 10 + 1, [](const std::string& line) {
+		StructuralScanner scanner{ line };
+		std::size_t count{ 0 };
+		while (scanner.next() != StructuralScanner::npos) { ++count; }
+		return count;
+	});
+	measure_bytes("block_mask", recorded, iterations / 10 + 1, [](const std::string& line) {
+		std::uint64_t masks{ 0 };
+		for (std::size_t offset{ 0 }; offset < line.size(); offset += StructuralScanner::block_size) {
+			masks ^= StructuralScanner::block_mask(line, offset);
+		}
+		return static_cast<std::size_t>(masks);
+	});
+	measure_bytes("block_mask_scalar", recorded, iterations / 10 + 1, [](const std::string& line) {
+		std::uint64_t masks{ 0 };
+		for (std::size_t offset{ 0 }; offset < line.size(); offset += StructuralScanner::block_size) {
+			masks ^= StructuralScanner::block_mask_scalar(line, offset);
+		}
+		return static_cast<std::size_t>(masks);
+	});
+	measure_bytes("TokenizedMessage::tokenize", recorded, iterations / 10 + 1, [](const std::string& line) {
+		const auto message = message::TokenizedMessage::tokenize(line);
+		return message ? message->tag_index.size() : 0;
+	});
+
+	std::cout << '\n'
+		<< std::left  << std::setw(28) << "end to end"
+		<< std::right << std::setw(10) << "channels"
+		<< std::right << std::setw(12) << "messages"
+		<< std::right << std::setw(14) << "msgs/sec"
+		<< std::right << std::setw(10) << "p50 us"
+		<< std::right << std::setw(10) << "p99 us"
+		<< '\n';
+	{
+		Twitch::irc::testing::MockServer::Flood flood;
+		flood.messages = iterations * 10;
+		flood.command_every = flood.messages / 20; // stays within one channel's moderator budget
+		end_to_end("flood, as fast as possible", 1, flood);
+		end_to_end("flood, as fast as possible", 50, flood);
+
+		flood.messages = 4000;
+		flood.rate = 2000.0;
+		flood.command_every = 100;
+		end_to_end("flood, 2000/s", 50, flood);
+	}
+
+	std::cout << "sink: " << sink.load() << '\n';
+	return 0;
+}
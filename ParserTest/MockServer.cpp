@@ -0,0 +1,408 @@
+#include "stdafx.h"
+#define _SILENCE_ALL_CXX17_DEPRECATION_WARNINGS
+#define _SCL_SECURE_NO_WARNINGS
+#include "MockServer.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <future>
+#include <string_view>
+#include <utility>
+
+namespace Twitch::irc::testing {
+	namespace {
+		using namespace std::string_view_literals;
+
+		constexpr std::size_t flood_chunk{ 64 * 1024 }; // flood stops generating while this much waits for the socket
+
+		std::int64_t unix_ms() {
+			return std::chrono::duration_cast<std::chrono::milliseconds>(
+				std::chrono::system_clock::now().time_since_epoch()
+			).count();
+		}
+	}
+
+	struct MockServer::Session
+	{
+		explicit Session(io_service_t& io_service) : socket(io_service), timer(io_service) {}
+
+		socket_t socket;
+		streambuf_t in{};
+		std::string pending; // waits for the write in flight
+		std::string writing;
+		bool closing{ false }; // closed once pending is written
+
+		std::string pass;
+		std::string nick;
+		bool logged_in{ false };
+		std::vector<std::string> channels;
+
+		Flood flood;
+		bool flooding{ false };
+		std::size_t flood_sent{ 0 };
+		std::size_t first_viewer{ 0 };
+		clock_t::time_point flood_start;
+		boost::asio::steady_timer timer;
+	};
+
+	std::vector<std::string> MockServer::channel_names(std::size_t count) {
+		std::vector<std::string> channels;
+		channels.reserve(count);
+		for (std::size_t i{ 0 }; i < count; ++i) { channels.push_back("#channel" + std::to_string(i)); }
+		return channels;
+	}
+
+	MockServer::MockServer() : MockServer(Options{}) {}
+
+	MockServer::MockServer(Options t_options) :
+		m_options(t_options)
+	{
+		const boost::asio::ip::tcp::endpoint endpoint{ boost::asio::ip::address_v4::loopback(), 0 };
+		m_acceptor.open(endpoint.protocol());
+		m_acceptor.bind(endpoint);
+		m_acceptor.listen();
+		m_port = m_acceptor.local_endpoint().port();
+
+		accept();
+		m_thread = std::thread([this]() { m_io_service.run(); });
+	}
+
+	MockServer::~MockServer() {
+		m_io_service.stop();
+		m_thread.join();
+
+		error_code_t ignored;
+		m_acceptor.close(ignored);
+		for (auto& session : m_sessions) { session->socket.close(ignored); }
+	}
+
+	void MockServer::send(std::string line) {
+		boost::asio::post(m_io_service, [this, line = std::move(line)]() {
+			for (const auto& session : m_sessions) {
+				if (session->logged_in) { write(session, line); }
+			}
+		});
+	}
+
+	void MockServer::ping() {
+		send("PING :tmi.twitch.tv");
+	}
+
+	void MockServer::reconnect() {
+		boost::asio::post(m_io_service, [this]() {
+			for (const auto& session : m_sessions) {
+				if (!session->logged_in) { continue; }
+				write(session, ":tmi.twitch.tv RECONNECT");
+				session->closing = true;
+				write_next(session);
+			}
+		});
+	}
+
+	void MockServer::disconnect() {
+		boost::asio::post(m_io_service, [this]() {
+			for (const auto& session : std::vector<std::shared_ptr<Session>>{ m_sessions }) { close(session); }
+		});
+	}
+
+	void MockServer::flood(Flood flood) {
+		boost::asio::post(m_io_service, [this, flood = std::move(flood)]() {
+			const auto session = newest();
+			if (!session || session->channels.empty()) { return; }
+
+			session->flood = flood;
+			session->flooding = true;
+			session->flood_sent = 0;
+			session->first_viewer = m_viewers;
+			session->flood_start = clock_t::now();
+			m_viewers += flood.messages;
+			pump(session);
+		});
+	}
+
+	MockServer::Stats MockServer::stats() const {
+		std::lock_guard<std::mutex> lock{ m_mutex };
+		auto stats = m_stats;
+		stats.latency = m_latency.snapshot();
+		return stats;
+	}
+
+	std::vector<std::string> MockServer::received() const {
+		std::lock_guard<std::mutex> lock{ m_mutex };
+		return m_received;
+	}
+
+	std::vector<std::string> MockServer::joined() {
+		std::promise<std::vector<std::string>> channels;
+		auto result = channels.get_future();
+		boost::asio::post(m_io_service, [this, &channels]() {
+			const auto session = newest();
+			channels.set_value(session ? session->channels : std::vector<std::string>{});
+		});
+		return result.get();
+	}
+
+	bool MockServer::wait_until(const std::function<bool(const Stats&)>& pred, std::chrono::milliseconds timeout) const {
+		std::unique_lock<std::mutex> lock{ m_mutex };
+		return m_cv.wait_for(lock, timeout, [&]() {
+			auto stats = m_stats;
+			stats.latency = m_latency.snapshot();
+			return pred(stats);
+		});
+	}
+
+	void MockServer::accept() {
+		auto session = std::make_shared<Session>(m_io_service);
+		m_acceptor.async_accept(session->socket, [this, session](const error_code_t& error) {
+			if (error) { return; }
+
+			session->socket.set_option(boost::asio::ip::tcp::no_delay{ true });
+			m_sessions.push_back(session);
+			{
+				std::lock_guard<std::mutex> lock{ m_mutex };
+				++m_stats.connections;
+			}
+			m_cv.notify_all();
+
+			read(session);
+			accept();
+		});
+	}
+
+	void MockServer::read(std::shared_ptr<Session> session) {
+		boost::asio::async_read_until(
+			session->socket,
+			session->in,
+			Controller::m_delimiter,
+			[this, session](const error_code_t& error, std::size_t) {
+				if (error) { return close(session); }
+
+				const auto data = session->in.data();
+				const std::string_view received{ static_cast<const char*>(data.data()), data.size() };
+				std::size_t begin{ 0 };
+				for (auto end = received.find(Controller::m_delimiter, begin);
+					end != std::string_view::npos;
+					end = received.find(Controller::m_delimiter, begin)
+				) {
+					handle(session, received.substr(begin, end - begin));
+					begin = end + Controller::m_delimiter.size();
+				}
+				session->in.consume(begin);
+				m_cv.notify_all();
+
+				if (session->socket.is_open()) { read(session); }
+			}
+		);
+	}
+
+	// "COMMAND :argument" or "COMMAND argument", Controller sends both
+	void MockServer::handle(const std::shared_ptr<Session>& session, std::string_view line) {
+		{
+			std::lock_guard<std::mutex> lock{ m_mutex };
+			m_received.emplace_back(line);
+		}
+
+		const auto space = line.find(' ');
+		const auto command = line.substr(0, space);
+		auto argument = space == std::string_view::npos ? std::string_view{} : line.substr(space + 1);
+		if (!argument.empty() && argument.front() == ':') { argument.remove_prefix(1); }
+
+		if (command == "CAP"sv) {
+			auto caps = argument.substr(std::min(argument.size(), argument.find(' ') + 1)); // "REQ :caps"
+			if (!caps.empty() && caps.front() == ':') { caps.remove_prefix(1); }
+			write(session, ":tmi.twitch.tv CAP * ACK :" + std::string{ caps });
+		}
+		else if (command == "PASS"sv) {
+			session->pass = argument;
+		}
+		else if (command == "NICK"sv) {
+			session->nick = argument;
+			if (session->pass.compare(0, 6, "oauth:") != 0) {
+				write(session, ":tmi.twitch.tv NOTICE * :Login authentication failed");
+				session->closing = true;
+				write_next(session);
+				return;
+			}
+
+			session->logged_in = true;
+			const auto& nick = session->nick;
+			write(session, ":tmi.twitch.tv 001 " + nick + " :Welcome, GLHF!");
+			write(session, ":tmi.twitch.tv 002 " + nick + " :Your host is tmi.twitch.tv");
+			write(session, ":tmi.twitch.tv 003 " + nick + " :This server is rather new");
+			write(session, ":tmi.twitch.tv 004 " + nick + " :-");
+			write(session, ":tmi.twitch.tv 375 " + nick + " :-");
+			write(session, ":tmi.twitch.tv 372 " + nick + " :You are in a maze of twisty passages, all alike.");
+			write(session, ":tmi.twitch.tv 376 " + nick + " :>");
+
+			std::lock_guard<std::mutex> lock{ m_mutex };
+			++m_stats.logins;
+		}
+		else if (command == "JOIN"sv && session->logged_in) {
+			const auto& nick = session->nick;
+			const auto user = ":" + nick + "!" + nick + "@" + nick + ".tmi.twitch.tv";
+			const auto mod = m_options.moderator ? "1"sv : "0"sv;
+			while (!argument.empty()) {
+				const std::string channel{ argument.substr(0, argument.find(',')) };
+				argument.remove_prefix(std::min(argument.size(), channel.size() + 1));
+				if (channel.empty()) { continue; }
+
+				if (std::find(session->channels.begin(), session->channels.end(), channel) == session->channels.end()) {
+					session->channels.push_back(channel);
+				}
+				write(session, user + " JOIN " + channel);
+				write(session,
+					"@badge-info=;badges=" + std::string{ m_options.moderator ? "moderator/1" : "" }
+					+ ";color=;display-name=" + nick + ";emote-sets=0;mod=" + std::string{ mod }
+					+ ";subscriber=0;user-type=" + std::string{ m_options.moderator ? "mod" : "" }
+					+ " :tmi.twitch.tv USERSTATE " + channel
+				);
+				write(session,
+					"@broadcaster-lang=;emote-only=0;followers-only=-1;r9k=0;rituals=0;room-id="
+					+ std::to_string(++m_room_ids) + ";slow=0;subs-only=0 :tmi.twitch.tv ROOMSTATE " + channel
+				);
+				write(session, ":" + nick + ".tmi.twitch.tv 353 " + nick + " = " + channel + " :" + nick);
+				write(session, ":" + nick + ".tmi.twitch.tv 366 " + nick + " " + channel + " :End of /NAMES list");
+
+				std::lock_guard<std::mutex> lock{ m_mutex };
+				++m_stats.joins;
+			}
+		}
+		else if (command == "PART"sv && session->logged_in) {
+			const std::string channel{ argument };
+			session->channels.erase(
+				std::remove(session->channels.begin(), session->channels.end(), channel),
+				session->channels.end()
+			);
+			const auto& nick = session->nick;
+			write(session, ":" + nick + "!" + nick + "@" + nick + ".tmi.twitch.tv PART " + channel);
+		}
+		else if (command == "PING"sv) {
+			write(session, ":tmi.twitch.tv PONG tmi.twitch.tv :" + std::string{ argument });
+		}
+		else if (command == "PONG"sv) {
+			std::lock_guard<std::mutex> lock{ m_mutex };
+			++m_stats.pongs;
+		}
+		else if (command == "PRIVMSG"sv) {
+			responded(argument);
+		}
+	}
+
+	void MockServer::write(const std::shared_ptr<Session>& session, std::string_view line) {
+		session->pending.append(line).append(Controller::m_delimiter);
+		write_next(session);
+	}
+
+	void MockServer::write_next(std::shared_ptr<Session> session) {
+		if (!session->writing.empty() || !session->socket.is_open()) { return; }
+		if (session->pending.empty()) {
+			if (session->closing) { close(session); }
+			return;
+		}
+
+		std::swap(session->writing, session->pending);
+		boost::asio::async_write(
+			session->socket,
+			boost::asio::buffer(session->writing),
+			[this, session](const error_code_t& error, std::size_t) {
+				session->writing.clear();
+				if (error) { return close(session); }
+
+				if (session->flooding) { pump(session); }
+				write_next(session);
+			}
+		);
+	}
+
+	// as many as the rate allows by now, at most flood_chunk ahead of the socket
+	void MockServer::pump(std::shared_ptr<Session> session) {
+		const auto& flood = session->flood;
+		const auto now = clock_t::now();
+		auto due = flood.messages;
+		if (flood.rate > 0.0) {
+			const auto elapsed = std::chrono::duration<double>(now - session->flood_start).count();
+			due = std::min(due, static_cast<std::size_t>(elapsed * flood.rate) + 1);
+		}
+
+		const auto ts = std::to_string(unix_ms());
+		std::size_t sent{ 0 };
+		while (session->flood_sent < due && session->pending.size() < flood_chunk) {
+			const auto n = session->flood_sent++;
+			const auto viewer = session->first_viewer + n;
+			const auto id = std::to_string(viewer);
+			const auto& channel = session->channels[n % session->channels.size()];
+			const bool command = flood.command_every != 0 && (n + 1) % flood.command_every == 0;
+
+			write(session,
+				"@badge-info=;badges=;color=;display-name=viewer" + id + ";emotes=;id=" + id
+				+ ";mod=0;room-id=1;subscriber=0;tmi-sent-ts=" + ts + ";turbo=0;user-id=" + id + ";user-type="
+				" :viewer" + id + "!viewer" + id + "@viewer" + id + ".tmi.twitch.tv PRIVMSG " + channel
+				+ " :" + (command ? flood.command : flood.chat)
+			);
+			++sent;
+
+			if (command) {
+				std::lock_guard<std::mutex> lock{ m_mutex };
+				m_commands.emplace(viewer, now);
+			}
+		}
+		if (sent != 0) {
+			{
+				std::lock_guard<std::mutex> lock{ m_mutex };
+				m_stats.sent += sent;
+			}
+			m_cv.notify_all();
+		}
+
+		if (session->flood_sent == flood.messages) {
+			session->flooding = false;
+			return;
+		}
+		// otherwise the socket is behind, the write handler comes back here
+		if (flood.rate > 0.0 && session->flood_sent >= due) {
+			const auto next = std::chrono::duration<double>(static_cast<double>(session->flood_sent) / flood.rate);
+			session->timer.expires_at(session->flood_start + std::chrono::duration_cast<clock_t::duration>(next));
+			session->timer.async_wait([this, session](const error_code_t& error) {
+				if (!error && session->flooding) { pump(session); }
+			});
+		}
+	}
+
+	// "#channel :@viewer42 World!", answers are matched by the viewer they name
+	void MockServer::responded(std::string_view line) {
+		const auto now = clock_t::now();
+		const auto at = line.find("viewer"sv);
+		if (at == std::string_view::npos) { return; }
+
+		std::size_t viewer{ 0 };
+		auto pos = at + "viewer"sv.size();
+		if (pos == line.size() || !std::isdigit(static_cast<unsigned char>(line[pos]))) { return; }
+		for (; pos < line.size() && std::isdigit(static_cast<unsigned char>(line[pos])); ++pos) {
+			viewer = viewer * 10 + static_cast<std::size_t>(line[pos] - '0');
+		}
+
+		std::lock_guard<std::mutex> lock{ m_mutex };
+		const auto command = m_commands.find(viewer);
+		if (command == m_commands.end()) { return; }
+
+		m_latency.record(now - command->second);
+		++m_stats.responses;
+		m_commands.erase(command);
+	}
+
+	void MockServer::close(const std::shared_ptr<Session>& session) {
+		error_code_t ignored;
+		session->socket.shutdown(socket_t::shutdown_both, ignored);
+		session->socket.close(ignored);
+		session->timer.cancel();
+		session->flooding = false;
+		m_sessions.erase(std::remove(m_sessions.begin(), m_sessions.end(), session), m_sessions.end());
+	}
+
+	std::shared_ptr<MockServer::Session> MockServer::newest() const {
+		for (auto session = m_sessions.rbegin(); session != m_sessions.rend(); ++session) {
+			if ((*session)->logged_in) { return *session; }
+		}
+		return nullptr;
+	}
+} // namespace Twitch::irc::testing
@@ -0,0 +1,112 @@
+#ifndef MOCK_SERVER_H
+#define MOCK_SERVER_H
+#include "..\Twitch_C++_IRC_bot\IRC_Bot.h"
+#include "..\Twitch_C++_IRC_bot\Metrics.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace Twitch::irc::testing {
+	/// Twitch IRC on 127.0.0.1, for end to end tests and as a load generator
+	/// speaks what Controller uses: CAP REQ, PASS/NICK, JOIN/PART, PING/PONG both ways,
+	/// RECONNECT and floods of tagged PRIVMSGs
+	/// the server runs on its own thread, every method may be called from any other
+	class MockServer
+	{
+	public:
+		using clock_t = metrics::clock_t;
+
+		struct Options
+		{
+			bool moderator{ true }; // USERSTATE after a JOIN says so, the bot gets the bigger message budget
+		};
+
+		/// tagged PRIVMSGs from "viewer<n>" over every channel the newest client joined, round robin
+		struct Flood
+		{
+			std::size_t messages{ 1000 };
+			double rate{ 0.0 };            // per second over all channels, 0 sends as fast as the client reads
+			std::size_t command_every{ 0 }; // every nth message is command instead of chat, 0 for none
+			std::string command{ "!Hello" };
+			std::string chat{ "Kappa Keepo Kappa" };
+		};
+
+		struct Stats
+		{
+			std::size_t connections{ 0 }; // accepted, reconnects included
+			std::size_t logins{ 0 };
+			std::size_t joins{ 0 };       // channels JOINed, rejoins included
+			std::size_t sent{ 0 };        // flood messages written to the socket
+			std::size_t pongs{ 0 };
+			std::size_t responses{ 0 };   // bot PRIVMSGs naming the viewer of a flood command
+			metrics::LatencyHistogram::Snapshot latency; // command sent -> response read
+		};
+
+		// "#channel0", "#channel1", ... for Controller
+		static std::vector<std::string> channel_names(std::size_t count);
+
+		MockServer(); // listens on an ephemeral port
+		explicit MockServer(Options t_options);
+		~MockServer(); // drops every connection and joins
+
+		MockServer(const MockServer&) = delete;
+		MockServer& operator=(const MockServer&) = delete;
+
+		inline std::string port() const { return std::to_string(m_port); }
+
+		void send(std::string line); // to every logged in client, without CRLF
+		void ping();                 // PING :tmi.twitch.tv to every logged in client
+		void reconnect();            // RECONNECT, then the server closes the connection
+		void disconnect();           // every connection is dropped without a word
+		void flood(Flood flood);     // to the newest logged in client, returns at once
+
+		Stats stats() const;
+		std::vector<std::string> received() const; // every line from every client, in order
+		std::vector<std::string> joined();         // channels of the newest logged in client
+
+		// false if pred didn't hold within timeout
+		bool wait_until(const std::function<bool(const Stats&)>& pred, std::chrono::milliseconds timeout) const;
+
+	private:
+		struct Session;
+
+		void accept();
+		void read(std::shared_ptr<Session> session);
+		void handle(const std::shared_ptr<Session>& session, std::string_view line);
+		void write(const std::shared_ptr<Session>& session, std::string_view line);
+		void write_next(std::shared_ptr<Session> session);
+		void pump(std::shared_ptr<Session> session); // next part of the flood
+		void responded(std::string_view line);
+		void close(const std::shared_ptr<Session>& session);
+		std::shared_ptr<Session> newest() const;
+
+		const Options m_options;
+
+		io_service_t m_io_service;
+		boost::asio::ip::tcp::acceptor m_acceptor{ m_io_service };
+		unsigned short m_port{ 0 };
+
+		// io_service thread only
+		std::vector<std::shared_ptr<Session>> m_sessions;
+		std::size_t m_room_ids{ 0 };
+		std::size_t m_viewers{ 0 }; // floods never reuse a viewer, responses stay unambiguous
+
+		metrics::LatencyHistogram m_latency;
+		mutable std::mutex m_mutex;
+		mutable std::condition_variable m_cv;
+		Stats m_stats;                      // latency aside
+		std::vector<std::string> m_received;
+		std::unordered_map<std::size_t, clock_t::time_point> m_commands; // viewer -> sent, until answered
+
+		std::thread m_thread; // last, runs with everything above
+	};
+} // namespace Twitch::irc::testing
+#endif // MOCK_SERVER_H
@@ -3,436 +3,25 @@
 #define _SCL_SECURE_NO_WARNINGS
 #include <boost\test\unit_test.hpp>
 #include "..\Twitch_C++_IRC_bot\TwitchMessage.h"
+#include "..\Twitch_C++_IRC_bot\IRC_Bot.h"
+#include "..\Twitch_C++_IRC_bot\Metrics.h"
+#include "..\Twitch_C++_IRC_bot\Logger.h"
+#include "..\Twitch_C++_IRC_bot\Capture.h"
+#include <boost\log\sources\severity_logger.hpp>
+#include <boost\make_shared.hpp>
+#include "MockServer.h"
+#include "ParserTestCases.h"
 #include <vector>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <functional>
+#include <fstream>
+#include <future>
+#include <thread>
 #include <tuple>
 #include <type_traits>
 
-// TODO: find more test cases
-
-/// Twitch doc is incorrect in many examples, test cases mixed with real world examples
-namespace doc {
-	using namespace std::string_literals;
-	
-	namespace ping {
-		using Twitch::irc::message::PING;
-		
-		const std::vector<std::pair<std::string, PING>> tests{
-			{
-				"PING :tmi.twitch.tv"s,
-				PING{ "tmi.twitch.tv"s }
-			}
-		};
-	}
-
-	namespace privmsg {
-		using Twitch::irc::message::PRIVMSG;
-		
-		const std::vector<std::pair<std::string, PRIVMSG>> tests{
-			{
-				":ronni!ronni@ronni.tmi.twitch.tv PRIVMSG #dallas :Kappa Keepo Kappa"s,
-				PRIVMSG{ "ronni"s, "tmi.twitch.tv"s, "#dallas"s, "Kappa Keepo Kappa"s }
-			}
-		};
-	}
-
-	namespace cap {
-		namespace membership {
-			namespace join {
-				using Twitch::irc::message::cap::membership::JOIN;
-
-				const std::vector<std::pair<std::string, JOIN>> tests{
-					{
-						":ronni!ronni@ronni.tmi.twitch.tv JOIN #dallas"s,
-						JOIN{ "ronni"s, "#dallas"s }
-					}
-				};
-			}
-			namespace mode {
-				using Twitch::irc::message::cap::membership::MODE;
-
-				const std::vector<std::pair<std::string, MODE>> tests{
-					{
-						":jtv MODE #dallas +o ronni"s,
-						MODE{ "#dallas"s, true, "ronni"s }
-					},
-					{
-						":jtv MODE #dallas -o ronni"s,
-						MODE{ "#dallas"s, false, "ronni"s }
-					}
-				};
-			}
-			namespace names {
-				using Twitch::irc::message::cap::membership::NAMES;
-
-				const std::vector<std::pair<std::string, NAMES>> tests{
-					{
-						":ronni.tmi.twitch.tv 353 ronni = #dallas :ronni fred wilma"s,
-						NAMES{ "ronni"s, "353"s, "#dallas"s, std::vector<std::string>{ "ronni"s, "fred"s, "wilma"s } }
-					},
-					{
-						":ronni.tmi.twitch.tv 353 ronni = #dallas :barney betty"s,
-						NAMES{ "ronni"s, "353"s, "#dallas"s, std::vector<std::string>{ "barney"s, "betty"s } }
-					},
-					{
-						":ronni.tmi.twitch.tv 366 ronni #dallas :End of /NAMES list"s,
-						NAMES{ "ronni"s, "366"s, "#dallas"s, std::vector<std::string>{} }
-					}
-				};
-			}
-			namespace part {
-				using Twitch::irc::message::cap::membership::PART;
-
-				const std::vector<std::pair<std::string, PART>> tests{
-					{
-						":ronni!ronni@ronni.tmi.twitch.tv PART #dallas"s,
-						PART{ "ronni"s, "#dallas"s }
-					}
-				};
-			}
-		}
-		namespace tags {
-			namespace clearchat {
-				using Twitch::irc::message::cap::tags::CLEARCHAT;
-
-				const std::vector<std::pair<std::string, CLEARCHAT>> tests{
-					{
-						"@ban-duration=600;room-id=99999999;"
-						"target-user-id=99999999;tmi-sent-ts=1524962471755"
-						" :tmi.twitch.tv CLEARCHAT #channel :nick"s,
-						CLEARCHAT{
-							Twitch::irc::message::cap::commands::CLEARCHAT{ "#channel"s, "nick"s },
-							std::chrono::seconds{ 600 },
-							std::nullopt,
-							"99999999"s,
-							"99999999"s,
-							std::chrono::seconds{ 1524962471755 }
-						}
-					},
-					{
-						"@ban-duration=1;ban-reason=test;room-id=99999999;"
-						"target-user-id=99999999;tmi-sent-ts=1525028799009"
-						" :tmi.twitch.tv CLEARCHAT #channel :nick"s,
-						CLEARCHAT{
-							Twitch::irc::message::cap::commands::CLEARCHAT{ "#channel"s, "nick"s },
-							std::chrono::seconds{ 1 },
-							"test"s,
-							"99999999"s,
-							"99999999"s,
-							std::chrono::seconds{ 1525028799009 }
-						}
-					}
-				};
-			}
-			namespace globaluserstate {
-				using Twitch::irc::message::cap::tags::GLOBALUSERSTATE;
-				using Twitch::irc::parameters::Color;
-				using Twitch::irc::parameters::NoColor;
-
-				const std::vector<std::pair<std::string, GLOBALUSERSTATE>> tests{
-					{
-						"@badges=;color=#0000FF;display-name=Name;"
-						"emote-sets=0,33563;user-id=99999999;user-type="
-						" :tmi.twitch.tv GLOBALUSERSTATE"s,
-						GLOBALUSERSTATE{
-							{}, Color{ 0x00, 0x00, 0xFF }, "Name"s, "0,33563"s,
-							"99999999"s, Twitch::irc::message::cap::tags::UserType::empty
-						}
-					}
-				};
-			}
-			namespace privmsg {
-				using Twitch::irc::message::cap::tags::PRIVMSG;
-				using Twitch::irc::parameters::Color;
-				using Twitch::irc::parameters::NoColor;
-				using Twitch::irc::parameters::Badge;
-				using Twitch::irc::parameters::UserType;
-				
-				const std::vector<std::pair<std::string, PRIVMSG>> tests{
-					{
-						"@badges=staff/1,bits/1000;bits=100;color=;display-name=dallas;"
-						"emotes=;id=b34ccfc7-4977-403a-8a94-33c6bac34fb8;"
-						"mod=0;room-id=1337;subscriber=0;tmi-sent-ts=1507246572675;"
-						"turbo=1;user-id=1337;user-type=staff"
-						" :ronni!ronni@ronni.tmi.twitch.tv PRIVMSG #dallas :cheer100"s,
-						PRIVMSG{
-							Twitch::irc::message::PRIVMSG{ "ronni"s, "tmi.twitch.tv"s, "#dallas"s, "cheer100"s },
-							{ { Badge::staff, 1 }, { Badge::bits, 1000 } }, 100, NoColor{}, "dallas"s,
-							false, ""s, "b34ccfc7-4977-403a-8a94-33c6bac34fb8"s,
-							false, "1337"s, false, std::chrono::seconds{ 1507246572675 },
-							true, "1337"s, UserType::staff
-						}
-					},
-					{
-						"@badges=broadcaster/1;color=#0000FF;display-name=Nick;"
-						"emote-only=1;emotes=25:0-4,12-16/1902:6-10;id=99999999-9999-9999-9999-999999999999;"
-						"mod=0;room-id=99999999;subscriber=0;tmi-sent-ts=1526424153891;"
-						"turbo=0;user-id=99999999;user-type="
-						" :user!user@user.tmi.twitch.tv PRIVMSG #channel :Kappa Keepo Kappa"s,
-						PRIVMSG{
-							Twitch::irc::message::PRIVMSG{ "user"s, "tmi.twitch.tv"s, "#channel"s, "Kappa Keepo Kappa"s },
-							{ { Badge::broadcaster, 1 } }, 0, Color{ 0x00, 0x00, 0xFF }, "Nick"s,
-							true, "25:0-4,12-16/1902:6-10"s, "99999999-9999-9999-9999-999999999999"s,
-							false, "99999999"s, false, std::chrono::seconds{ 1526424153891 },
-							false, "99999999"s, UserType::empty
-						}
-					}
-				};
-			}
-			namespace roomstate {
-				using Twitch::irc::message::cap::tags::ROOMSTATE;
-
-				const std::vector<std::pair<std::string, ROOMSTATE>> tests{
-					{
-						"@broadcaster-lang=;emote-only=0;followers-only=-1;"
-						"r9k=0;rituals=0;room-id=99999999;slow=0;subs-only=0"
-						" :tmi.twitch.tv ROOMSTATE #channel"s,
-						ROOMSTATE{
-							Twitch::irc::message::cap::commands::ROOMSTATE{ "#channel"s },
-							std::nullopt, false, -1, false, "0"s, "99999999"s, std::chrono::seconds{ 0 }, false
-						}
-					},
-					{
-						"@room-id=99999999;slow=10 :tmi.twitch.tv ROOMSTATE #channel",
-						ROOMSTATE{
-							Twitch::irc::message::cap::commands::ROOMSTATE{ "#channel"s },
-							std::nullopt, std::nullopt, std::nullopt, std::nullopt, std::nullopt, "99999999"s,
-							std::chrono::seconds{ 10 }, std::nullopt
-						}
-					},
-					{
-						"@room-id=99999999;slow=0 :tmi.twitch.tv ROOMSTATE #channel"s,
-						ROOMSTATE{
-							Twitch::irc::message::cap::commands::ROOMSTATE{ "#channel"s },
-							std::nullopt, std::nullopt, std::nullopt, std::nullopt, std::nullopt,
-							"99999999"s, std::chrono::seconds{ 0 }, std::nullopt
-						}
-					},
-					{
-						"@followers-only=30;room-id=99999999"
-						" :tmi.twitch.tv ROOMSTATE #channel"s,
-						ROOMSTATE{
-							Twitch::irc::message::cap::commands::ROOMSTATE{ "#channel"s },
-							std::nullopt, std::nullopt, 30, std::nullopt, std::nullopt,
-							"99999999"s, std::nullopt, std::nullopt
-						}
-					},
-					{
-						"@followers-only=-1;room-id=99999999"
-						" :tmi.twitch.tv ROOMSTATE #channel"s,
-						ROOMSTATE{
-							Twitch::irc::message::cap::commands::ROOMSTATE{ "#channel"s },
-							std::nullopt, std::nullopt, -1, std::nullopt, std::nullopt,
-							"99999999"s, std::nullopt, std::nullopt
-						}
-					}
-				};
-			}
-			namespace usernotice {
-				using Twitch::irc::message::cap::tags::USERNOTICE;
-				using Twitch::irc::parameters::Color;
-				using Twitch::irc::parameters::NoColor;
-				using Twitch::irc::parameters::Badge;
-				using Twitch::irc::parameters::UserType;
-
-				const std::vector<std::pair<std::string, USERNOTICE>> tests{
-					{
-						"@badges=staff/1,broadcaster/1,turbo/1;color=#008000;display-name=ronni;"
-						"emotes=;id=db25007f-7a18-43eb-9379-80131e44d633;login=ronni;"
-						"mod=0;msg-id=resub;msg-param-months=6;msg-param-sub-plan=Prime;"
-						"msg-param-sub-plan-name=Prime;room-id=1337;subscriber=1;"
-						R"(system-msg=ronni\shas\ssubscribed\sfor\s6\smonths!;)"
-						"tmi-sent-ts=1507246572675;turbo=1;user-id=1337;user-type=staff"
-						" :tmi.twitch.tv USERNOTICE #dallas :Great stream -- keep it up!"s,
-						USERNOTICE{
-							Twitch::irc::message::cap::commands::USERNOTICE{
-								"#dallas"s, "Great stream -- keep it up!"s
-							},
-							{ {Badge::staff, 1}, {Badge::broadcaster, 1}, {Badge::turbo, 1} },
-							Color{ 0x00, 0x80, 0x00 }, "ronni"s, ""s, "db25007f-7a18-43eb-9379-80131e44d633"s,
-							"ronni"s, false, USERNOTICE::Sub{ 6, "Prime"s, "Prime"s }, "1337"s,
-							true, "ronni has subscribed for 6 months!"s,
-							std::chrono::seconds{ 1507246572675 }, true, "1337"s, UserType::staff
-						}
-					},
-					{
-						"@badges=staff/1,premium/1;color=#0000FF;display-name=TWW2;"
-						"emotes=;id=e9176cd8-5e22-4684-ad40-ce53c2561c5e;login=tww2;"
-						"mod=0;msg-id=subgift;msg-param-months=1;"
-						"msg-param-recipient-display-name=Mr_Woodchuck;"
-						"msg-param-recipient-id=89614178;msg-param-recipient-name=mr_woodchuck;"
-						R"(msg-param-sub-plan-name=House\sof\sNyoro~n;msg-param-sub-plan=1000;)"
-						"room-id=19571752;subscriber=0;"
-						R"(system-msg=TWW2\sgifted\sa\sTier\s1\ssub\sto\sMr_Woodchuck!;)"
-						"tmi-sent-ts=1521159445153;turbo=0;user-id=13405587;"
-						"user-type=staff :tmi.twitch.tv USERNOTICE #forstycup"s,
-						USERNOTICE{
-							Twitch::irc::message::cap::commands::USERNOTICE{
-								"#forstycup"s, ""s
-							},
-							// premium badge - wtf??? doc don't say a word about it
-							{ {Badge::staff, 1}, {Badge::unhandled_badge, 1} },
-							Color{ 00, 00, 0xFF }, "TWW2"s, ""s, "e9176cd8-5e22-4684-ad40-ce53c2561c5e"s,
-							"tww2"s, false,
-							USERNOTICE::Subgift{
-								1, "Mr_Woodchuck"s, "89614178"s, "mr_woodchuck"s,
-								"House of Nyoro~n"s, "1000"s
-							}, "19571752"s, false, "TWW2 gifted a Tier 1 sub to Mr_Woodchuck!"s,
-							std::chrono::seconds{ 1521159445153 }, false, "13405587"s, UserType::staff
-						}
-					},
-					{
-						"@badges=turbo/1;color=#9ACD32;display-name=TestChannel;emotes=;"
-						"id=3d830f12-795c-447d-af3c-ea05e40fbddb;login=testchannel;mod=0;"
-						"msg-id=raid;msg-param-displayName=TestChannel;msg-param-login=testchannel;"
-						"msg-param-viewerCount=15;room-id=56379257;subscriber=0;"
-						R"(system-msg=15\sraiders\sfrom\sTestChannel\shave\sjoined\n!;)"
-						"tmi-sent-ts=1507246572675;turbo=1;user-id=123456;user-type="
-						" :tmi.twitch.tv USERNOTICE #othertestchannel"s,
-						USERNOTICE{
-							Twitch::irc::message::cap::commands::USERNOTICE{
-								"#othertestchannel"s, ""s
-							},
-							{ {Badge::turbo, 1} },
-							Color{ 0x9A, 0xCD, 0x32 }, "TestChannel"s, ""s, "3d830f12-795c-447d-af3c-ea05e40fbddb"s,
-							"testchannel"s, false,
-							USERNOTICE::Raid{
-								"TestChannel"s, "testchannel"s,  15
-							}, "56379257"s, false, R"(15 raiders from TestChannel have joined\n!)"s,
-							std::chrono::seconds{ 1507246572675 }, true, "123456"s, UserType::empty
-						}
-					},
-					{
-						"@badges=;color=;display-name=SevenTest1;emotes=30259:0-6;"
-						"id=37feed0f-b9c7-4c3a-b475-21c6c6d21c3d;login=seventest1;"
-						"mod=0;msg-id=ritual;msg-param-ritual-name=new_chatter;"
-						R"(room-id=6316121;subscriber=0;system-msg=Seventoes\sis\snew\shere!;)"
-						"tmi-sent-ts=1508363903826;turbo=0;user-id=131260580;"
-						"user-type= :tmi.twitch.tv USERNOTICE #seventoes :HeyGuys"s,
-						USERNOTICE{
-							Twitch::irc::message::cap::commands::USERNOTICE{
-								"#seventoes"s, "HeyGuys"s
-							},
-							{}, NoColor{},
-							"SevenTest1"s, "30259:0-6"s, "37feed0f-b9c7-4c3a-b475-21c6c6d21c3d"s,
-							"seventest1"s, false,
-							USERNOTICE::Ritual{},
-							"6316121"s, false, "Seventoes is new here!"s,
-							std::chrono::seconds{ 1508363903826 }, false, "131260580"s, UserType::empty
-						}
-					}
-				};
-			}
-			namespace userstate {
-				using Twitch::irc::message::cap::tags::USERSTATE;
-				using Twitch::irc::parameters::Color;
-				using Twitch::irc::parameters::Badge;
-				using Twitch::irc::parameters::UserType;
-
-				const std::vector<std::pair<std::string, USERSTATE>> tests{
-					{
-						"@badges=broadcaster/1;color=#0000FF;"
-						"display-name=Nick;emote-sets=0,33563;"
-						"mod=0;subscriber=0;user-type="
-						" :tmi.twitch.tv USERSTATE #channel"s,
-						USERSTATE{
-							Twitch::irc::message::cap::commands::USERSTATE{ "#channel"s },
-							{ {Badge::broadcaster, 1} }, Color{ 00, 00, 0xFF}, "Nick"s, "0,33563"s,
-							false, false, UserType::empty
-						}
-					}
-				};
-			}
-		}
-		namespace commands {
-			namespace clearchat {
-				using Twitch::irc::message::cap::commands::CLEARCHAT;
-
-				const std::vector<std::pair<std::string, CLEARCHAT>> tests{
-					{
-						":tmi.twitch.tv CLEARCHAT #dallas"s,
-						CLEARCHAT{ "#dallas"s, ""s }
-					},
-					{
-						":tmi.twitch.tv CLEARCHAT #<channel> :<user>"s,
-						CLEARCHAT{ "#<channel>"s, "<user>"s }
-					}
-				};
-			}
-			namespace hosttarget {
-				using Twitch::irc::message::cap::commands::HOSTTARGET;
-
-				// TODO: find more rwe
-				const std::vector<std::pair<std::string, HOSTTARGET>> tests{
-					{
-						":tmi.twitch.tv HOSTTARGET #hosting_channel <channel> [0]"s,
-						HOSTTARGET{ "#hosting_channel"s, "<channel>"s, 0 }
-					},
-					{
-						":tmi.twitch.tv HOSTTARGET #hosting :channel -"s,
-						HOSTTARGET{ "#hosting"s, "channel"s, 0 }
-					},
-					{
-						":tmi.twitch.tv HOSTTARGET #hosting_channel :- [0]"s,
-						HOSTTARGET{ "#hosting_channel"s, ""s, 0 }
-					}
-				};
-			}
-			namespace notice {
-				using Twitch::irc::message::cap::commands::NOTICE;
-
-				const std::vector<std::pair<std::string, NOTICE>> tests{
-					{
-						"@msg-id=slow_off :tmi.twitch.tv NOTICE"
-						" #dallas :This room is no longer in slow mode."s,
-						NOTICE{ "slow_off"s, "#dallas"s, "This room is no longer in slow mode."s }
-					}
-				};
-			}
-			namespace reconnect {
-				using Twitch::irc::message::cap::commands::RECONNECT;
-
-				const std::vector<std::pair<std::string, RECONNECT>> tests{
-					{
-						":tmi.twitch.tv RECONNECT"s,
-						RECONNECT{}
-					}
-				};
-			}
-			namespace roomstate {
-				using Twitch::irc::message::cap::commands::ROOMSTATE;
-
-				const std::vector<std::pair<std::string, ROOMSTATE>> tests{
-					{
-						":tmi.twitch.tv ROOMSTATE #<channel>"s,
-						ROOMSTATE{ "#<channel>"s }
-					}
-				};
-			}
-			namespace usernotice {
-				using Twitch::irc::message::cap::commands::USERNOTICE;
-
-				const std::vector<std::pair<std::string, USERNOTICE>> tests{
-					{
-						":tmi.twitch.tv USERNOTICE #<channel> :message"s,
-						USERNOTICE{ "#<channel>"s, "message"s }
-					}
-				};
-			}
-			namespace userstate {
-				using Twitch::irc::message::cap::commands::USERSTATE;
-
-				const std::vector<std::pair<std::string, USERSTATE>> tests{
-					{
-						":tmi.twitch.tv USERSTATE #<channel>"s,
-						USERSTATE{ "#<channel>"s }
-					}
-				};
-			}
-		}
-	}
-}
-
 namespace {
 	namespace message = Twitch::irc::message;
 	namespace message_doc = doc;
@@ -581,6 +170,1581 @@ namespace {
 		match_impl<M, tags::USERSTATE>(tags_doc::userstate::tests);
 	}
 	
+	// MessageParser::process must dispatch to the same alternative as M::is
+	template<class Message_t>
+	void process_impl(const std::vector<std::pair<std::string, Message_t>>& tests) {
+		message::MessageParser parser;
+		for (const auto& [raw_message, parsed] : tests) {
+			using namespace std::string_literals;
+			for (const auto& line : { raw_message, raw_message + "\r"s, raw_message + "\r\n"s }) {
+				const auto result = parser.process(line);
+				const auto* tp = message::get_parsed<Message_t>(result);
+				BOOST_CHECK(tp != nullptr && *tp == parsed);
+
+				// the prefilter has to see the same command the tokenizer does
+				BOOST_CHECK(message::TokenizedMessage::command_of(line) == message::TokenizedMessage::tokenize(line)->command);
+			}
+		}
+	}
+
+	struct process_details {
+		static void process_PING()            { process_impl(message_doc::ping::tests);                }
+		static void process_HOSTTARGET()      { process_impl(commands_doc::hosttarget::tests);         }
+		static void process_NOTICE()          { process_impl(commands_doc::notice::tests);             }
+		static void process_RECONNECT()       { process_impl(commands_doc::reconnect::tests);          }
+		static void process_JOIN()            { process_impl(membership_doc::join::tests);             }
+		static void process_MODE()            { process_impl(membership_doc::mode::tests);             }
+		static void process_NAMES()           { process_impl(membership_doc::names::tests);            }
+		static void process_PART()            { process_impl(membership_doc::part::tests);             }
+		static void process_CLEARCHAT()       { process_impl(tags_doc::clearchat::tests);              }
+		static void process_GLOBALUSERSTATE() { process_impl(tags_doc::globaluserstate::tests);        }
+		static void process_PRIVMSG()         { process_impl(tags_doc::privmsg::tests);                }
+		static void process_ROOMSTATE()       { process_impl(tags_doc::roomstate::tests);              }
+		static void process_USERNOTICE()      { process_impl(tags_doc::usernotice::tests);             }
+		static void process_USERSTATE()       { process_impl(tags_doc::userstate::tests);              }
+
+		// tag order isn't fixed and twitch keeps adding new ones
+		static void process_PRIVMSG_unordered_tags() {
+			using namespace std::string_literals;
+			const auto line =
+				"@badge-info=;client-nonce=0c5e2f;user-type=staff;turbo=1;badges=staff/1,bits/1000;"
+				"bits=100;color=;display-name=dallas;emotes=;flags=;id=b34ccfc7-4977-403a-8a94-33c6bac34fb8;"
+				"mod=0;reply-parent-msg-id=1;room-id=1337;subscriber=0;tmi-sent-ts=1507246572675;user-id=1337"
+				" :ronni!ronni@ronni.tmi.twitch.tv PRIVMSG #dallas :cheer100"s;
+
+			message::MessageParser parser;
+			const auto result = parser.process(line);
+			const auto* privmsg = message::get_parsed<tags::PRIVMSG>(result);
+			BOOST_CHECK(privmsg != nullptr && *privmsg == tags_doc::privmsg::tests.front().second);
+		}
+
+		// a released message hands its block to the next one of the same type
+		static void pooled_storage_reused() {
+			message::MessageParser parser;
+			const auto& line = tags_doc::privmsg::tests.front().first;
+
+			const void* first{ nullptr };
+			{
+				const auto result = parser.process(line);
+				first = message::get_parsed<tags::PRIVMSG>(result);
+				BOOST_REQUIRE(first != nullptr);
+			}
+			const auto result = parser.process(line);
+			BOOST_CHECK(message::get_parsed<tags::PRIVMSG>(result) == first);
+			BOOST_CHECK(message::get_parsed<membership::JOIN>(result) == nullptr);
+		}
+
+		// text parsed inside a batch comes from its arena, copies don't
+		static void batch_arena_text() {
+			const auto& test = tags_doc::privmsg::tests.front();
+			message::MessageParser parser;
+
+			Twitch::irc::BatchArena arena;
+			std::optional<tags::PRIVMSG> copy;
+			{
+				Twitch::irc::BatchArena::Scope batch{ arena };
+				BOOST_CHECK(Twitch::irc::BatchArena::current() == &arena);
+
+				const auto result = parser.process(test.first);
+				const auto* privmsg = message::get_parsed<tags::PRIVMSG>(result);
+				BOOST_REQUIRE(privmsg != nullptr);
+				BOOST_CHECK(*privmsg->message.get_allocator().resource() == *arena.get());
+
+				copy.emplace(*privmsg);
+				BOOST_CHECK(*copy->message.get_allocator().resource() == *std::pmr::get_default_resource());
+			}
+			BOOST_CHECK(Twitch::irc::BatchArena::current() == nullptr);
+			BOOST_CHECK(*copy == test.second);
+		}
+
+		// the list of names and every name in it
+		static void batch_arena_names() {
+			const auto& test = membership_doc::names::tests.front();
+			message::MessageParser parser;
+
+			Twitch::irc::BatchArena arena;
+			Twitch::irc::BatchArena::Scope batch{ arena };
+			const auto result = parser.process(test.first);
+			const auto* names = message::get_parsed<membership::NAMES>(result);
+			BOOST_REQUIRE(names != nullptr);
+			BOOST_REQUIRE(!names->names.empty());
+			BOOST_CHECK(*names->names.get_allocator().resource() == *arena.get());
+			BOOST_CHECK(*names->names.front().get_allocator().resource() == *arena.get());
+			BOOST_CHECK(*names == test.second);
+		}
+
+		// the cap::commands base and the optional text of a derived tag type stay on the arena too
+		static void batch_arena_roomstate() {
+			const auto& test = tags_doc::roomstate::tests.front();
+			message::MessageParser parser;
+
+			Twitch::irc::BatchArena arena;
+			Twitch::irc::BatchArena::Scope batch{ arena };
+
+			const auto result = parser.process(test.first);
+			const auto* roomstate = message::get_parsed<tags::ROOMSTATE>(result);
+			BOOST_REQUIRE(roomstate != nullptr);
+			BOOST_REQUIRE(roomstate->rituals.has_value());
+			BOOST_CHECK(*roomstate->channel.get_allocator().resource() == *arena.get());
+			BOOST_CHECK(*roomstate->rituals->get_allocator().resource() == *arena.get());
+			BOOST_CHECK(*roomstate->room_id.get_allocator().resource() == *arena.get());
+			BOOST_CHECK(*roomstate == test.second);
+		}
+
+		// trace-only kinds are skipped unless their trace records are compiled in
+		static void visitor_subscription() {
+			const auto subscription = message::ParserVisitor::subscription();
+			const auto notice = message::MessageParser::route("NOTICE").value();
+
+			BOOST_CHECK(subscription.contains(message::MessageParser::route("PRIVMSG").value()));
+			BOOST_CHECK_EQUAL(subscription.contains(notice), Logger::enabled(boost::log::trivial::trace));
+			BOOST_CHECK_EQUAL(subscription.is_all(), Logger::enabled(boost::log::trivial::trace));
+		}
+
+		// unsubscribed kinds are counted, subscribed ones parse as usual
+		static void subscription_skips_lines() {
+			message::MessageParser parser{ message::Subscription::of<tags::PRIVMSG, message::PING>() };
+			BOOST_CHECK(!parser.subscription().is_all());
+
+			const auto& join = membership_doc::join::tests.front().first;
+			const auto join_which = message::MessageParser::route("JOIN").value();
+			for (int i{ 0 }; i < 3; ++i) {
+				const auto result = parser.process(join);
+				const auto* skipped = message::get_parsed<message::Skipped>(result);
+				BOOST_REQUIRE(skipped != nullptr);
+				BOOST_CHECK_EQUAL(skipped->which, join_which);
+			}
+			BOOST_CHECK(message::get_parsed<message::Skipped>(parser.process(tags_doc::userstate::tests.front().first)) != nullptr);
+			BOOST_CHECK_EQUAL(parser.skipped(join_which), 3u);
+			BOOST_CHECK_EQUAL(parser.skipped(), 4u);
+
+			const auto& privmsg = tags_doc::privmsg::tests.front();
+			const auto result = parser.process(privmsg.first);
+			const auto* parsed = message::get_parsed<tags::PRIVMSG>(result);
+			BOOST_CHECK(parsed != nullptr && *parsed == privmsg.second);
+			BOOST_CHECK(message::get_parsed<message::PING>(parser.process("PING :tmi.twitch.tv")) != nullptr);
+
+			// unknown commands aren't a kind, they still come back as errors
+			BOOST_CHECK(message::get_parsed<message::ParseError>(parser.process(":tmi.twitch.tv 001 ronni :Welcome")) != nullptr);
+			BOOST_CHECK_EQUAL(parser.skipped(), 4u);
+
+			BOOST_CHECK(message::Subscription::all().contains(join_which));
+			BOOST_CHECK(!message::Subscription::all().contains(0));
+		}
+
+		// every parsed type routes its own keywords to its own result_t alternative
+		static void route_parsed_types() {
+			int which{ 1 }; // 0 is ParseError
+			message::for_each_type(message::parsed_types_t{}, [&](auto tag) {
+				using Message_t = typename decltype(tag)::type;
+				for (const auto keyword : Message_t::keywords) {
+					BOOST_CHECK(message::MessageParser::route(keyword) == which);
+				}
+				++which;
+			});
+			BOOST_CHECK_EQUAL(which, static_cast<int>(message::parsed_types_t::size) + 1);
+
+			BOOST_CHECK(!message::MessageParser::route("001").has_value());
+			BOOST_CHECK(!message::MessageParser::route("privmsg").has_value());
+			BOOST_CHECK(!message::MessageParser::route("").has_value());
+		}
+
+		static void tag_index_overflow() {
+			std::string raw;
+			for (std::size_t i{ 0 }; i < message::TagIndex::inline_capacity + 8; ++i) {
+				raw += "key" + std::to_string(i) + "=" + std::to_string(i) + ";";
+			}
+			raw += "flag";
+
+			const message::TagIndex index{ raw };
+			BOOST_CHECK_EQUAL(index.size(), message::TagIndex::inline_capacity + 9);
+			BOOST_CHECK(index.find("key0").value() == "0");
+			BOOST_CHECK(index.find("key39").value() == "39");
+			BOOST_CHECK(index.find("flag").value().empty());
+			BOOST_CHECK(!index.find("key").has_value());
+		}
+	};
+
+	auto* process_suite(const std::string& suite_name) {
+		auto* suite = BOOST_TEST_SUITE(std::move(suite_name));
+
+		suite->add( BOOST_TEST_CASE( &process_details::process_PING            ) );
+		suite->add( BOOST_TEST_CASE( &process_details::process_HOSTTARGET      ) );
+		suite->add( BOOST_TEST_CASE( &process_details::process_NOTICE          ) );
+		suite->add( BOOST_TEST_CASE( &process_details::process_RECONNECT       ) );
+		suite->add( BOOST_TEST_CASE( &process_details::process_JOIN            ) );
+		suite->add( BOOST_TEST_CASE( &process_details::process_MODE            ) );
+		suite->add( BOOST_TEST_CASE( &process_details::process_NAMES           ) );
+		suite->add( BOOST_TEST_CASE( &process_details::process_PART            ) );
+		suite->add( BOOST_TEST_CASE( &process_details::process_CLEARCHAT       ) );
+		suite->add( BOOST_TEST_CASE( &process_details::process_GLOBALUSERSTATE ) );
+		suite->add( BOOST_TEST_CASE( &process_details::process_PRIVMSG         ) );
+		suite->add( BOOST_TEST_CASE( &process_details::process_PRIVMSG_unordered_tags ) );
+		suite->add( BOOST_TEST_CASE( &process_details::tag_index_overflow      ) );
+		suite->add( BOOST_TEST_CASE( &process_details::route_parsed_types      ) );
+		suite->add( BOOST_TEST_CASE( &process_details::pooled_storage_reused   ) );
+		suite->add( BOOST_TEST_CASE( &process_details::batch_arena_text        ) );
+		suite->add( BOOST_TEST_CASE( &process_details::batch_arena_roomstate   ) );
+		suite->add( BOOST_TEST_CASE( &process_details::batch_arena_names       ) );
+		suite->add( BOOST_TEST_CASE( &process_details::visitor_subscription     ) );
+		suite->add( BOOST_TEST_CASE( &process_details::subscription_skips_lines ) );
+		suite->add( BOOST_TEST_CASE( &process_details::process_ROOMSTATE       ) );
+		suite->add( BOOST_TEST_CASE( &process_details::process_USERNOTICE      ) );
+		suite->add( BOOST_TEST_CASE( &process_details::process_USERSTATE       ) );
+
+		return suite;
+	}
+
+	// view::M::is(...).to_owned() must be equal to owning M::is(...)
+	template<class View_t, class Message_t>
+	void view_impl(const std::vector<std::pair<std::string, Message_t>>& tests) {
+		for (const auto& [raw_message, parsed] : tests) {
+			const auto tp = View_t::is(raw_message);
+			BOOST_CHECK(tp.has_value() && tp->to_owned() == parsed);
+		}
+	}
+
+	struct view_details {
+		static void view_PING()    { view_impl<message::view::PING>(message_doc::ping::tests);       }
+		static void view_JOIN()    { view_impl<message::view::JOIN>(membership_doc::join::tests);    }
+		static void view_PART()    { view_impl<message::view::PART>(membership_doc::part::tests);    }
+		static void view_PRIVMSG() { view_impl<message::view::PRIVMSG>(tags_doc::privmsg::tests);    }
+
+		// raw line is not tagged, tagged view must reject it
+		static void view_PRIVMSG_untagged() {
+			for (const auto& test : message_doc::privmsg::tests) {
+				BOOST_CHECK(!message::view::PRIVMSG::is(test.first).has_value());
+			}
+		}
+	};
+
+	auto* view_suite(const std::string& suite_name) {
+		auto* suite = BOOST_TEST_SUITE(std::move(suite_name));
+
+		suite->add( BOOST_TEST_CASE( &view_details::view_PING             ) );
+		suite->add( BOOST_TEST_CASE( &view_details::view_JOIN             ) );
+		suite->add( BOOST_TEST_CASE( &view_details::view_PART             ) );
+		suite->add( BOOST_TEST_CASE( &view_details::view_PRIVMSG          ) );
+		suite->add( BOOST_TEST_CASE( &view_details::view_PRIVMSG_untagged ) );
+
+		return suite;
+	}
+
+	struct badges_details {
+		static void parse_levels() {
+			using Twitch::irc::parameters::Badges;
+			const auto& test = tags_doc::privmsg::tests[0];
+			const auto msg = tags::PRIVMSG::is(test.first);
+			BOOST_REQUIRE(msg.has_value());
+
+			BOOST_CHECK_EQUAL(msg->badges.size(), 2);
+			BOOST_CHECK(msg->badges.contains(tags::Badge::staff));
+			BOOST_CHECK(msg->badges.level(tags::Badge::bits) == 1000);
+			BOOST_CHECK(!msg->badges.level(tags::Badge::moderator).has_value());
+			BOOST_CHECK(msg->badges == (Badges{ { tags::Badge::bits, 1000 }, { tags::Badge::staff, 1 } }));
+		}
+
+		// unknown badges collapse into one slot, first level is kept
+		static void unhandled_badges() {
+			using Twitch::irc::parameters::Badges;
+			Badges badges{ { tags::Badge::unhandled_badge, 1 } };
+			BOOST_CHECK(!badges.insert(tags::Badge::unhandled_badge, 7));
+			BOOST_CHECK(badges.level(tags::Badge::unhandled_badge) == 1);
+			BOOST_CHECK_EQUAL(badges.size(), 1);
+		}
+
+		static void privileges_level() {
+			using Twitch::irc::parameters::UserPrivilegesLevel;
+			const auto level_of = [](const std::string& raw) {
+				return tags::PRIVMSG::is(raw)->get_privileges_level();
+			};
+			const auto line = [](const std::string& badges) {
+				return "@badges=" + badges + ";color=;display-name=a;emotes=;id=1;mod=0;room-id=1;"
+					"subscriber=0;tmi-sent-ts=1;turbo=0;user-id=1;user-type= :a!a@a.tmi.twitch.tv PRIVMSG #a :hi";
+			};
+
+			BOOST_CHECK(level_of(line("")) == UserPrivilegesLevel::normal);
+			BOOST_CHECK(level_of(line("premium/1")) == UserPrivilegesLevel::normal);
+			BOOST_CHECK(level_of(line("subscriber/12")) == UserPrivilegesLevel::subscriber);
+			BOOST_CHECK(level_of(line("subscriber/12,moderator/1")) == UserPrivilegesLevel::moderator);
+			BOOST_CHECK(level_of(line("moderator/1,broadcaster/1")) == UserPrivilegesLevel::broadcaster);
+		}
+	};
+
+	auto* badges_suite(const std::string& suite_name) {
+		auto* suite = BOOST_TEST_SUITE(std::move(suite_name));
+
+		suite->add( BOOST_TEST_CASE( &badges_details::parse_levels     ) );
+		suite->add( BOOST_TEST_CASE( &badges_details::unhandled_badges ) );
+		suite->add( BOOST_TEST_CASE( &badges_details::privileges_level ) );
+
+		return suite;
+	}
+
+	struct numeric_details {
+		static void parse_integers() {
+			using namespace std::string_view_literals;
+			namespace params = Twitch::irc::parameters;
+
+			BOOST_CHECK(params::parse_integer<unsigned int>("100"sv).value == 100u);
+			BOOST_CHECK(params::parse_integer<int>("-1"sv).value == -1); // followers-only off
+			BOOST_CHECK(params::parse_integer<int>(""sv).error == params::ParseError::empty);
+			BOOST_CHECK(params::parse_integer<int>("10s"sv).error == params::ParseError::invalid);
+			BOOST_CHECK(params::parse_integer<int>(" 10"sv).error == params::ParseError::invalid);
+			BOOST_CHECK(params::parse_integer<unsigned int>("-5"sv).error == params::ParseError::invalid);
+			BOOST_CHECK(params::parse_integer<int>("99999999999"sv).error == params::ParseError::out_of_range);
+			BOOST_CHECK(params::parse_seconds("1507246572675"sv).value == params::timestamp_t{ 1507246572675 });
+		}
+
+		static void parse_colors() {
+			using namespace std::string_view_literals;
+			namespace params = Twitch::irc::parameters;
+
+			BOOST_CHECK(params::Color::from_string("#9ACD32"sv).value == (params::Color{ 0x9A, 0xCD, 0x32 }));
+			BOOST_CHECK(params::Color::from_string("#9acd32"sv).value == (params::Color{ 0x9A, 0xCD, 0x32 }));
+			BOOST_CHECK(params::Color::from_string(""sv).error == params::ParseError::empty);
+			BOOST_CHECK(params::Color::from_string("#9ACD3"sv).error == params::ParseError::invalid);
+			BOOST_CHECK(params::Color::from_string("9ACD32F"sv).error == params::ParseError::invalid);
+			BOOST_CHECK(params::Color::from_string("#9ACG32"sv).error == params::ParseError::invalid);
+		}
+	};
+
+	auto* numeric_suite(const std::string& suite_name) {
+		auto* suite = BOOST_TEST_SUITE(std::move(suite_name));
+
+		suite->add( BOOST_TEST_CASE( &numeric_details::parse_integers ) );
+		suite->add( BOOST_TEST_CASE( &numeric_details::parse_colors   ) );
+
+		return suite;
+	}
+
+	struct scanner_details {
+		// vector paths have to agree with the byte loop at every offset, tails included
+		static void block_mask_matches_scalar() {
+			using message::StructuralScanner;
+			std::string line;
+			for (const auto& test : tags_doc::usernotice::tests) { line += test.first + "\r\n"; }
+
+			for (std::size_t size : { std::size_t{ 0 }, std::size_t{ 1 }, std::size_t{ 63 }, std::size_t{ 64 }, std::size_t{ 65 }, line.size() }) {
+				const std::string_view raw{ line.data(), size };
+				for (std::size_t offset{ 0 }; offset < raw.size() + 2; ++offset) {
+					BOOST_CHECK_EQUAL(
+						StructuralScanner::block_mask(raw, offset),
+						StructuralScanner::block_mask_scalar(raw, offset)
+					);
+				}
+			}
+			BOOST_TEST_MESSAGE("block_mask: " << StructuralScanner::implementation());
+		}
+
+		// next() hands out every structural byte once, in order
+		static void positions_in_order() {
+			const auto& line = tags_doc::privmsg::tests.front().first;
+			message::StructuralScanner scanner{ line };
+
+			std::vector<std::size_t> expected;
+			for (std::size_t i{ 0 }; i < line.size(); ++i) {
+				if (std::string_view{ " ;=:\r\n" }.find(line[i]) != std::string_view::npos) { expected.push_back(i); }
+			}
+			std::vector<std::size_t> found;
+			for (auto pos = scanner.next(); pos != message::StructuralScanner::npos; pos = scanner.next()) { found.push_back(pos); }
+
+			BOOST_CHECK_EQUAL_COLLECTIONS(found.begin(), found.end(), expected.begin(), expected.end());
+		}
+
+		static void lowest_bit() {
+			for (unsigned bit{ 0 }; bit < 64; ++bit) {
+				const auto mask = std::uint64_t{ 1 } << bit;
+				BOOST_CHECK_EQUAL(message::StructuralScanner::lowest_bit(mask), bit);
+				BOOST_CHECK_EQUAL(message::StructuralScanner::lowest_bit(mask | (mask << 1)), bit);
+			}
+		}
+
+		// tags split while tokenizing have to match a TagIndex split on first lookup
+		static void tokenized_tags_match_lazy() {
+			std::string tags;
+			for (std::size_t i{ 0 }; i < message::TagIndex::inline_capacity + 4; ++i) {
+				tags += "key" + std::to_string(i) + "=v:" + std::to_string(i) + ";";
+			}
+			tags += "flag;empty=";
+
+			const auto line = "@" + tags + " :tmi.twitch.tv USERSTATE #dallas";
+			const auto tokenized = message::TokenizedMessage::tokenize(line);
+			BOOST_REQUIRE(tokenized.has_value());
+			BOOST_CHECK(tokenized->tags == tags);
+			BOOST_CHECK(tokenized->command == "USERSTATE");
+
+			const message::TagIndex lazy{ tags };
+			BOOST_CHECK_EQUAL(tokenized->tag_index.size(), lazy.size());
+			for (const auto key : { "key0", "key31", "key32", "key35", "flag", "empty", "missing" }) {
+				BOOST_CHECK(tokenized->tag(key) == lazy.find(key));
+			}
+			BOOST_CHECK(tokenized->tag("key31").value() == "v:31");
+		}
+	};
+
+	auto* scanner_suite(const std::string& suite_name) {
+		auto* suite = BOOST_TEST_SUITE(std::move(suite_name));
+
+		suite->add( BOOST_TEST_CASE( &scanner_details::block_mask_matches_scalar ) );
+		suite->add( BOOST_TEST_CASE( &scanner_details::positions_in_order        ) );
+		suite->add( BOOST_TEST_CASE( &scanner_details::lowest_bit                ) );
+		suite->add( BOOST_TEST_CASE( &scanner_details::tokenized_tags_match_lazy ) );
+
+		return suite;
+	}
+
+	struct metrics_details {
+		static void histogram_buckets() {
+			using Twitch::irc::metrics::LatencyHistogram;
+			using namespace std::chrono_literals;
+			BOOST_CHECK_EQUAL(LatencyHistogram::bucket_of(0), 0u);
+			BOOST_CHECK_EQUAL(LatencyHistogram::bucket_of(1), 1u);
+			BOOST_CHECK_EQUAL(LatencyHistogram::bucket_of(3), 2u);
+			BOOST_CHECK_EQUAL(LatencyHistogram::bucket_of(1024), 11u);
+			BOOST_CHECK_EQUAL(LatencyHistogram::bucket_of(~std::uint64_t{ 0 }), LatencyHistogram::buckets - 1);
+
+			LatencyHistogram histogram;
+			for (int i{ 0 }; i < 9; ++i) { histogram.record(100ns); }
+			histogram.record(1ms);
+			histogram.record(-5ns); // clocks going backwards count as 0
+
+			const auto snapshot = histogram.snapshot();
+			BOOST_CHECK_EQUAL(snapshot.count, 11u);
+			BOOST_CHECK_EQUAL(snapshot.sum_ns, 9 * 100u + 1'000'000u);
+			BOOST_CHECK_EQUAL(snapshot.quantile(0.5), 128u);
+			BOOST_CHECK_EQUAL(snapshot.quantile(1.0), 1u << 20);
+			BOOST_CHECK_EQUAL(LatencyHistogram{}.snapshot().quantile(0.5), 0u);
+		}
+
+		static void parser_counts() {
+			message::MessageParser parser;
+			parser.process("PING :tmi.twitch.tv");
+			parser.process("PING :tmi.twitch.tv");
+			parser.process("");
+			parser.process(":tmi.twitch.tv 001 ronni :Welcome");
+
+			const auto snapshot = parser.metrics().snapshot();
+			BOOST_REQUIRE_EQUAL(snapshot.kinds.size(), message::parsed_types_t::size + 2);
+			BOOST_CHECK(snapshot.kinds.front().name == "ParseError");
+			BOOST_CHECK(snapshot.kinds[1].name == "PING");
+			BOOST_CHECK(snapshot.kinds.back().name == "Skipped");
+			BOOST_CHECK_EQUAL(snapshot.kinds[0].count, 2u);
+			BOOST_CHECK_EQUAL(snapshot.kinds[1].count, 2u);
+			BOOST_CHECK_EQUAL(snapshot.kinds[1].parse.count, 2u);
+
+			const auto errors = [&](message::ParseError::Reason reason) {
+				return snapshot.errors[static_cast<std::size_t>(reason)].count;
+			};
+			BOOST_CHECK_EQUAL(errors(message::ParseError::Reason::malformed), 1u);
+			BOOST_CHECK_EQUAL(errors(message::ParseError::Reason::not_handled), 1u);
+			BOOST_CHECK_EQUAL(errors(message::ParseError::Reason::exception), 0u);
+
+			// handler time is recorded under the alternative it was given
+			const auto result = parser.process("PING :tmi.twitch.tv");
+			int visited{ 0 };
+			parser.dispatch([&](const auto&) { ++visited; }, result);
+			BOOST_CHECK_EQUAL(visited, 1);
+			BOOST_CHECK_EQUAL(parser.metrics().snapshot().kinds[1].handle.count, 1u);
+		}
+
+		static void prometheus_text() {
+			namespace metrics = Twitch::irc::metrics;
+			using namespace std::chrono_literals;
+
+			message::MessageParser parser;
+			parser.process("PING :tmi.twitch.tv");
+
+			metrics::ConnectionMetrics connection;
+			connection.lines_read.add(3);
+			connection.write_wait.record(1500ns);
+
+			const auto text = metrics::to_prometheus({
+				metrics::Snapshot{ "0", parser.metrics().snapshot(), connection.snapshot(4) }
+			});
+			const auto has = [&](const std::string& line) { return text.find(line + '\n') != std::string::npos; };
+			BOOST_CHECK(has("# TYPE twitch_irc_read_lines_total counter"));
+			BOOST_CHECK(has("twitch_irc_read_lines_total{connection=\"0\"} 3"));
+			BOOST_CHECK(has("twitch_irc_write_queue_depth{connection=\"0\"} 4"));
+			BOOST_CHECK(has("twitch_irc_write_wait_seconds_bucket{connection=\"0\",le=\"+Inf\"} 1"));
+			BOOST_CHECK(has("twitch_irc_write_wait_seconds_count{connection=\"0\"} 1"));
+			BOOST_CHECK(has("twitch_irc_messages_total{connection=\"0\",kind=\"PING\"} 1"));
+			BOOST_CHECK(has("twitch_irc_parse_errors_total{connection=\"0\",reason=\"malformed\"} 0"));
+			BOOST_CHECK(has("twitch_irc_parse_seconds_count{connection=\"0\",kind=\"PING\"} 1"));
+			// kinds that never showed up get no histogram
+			BOOST_CHECK(text.find("twitch_irc_parse_seconds_count{connection=\"0\",kind=\"JOIN\"}") == std::string::npos);
+		}
+	};
+
+	auto* metrics_suite(const std::string& suite_name) {
+		auto* suite = BOOST_TEST_SUITE(std::move(suite_name));
+
+		suite->add( BOOST_TEST_CASE( &metrics_details::histogram_buckets ) );
+		suite->add( BOOST_TEST_CASE( &metrics_details::parser_counts     ) );
+		suite->add( BOOST_TEST_CASE( &metrics_details::prometheus_text   ) );
+
+		return suite;
+	}
+
+	struct emotes_details {
+		static void decode_ranges() {
+			using namespace std::string_view_literals;
+			using Twitch::irc::parameters::Emote;
+			const auto raw = "25:0-4,12-16/1902:6-10"sv;
+			const auto index = Twitch::irc::parameters::EmoteIndex::decode(raw);
+
+			BOOST_CHECK(index.valid());
+			BOOST_CHECK_EQUAL(index.size(), 3);
+			BOOST_CHECK(index.get(raw, 0) == (Emote{ "25"sv, 0, 4 }));
+			BOOST_CHECK(index.get(raw, 1) == (Emote{ "25"sv, 12, 16 }));
+			BOOST_CHECK(index.get(raw, 2) == (Emote{ "1902"sv, 6, 10 }));
+		}
+
+		static void decode_malformed() {
+			using namespace std::string_view_literals;
+			using Twitch::irc::parameters::EmoteIndex;
+			BOOST_CHECK(EmoteIndex::decode(""sv).valid() && EmoteIndex::decode(""sv).empty());
+			BOOST_CHECK(!EmoteIndex::decode("25"sv).valid());
+			BOOST_CHECK(!EmoteIndex::decode("25:"sv).valid());
+			BOOST_CHECK(!EmoteIndex::decode("25:4-0"sv).valid());
+			BOOST_CHECK(!EmoteIndex::decode("25:0-x"sv).valid());
+
+			const auto partial = EmoteIndex::decode("25:0-4/1902:6"sv);
+			BOOST_CHECK(!partial.valid());
+			BOOST_CHECK_EQUAL(partial.size(), 1);
+		}
+
+		static void decode_spill() {
+			using namespace std::string_view_literals;
+			using Twitch::irc::parameters::EmoteIndex;
+			std::string raw{ "25:" };
+			const std::size_t count = EmoteIndex::inline_capacity * 2 + 1;
+			for (std::size_t i{ 0 }; i < count; ++i) {
+				if (i != 0) { raw += ','; }
+				raw += std::to_string(i * 6) + '-' + std::to_string(i * 6 + 4);
+			}
+
+			const auto index = EmoteIndex::decode(raw);
+			BOOST_CHECK(index.valid());
+			BOOST_CHECK_EQUAL(index.size(), count);
+			BOOST_CHECK_EQUAL(index.get(raw, count - 1).begin, (count - 1) * 6);
+			BOOST_CHECK(index.get(raw, count - 1).id == "25"sv);
+		}
+
+		// decoded on demand and resolved against the message's own strings
+		static void privmsg_emote_index() {
+			using namespace std::string_view_literals;
+			const auto& test = tags_doc::privmsg::tests[1];
+			const auto msg = tags::PRIVMSG::is(test.first);
+			BOOST_REQUIRE(msg.has_value());
+
+			const auto copy = *msg;
+			const auto index = copy.emote_index();
+			BOOST_CHECK_EQUAL(index.size(), 3);
+			BOOST_CHECK(index.get(copy.emotes, 2).id == "1902"sv);
+			BOOST_CHECK(copy.message.substr(index.get(copy.emotes, 0).begin, 5) == "Kappa");
+			BOOST_CHECK(copy.message.substr(index.get(copy.emotes, 2).begin, 5) == "Keepo");
+		}
+
+		// twitch counts code points, text before and inside an emote may take several bytes each
+		static void decode_utf8() {
+			using namespace std::string_view_literals;
+			using Twitch::irc::parameters::Emote;
+			using Twitch::irc::parameters::EmoteIndex;
+			const auto text = "\xC3\xA9\xC3\xA9 Kappa \xF0\x9F\x98\x80 Keepo"sv; // "éé Kappa 😀 Keepo"
+			const auto raw = "25:3-7/1902:11-15"sv;
+			const auto index = EmoteIndex::decode(raw, text);
+
+			BOOST_CHECK(index.valid());
+			BOOST_REQUIRE_EQUAL(index.size(), 2);
+			BOOST_CHECK(index.get(raw, 0) == (Emote{ "25"sv, 5, 9 }));
+			BOOST_CHECK(text.substr(index.get(raw, 0).begin, 5) == "Kappa"sv);
+			BOOST_CHECK(text.substr(index.get(raw, 1).begin, 5) == "Keepo"sv);
+
+			const auto emoji = EmoteIndex::decode("1:9-9"sv, text);
+			BOOST_CHECK(emoji.get("1:9-9"sv, 0) == (Emote{ "1"sv, 11, 14 }));
+
+			const auto past_end = EmoteIndex::decode("25:3-7/1902:11-16"sv, text);
+			BOOST_CHECK(!past_end.valid());
+			BOOST_CHECK_EQUAL(past_end.size(), 1);
+
+			const std::string line{
+				"@badges=;color=;display-name=Nick;emotes=25:3-7;id=1;mod=0;room-id=1;subscriber=0;"
+				"tmi-sent-ts=1526424153891;turbo=0;user-id=1;user-type="
+				" :user!user@user.tmi.twitch.tv PRIVMSG #channel :\xC3\xA9\xC3\xA9 Kappa"
+			};
+			const auto msg = tags::PRIVMSG::is(line);
+			BOOST_REQUIRE(msg.has_value());
+			const auto privmsg_index = msg->emote_index();
+			BOOST_REQUIRE_EQUAL(privmsg_index.size(), 1);
+			BOOST_CHECK(msg->message.substr(privmsg_index.get(msg->emotes, 0).begin, 5) == "Kappa");
+		}
+
+		static void stats_batch() {
+			using namespace std::string_view_literals;
+			std::vector<message::view::PRIVMSG> views;
+			for (const auto& test : tags_doc::privmsg::tests) {
+				if (auto view = message::view::PRIVMSG::is(test.first); view) { views.push_back(*view); }
+			}
+
+			Twitch::irc::parameters::EmoteStats stats;
+			stats.add_all(views);
+			stats.add("25:0-4"sv);
+
+			BOOST_CHECK_EQUAL(stats.count("25"sv), 3);
+			BOOST_CHECK_EQUAL(stats.count("1902"sv), 1);
+			BOOST_CHECK_EQUAL(stats.count("30259"sv), 0);
+			BOOST_CHECK_EQUAL(stats.total(), 4);
+		}
+	};
+
+	auto* emotes_suite(const std::string& suite_name) {
+		auto* suite = BOOST_TEST_SUITE(std::move(suite_name));
+
+		suite->add( BOOST_TEST_CASE( &emotes_details::decode_ranges       ) );
+		suite->add( BOOST_TEST_CASE( &emotes_details::decode_malformed    ) );
+		suite->add( BOOST_TEST_CASE( &emotes_details::decode_spill        ) );
+		suite->add( BOOST_TEST_CASE( &emotes_details::privmsg_emote_index ) );
+		suite->add( BOOST_TEST_CASE( &emotes_details::decode_utf8         ) );
+		suite->add( BOOST_TEST_CASE( &emotes_details::stats_batch         ) );
+
+		return suite;
+	}
+
+	struct rate_limiter_details {
+		using RateLimiter = Twitch::irc::RateLimiter;
+
+		static void limiter_PONG_not_limited() {
+			RateLimiter limiter;
+			const auto now = RateLimiter::clock_t::now();
+			for (std::size_t i{ 0 }; i < RateLimiter::user_messages; ++i) {
+				limiter.push("PRIVMSG #channel :spam");
+			}
+			limiter.push("PONG :tmi.twitch.tv", true);
+
+			BOOST_CHECK(limiter.pop(now).value() == "PONG :tmi.twitch.tv");
+		}
+
+		static void limiter_user_budget() {
+			RateLimiter limiter;
+			for (std::size_t i{ 0 }; i <= RateLimiter::user_messages; ++i) {
+				limiter.push("PRIVMSG #channel :spam");
+			}
+			const auto now = RateLimiter::clock_t::now(); // after the budget was made, so it's full
+
+			for (std::size_t i{ 0 }; i < RateLimiter::user_messages; ++i) {
+				BOOST_CHECK(limiter.pop(now).has_value());
+			}
+			BOOST_CHECK(!limiter.pop(now).has_value());
+
+			const auto wait = limiter.next_release(now);
+			BOOST_REQUIRE(wait.has_value());
+			BOOST_CHECK(*wait > RateLimiter::clock_t::duration::zero());
+			BOOST_CHECK(limiter.pop(now + *wait).has_value());
+		}
+
+		static void limiter_JOIN_separate_budget() {
+			RateLimiter limiter;
+			const auto now = RateLimiter::clock_t::now();
+			for (std::size_t i{ 0 }; i < RateLimiter::user_messages; ++i) {
+				limiter.push("PRIVMSG #channel :spam");
+				BOOST_CHECK(limiter.pop(now).has_value());
+			}
+			limiter.push("JOIN #other");
+
+			BOOST_CHECK(limiter.pop(now).value() == "JOIN #other");
+		}
+
+		// channels take turns, a busy one can't starve the others
+		static void limiter_channels_take_turns() {
+			RateLimiter limiter;
+			const auto now = RateLimiter::clock_t::now();
+			limiter.push("PRIVMSG #busy :spam");
+			limiter.push("PRIVMSG #busy :spam");
+			limiter.push("PRIVMSG #quiet :hello");
+
+			BOOST_CHECK(limiter.pop(now).value() == "PRIVMSG #busy :spam");
+			BOOST_CHECK(limiter.pop(now).value() == "PRIVMSG #quiet :hello");
+			BOOST_CHECK(limiter.pop(now).value() == "PRIVMSG #busy :spam");
+		}
+
+		// twitch counts chat per account, more channels don't add to the budget
+		static void limiter_account_budget() {
+			RateLimiter limiter;
+			for (std::size_t i{ 0 }; i < RateLimiter::user_messages; ++i) {
+				limiter.push("PRIVMSG #first :spam");
+				limiter.push("PRIVMSG #second :spam");
+			}
+			const auto now = RateLimiter::clock_t::now();
+
+			std::size_t sent{ 0 };
+			while (limiter.pop(now)) { ++sent; }
+			BOOST_CHECK_EQUAL(sent, RateLimiter::user_messages);
+
+			const auto wait = limiter.next_release(now);
+			BOOST_REQUIRE(wait.has_value());
+			BOOST_CHECK(*wait > RateLimiter::clock_t::duration::zero());
+		}
+
+		// connections of one account share it too
+		static void limiter_shared_message_budget() {
+			const auto budget = std::make_shared<Twitch::irc::MessageBudget>(
+				RateLimiter::user_messages, RateLimiter::moderator_messages, RateLimiter::messages_period
+			);
+			RateLimiter first, second;
+			first.share_message_budget(budget);
+			second.share_message_budget(budget);
+			for (std::size_t i{ 0 }; i < RateLimiter::user_messages; ++i) {
+				first.push("PRIVMSG #first :spam");
+				second.push("PRIVMSG #second :spam");
+			}
+			const auto now = RateLimiter::clock_t::now();
+
+			std::size_t sent{ 0 };
+			for (std::size_t i{ 0 }; i < RateLimiter::user_messages; ++i) {
+				if (first.pop(now)) { ++sent; }
+				if (second.pop(now)) { ++sent; }
+			}
+			BOOST_CHECK_EQUAL(sent, RateLimiter::user_messages);
+		}
+
+		static void limiter_moderator_budget() {
+			RateLimiter limiter;
+			limiter.set_moderator("#channel", true);
+			const auto now = RateLimiter::clock_t::now();
+			for (std::size_t i{ 0 }; i < RateLimiter::user_messages + 1; ++i) {
+				limiter.push("PRIVMSG #channel :spam");
+				BOOST_CHECK(limiter.pop(now).has_value());
+			}
+
+			// the user budget wasn't touched, the total was
+			for (std::size_t i{ 0 }; i < RateLimiter::user_messages; ++i) {
+				limiter.push("PRIVMSG #other :spam");
+				BOOST_CHECK(limiter.pop(now).has_value());
+			}
+			for (std::size_t i{ 0 }; i < RateLimiter::moderator_messages; ++i) {
+				limiter.push("PRIVMSG #channel :spam");
+			}
+			std::size_t sent{ 0 };
+			while (limiter.pop(now)) { ++sent; }
+			BOOST_CHECK_EQUAL(sent, RateLimiter::moderator_messages - 2 * RateLimiter::user_messages - 1);
+		}
+
+		static void limiter_reconnect() {
+			RateLimiter limiter;
+			limiter.push("PRIVMSG #channel :hello");
+			limiter.push("PONG :tmi.twitch.tv", true);
+			limiter.push("JOIN #channel");
+			limiter.reconnect({ "PASS :oauth:token", "NICK :bot", "JOIN #channel" });
+
+			const auto now = RateLimiter::clock_t::now();
+			BOOST_CHECK(limiter.pop(now).value() == "PASS :oauth:token");
+			BOOST_CHECK(limiter.pop(now).value() == "NICK :bot");
+			BOOST_CHECK(limiter.pop(now).value() == "JOIN #channel");
+			BOOST_CHECK(limiter.pop(now).value() == "PRIVMSG #channel :hello");
+			BOOST_CHECK(!limiter.pop(now).has_value());
+		}
+
+		// chat goes out after its channel's JOIN, even when the JOIN budget holds that back
+		static void limiter_chat_after_JOIN() {
+			RateLimiter limiter;
+			limiter.share_join_budget(std::make_shared<Twitch::irc::SharedTokenBucket>(1, RateLimiter::joins_period));
+			limiter.reconnect({ "JOIN :#first", "JOIN :#second" });
+			limiter.requeue("PRIVMSG #second :aborted");
+			limiter.push("PRIVMSG #first :hello");
+
+			const auto now = RateLimiter::clock_t::now();
+			BOOST_CHECK(limiter.pop(now).value() == "JOIN :#first");
+			BOOST_CHECK(limiter.pop(now).value() == "PRIVMSG #first :hello");
+			BOOST_CHECK(!limiter.pop(now).has_value());
+
+			const auto wait = limiter.next_release(now);
+			BOOST_REQUIRE(wait.has_value());
+			BOOST_CHECK(*wait > RateLimiter::clock_t::duration::zero());
+			BOOST_CHECK(limiter.pop(now + *wait).value() == "JOIN :#second");
+			BOOST_CHECK(limiter.pop(now + *wait).value() == "PRIVMSG #second :aborted");
+		}
+
+		// chat waits for every JOIN of its channel, reconnect() drops the old ones
+		static void limiter_chat_after_every_JOIN() {
+			RateLimiter limiter;
+			limiter.share_join_budget(std::make_shared<Twitch::irc::SharedTokenBucket>(1, RateLimiter::joins_period));
+			limiter.push("JOIN :#channel");
+			limiter.push("JOIN :#channel");
+			limiter.push("PRIVMSG #channel :hello");
+
+			const auto now = RateLimiter::clock_t::now();
+			BOOST_CHECK(limiter.pop(now).value() == "JOIN :#channel");
+			BOOST_CHECK(!limiter.pop(now).has_value());
+
+			limiter.reconnect({ "PASS :oauth:token" });
+			BOOST_CHECK(limiter.pop(now).value() == "PASS :oauth:token");
+			BOOST_CHECK(limiter.pop(now).value() == "PRIVMSG #channel :hello");
+		}
+	};
+
+	auto* rate_limiter_suite(const std::string& suite_name) {
+		auto* suite = BOOST_TEST_SUITE(std::move(suite_name));
+
+		suite->add( BOOST_TEST_CASE( &rate_limiter_details::limiter_PONG_not_limited      ) );
+		suite->add( BOOST_TEST_CASE( &rate_limiter_details::limiter_user_budget           ) );
+		suite->add( BOOST_TEST_CASE( &rate_limiter_details::limiter_JOIN_separate_budget  ) );
+		suite->add( BOOST_TEST_CASE( &rate_limiter_details::limiter_channels_take_turns   ) );
+		suite->add( BOOST_TEST_CASE( &rate_limiter_details::limiter_account_budget        ) );
+		suite->add( BOOST_TEST_CASE( &rate_limiter_details::limiter_shared_message_budget ) );
+		suite->add( BOOST_TEST_CASE( &rate_limiter_details::limiter_moderator_budget      ) );
+		suite->add( BOOST_TEST_CASE( &rate_limiter_details::limiter_reconnect             ) );
+		suite->add( BOOST_TEST_CASE( &rate_limiter_details::limiter_chat_after_JOIN       ) );
+		suite->add( BOOST_TEST_CASE( &rate_limiter_details::limiter_chat_after_every_JOIN ) );
+
+		return suite;
+	}
+
+	struct commands_details {
+		using Commands = Twitch::irc::Commands;
+
+		static auto reply(std::string text) {
+			return [text = std::move(text)](const tags::PRIVMSG&) { return text; };
+		}
+
+		static void commands_find() {
+			const Commands commands{ { "!hello", reply("hi") }, { "!uptime", reply("1h") } };
+
+			BOOST_CHECK(commands.find("!hello") != nullptr);
+			BOOST_CHECK(commands.find("!uptime") != nullptr);
+			BOOST_CHECK(commands.find("!hell") == nullptr);
+			BOOST_CHECK(commands.find("") == nullptr);
+		}
+
+		static void commands_change() {
+			Commands commands{ { "!hello", reply("hi") } };
+			{
+				const Commands::Pin pin;
+				const auto* old_handle = commands.find("!hello");
+
+				commands.insert_or_assign("!bye", reply("bye"));
+				BOOST_CHECK(commands.find("!bye") != nullptr);
+				BOOST_CHECK(commands.find("!hello") != nullptr);
+
+				BOOST_CHECK(commands.erase("!hello"));
+				BOOST_CHECK(!commands.erase("!hello"));
+				BOOST_CHECK(commands.find("!hello") == nullptr);
+
+				BOOST_CHECK(static_cast<bool>(*old_handle)); // retired handles stay valid while pinned
+				BOOST_CHECK_EQUAL(Commands::retired(), 2u);
+			}
+			BOOST_CHECK_EQUAL(Commands::retired(), 0u); // releasing the last pin frees them
+
+			{
+				const Commands::Pin pin;
+				commands.insert_or_assign("!again", reply("again"));
+				BOOST_CHECK_EQUAL(Commands::retired(), 1u);
+			}
+			BOOST_CHECK_EQUAL(Commands::retired(), 0u); // without another change after it
+		}
+
+		// readers never see a freed table while a writer keeps replacing it
+		static void commands_pinned_readers() {
+			const auto& privmsg = tags_doc::privmsg::tests.front().second;
+			Commands commands{ { "!hello", reply("hi") } };
+
+			std::atomic_bool stop{ false };
+			std::atomic<std::size_t> misses{ 0 };
+			std::vector<std::thread> readers;
+			for (int i{ 0 }; i < 2; ++i) {
+				readers.emplace_back([&]() {
+					while (!stop) {
+						const Commands::Pin pin;
+						const auto* handle = commands.find("!hello");
+						if (!handle || (*handle)(privmsg) != "hi") { ++misses; }
+					}
+				});
+			}
+
+			for (std::size_t i{ 0 }; i < 1000; ++i) {
+				commands.insert_or_assign("!bye", reply(std::to_string(i)));
+			}
+			stop = true;
+			for (auto& reader : readers) { reader.join(); }
+
+			BOOST_CHECK_EQUAL(misses.load(), 0u);
+			commands.insert_or_assign("!bye", reply("bye"));
+			BOOST_CHECK_EQUAL(Commands::retired(), 0u);
+		}
+	};
+
+	auto* command_table_suite(const std::string& suite_name) {
+		auto* suite = BOOST_TEST_SUITE(std::move(suite_name));
+
+		suite->add( BOOST_TEST_CASE( &commands_details::commands_find           ) );
+		suite->add( BOOST_TEST_CASE( &commands_details::commands_change         ) );
+		suite->add( BOOST_TEST_CASE( &commands_details::commands_pinned_readers ) );
+
+		return suite;
+	}
+
+	struct pool_details {
+		using ConnectionPool = Twitch::irc::ConnectionPool;
+
+		static ConnectionPool make_pool(std::vector<std::string> channels, std::size_t shards) {
+			return ConnectionPool(
+				std::move(channels),
+				shards,
+				[](std::vector<std::string> shard_channels) {
+					return std::make_shared<Twitch::irc::Controller>(
+						"irc.chat.twitch.tv", "6667", std::move(shard_channels), "bot", "oauth:token"
+					);
+				},
+				std::make_shared<Twitch::irc::Commands>(std::initializer_list<Twitch::irc::Commands::value_type>{}),
+				std::make_shared<Twitch::irc::CommandExecutor>(1, 1)
+			);
+		}
+
+		static void pool_shards_round_robin() {
+			const auto pool = make_pool({ "#a", "#b", "#c", "#d", "#e" }, 2);
+
+			BOOST_CHECK_EQUAL(pool.size(), 2u);
+			BOOST_CHECK_EQUAL(pool.shard_of("#a").value(), 0u);
+			BOOST_CHECK_EQUAL(pool.shard_of("#b").value(), 1u);
+			BOOST_CHECK_EQUAL(pool.shard_of("#e").value(), 0u);
+			BOOST_CHECK(!pool.shard_of("#f").has_value());
+		}
+
+		static void pool_no_more_shards_than_channels() {
+			const auto pool = make_pool({ "#a", "#b" }, 8);
+			BOOST_CHECK_EQUAL(pool.size(), 2u);
+		}
+
+		static void pool_hundred_channels_per_shard() {
+			std::vector<std::string> channels;
+			for (std::size_t i{ 0 }; i < 250; ++i) { channels.push_back("#c" + std::to_string(i)); }
+
+			const auto pool = make_pool(std::move(channels), 2);
+			BOOST_CHECK_EQUAL(pool.size(), 3u);
+		}
+
+		static void pool_dedupes_channels() {
+			const auto pool = make_pool({ "#a", "#b", "#a", "#c", "#b" }, 8);
+
+			BOOST_CHECK_EQUAL(pool.size(), 3u);
+			BOOST_CHECK_EQUAL(pool.shard_of("#a").value(), 0u);
+			BOOST_CHECK_EQUAL(pool.shard_of("#c").value(), 2u);
+		}
+
+		static void pool_routes_by_channel() {
+			auto pool = make_pool({ "#a", "#b" }, 2);
+
+			BOOST_CHECK(pool.enqueue("PRIVMSG #b :hello"));
+			BOOST_CHECK(!pool.enqueue("PRIVMSG #unknown :hello"));
+		}
+	};
+
+	auto* pool_suite(const std::string& suite_name) {
+		auto* suite = BOOST_TEST_SUITE(std::move(suite_name));
+
+		suite->add( BOOST_TEST_CASE( &pool_details::pool_shards_round_robin           ) );
+		suite->add( BOOST_TEST_CASE( &pool_details::pool_no_more_shards_than_channels ) );
+		suite->add( BOOST_TEST_CASE( &pool_details::pool_hundred_channels_per_shard   ) );
+		suite->add( BOOST_TEST_CASE( &pool_details::pool_dedupes_channels             ) );
+		suite->add( BOOST_TEST_CASE( &pool_details::pool_routes_by_channel            ) );
+
+		return suite;
+	}
+
+	struct executor_details {
+		using CommandExecutor = Twitch::irc::CommandExecutor;
+
+		static void executor_runs_tasks() {
+			std::atomic<int> counter{ 0 };
+			{
+				CommandExecutor executor{ 2, 16, CommandExecutor::Overflow::block };
+				for (int i{ 0 }; i < 100; ++i) {
+					BOOST_CHECK(executor.submit([&]() { ++counter; }));
+				}
+			} // joins after draining
+
+			BOOST_CHECK_EQUAL(counter.load(), 100);
+		}
+
+		static void executor_drops_when_full() {
+			std::promise<void> release;
+			std::shared_future<void> released{ release.get_future() };
+			std::promise<void> started;
+
+			CommandExecutor executor{ 1, 1, CommandExecutor::Overflow::drop };
+			BOOST_CHECK(executor.submit([&]() { started.set_value(); released.wait(); }));
+			started.get_future().wait();
+
+			BOOST_CHECK(executor.submit([]() {}));  // queued
+			BOOST_CHECK(!executor.submit([]() {})); // no room
+
+			const auto stats = executor.stats();
+			BOOST_CHECK_EQUAL(stats.running, 1u);
+			BOOST_CHECK_EQUAL(stats.queued, 1u);
+			BOOST_CHECK_EQUAL(stats.rejected, 1u);
+
+			release.set_value();
+		}
+	};
+
+	auto* executor_suite(const std::string& suite_name) {
+		auto* suite = BOOST_TEST_SUITE(std::move(suite_name));
+
+		suite->add( BOOST_TEST_CASE( &executor_details::executor_runs_tasks      ) );
+		suite->add( BOOST_TEST_CASE( &executor_details::executor_drops_when_full ) );
+
+		return suite;
+	}
+
+	struct logger_details {
+		static void ring_buffer_bounded() {
+			Logger::RingBuffer<int> ring{ 3 };
+			BOOST_CHECK_EQUAL(ring.capacity(), 4u);
+			BOOST_CHECK(ring.empty());
+
+			for (int i{ 0 }; i < 4; ++i) { BOOST_CHECK(ring.try_push(i)); }
+			int value{ 42 };
+			BOOST_CHECK(!ring.try_push(value));
+			BOOST_CHECK_EQUAL(value, 42);
+
+			for (int i{ 0 }; i < 4; ++i) {
+				BOOST_CHECK(ring.try_pop(value));
+				BOOST_CHECK_EQUAL(value, i);
+			}
+			BOOST_CHECK(!ring.try_pop(value));
+			BOOST_CHECK(ring.empty());
+		}
+
+		// every producer's values arrive once and in order
+		static void ring_buffer_producers() {
+			constexpr int producers{ 4 };
+			constexpr int per_producer{ 10000 };
+			Logger::RingBuffer<int> ring{ 64 };
+
+			std::vector<std::thread> threads;
+			for (int p{ 0 }; p < producers; ++p) {
+				threads.emplace_back([&ring, p]() {
+					for (int i{ 0 }; i < per_producer; ++i) {
+						int value{ p * per_producer + i };
+						while (!ring.try_push(value)) { std::this_thread::yield(); }
+					}
+				});
+			}
+
+			std::vector<int> next(producers, 0);
+			int received{ 0 };
+			bool ordered{ true };
+			while (received < producers * per_producer) {
+				int value;
+				if (!ring.try_pop(value)) { continue; }
+				const auto p = value / per_producer;
+				ordered = ordered && value % per_producer == next[p]++;
+				++received;
+			}
+			for (auto& thread : threads) { thread.join(); }
+
+			BOOST_CHECK(ordered);
+			BOOST_CHECK(ring.empty());
+		}
+
+		// written and dropped records add up to what was logged, drops are reported in the file
+		static void async_sink_writes() {
+			using severity = boost::log::trivial::severity_level;
+			const auto path = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+			constexpr int records{ 5000 };
+
+			boost::log::add_common_attributes();
+			boost::log::register_simple_formatter_factory<severity, char>("Severity");
+
+			Logger::Options options;
+			options.capacity = 16;
+			options.console = false;
+			auto sink = boost::make_shared<Logger::AsyncSink>(options, path);
+
+			auto core = boost::log::core::get();
+			core->add_sink(sink);
+			{
+				boost::log::sources::severity_logger<severity> lg;
+				for (int i{ 0 }; i < records; ++i) { BOOST_LOG_SEV(lg, severity::trace) << "record " << i; }
+			}
+			core->flush();
+			core->remove_sink(sink);
+
+			std::ifstream file{ path.string() };
+			std::string line;
+			int written{ 0 };
+			bool reported{ false };
+			while (std::getline(file, line)) {
+				if (line.find("<trace>: record ") != std::string::npos) { ++written; }
+				reported = reported || line.find("records dropped") != std::string::npos;
+			}
+			file.close();
+			boost::filesystem::remove(path);
+
+			BOOST_CHECK_EQUAL(written + static_cast<int>(sink->dropped()), records);
+			BOOST_CHECK(reported == (sink->dropped() != 0));
+			BOOST_CHECK(written > 0);
+		}
+
+		// views are copied when the record is made, formatting happens later
+		static void deferred_copies_views() {
+			using Logger::details::capture_t;
+			static_assert(std::is_same_v<capture_t<std::string_view>, std::string>);
+			static_assert(std::is_same_v<capture_t<const std::pmr::string&>, std::string>);
+			static_assert(std::is_same_v<capture_t<const char*>, std::string>);
+			static_assert(std::is_same_v<capture_t<const char(&)[4]>, const char*>);
+			static_assert(std::is_same_v<capture_t<const int&>, int>);
+
+			std::string source{ "user" };
+			const auto deferred = Logger::Deferred::capture("Joins: ", std::string_view{ source }, ' ', 42);
+			source = "overwritten";
+
+			std::string text;
+			{
+				boost::log::formatting_ostream out{ text };
+				out << deferred;
+				out.flush();
+			}
+			BOOST_CHECK_EQUAL(text, "Joins: user 42");
+		}
+
+		// disabled levels don't evaluate their arguments, enabled ones reach the sink formatted
+		static void macro_respects_min_severity() {
+			using severity = boost::log::trivial::severity_level;
+			static_assert(Logger::enabled(severity::fatal));
+			static_assert(Logger::enabled(severity::trace) == (Logger::min_severity == severity::trace));
+
+			const auto path = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+			boost::log::add_common_attributes();
+			boost::log::register_simple_formatter_factory<severity, char>("Severity");
+			boost::log::register_simple_formatter_factory<Logger::Deferred, char>(Logger::Deferred::attribute);
+
+			Logger::Options options;
+			options.console = false;
+			auto sink = boost::make_shared<Logger::AsyncSink>(options, path);
+
+			auto core = boost::log::core::get();
+			core->add_sink(sink);
+			bool evaluated{ false };
+			{
+				boost::log::sources::severity_logger<severity> lg;
+				TWITCH_IRC_LOG(lg, trace, (evaluated = true, "traced"));
+				TWITCH_IRC_LOG(lg, warning, "deferred ", 7, ' ', std::string_view{ "view" });
+			}
+			core->flush();
+			core->remove_sink(sink);
+
+			std::ifstream file{ path.string() };
+			std::string line;
+			bool traced{ false };
+			bool deferred{ false };
+			while (std::getline(file, line)) {
+				traced = traced || line.find("<trace>: traced") != std::string::npos;
+				deferred = deferred || line.find("<warning>: deferred 7 view") != std::string::npos;
+			}
+			file.close();
+			boost::filesystem::remove(path);
+
+			BOOST_CHECK_EQUAL(evaluated, Logger::enabled(severity::trace));
+			BOOST_CHECK_EQUAL(traced, Logger::enabled(severity::trace));
+			BOOST_CHECK(deferred);
+		}
+	};
+
+	auto* logger_suite(const std::string& suite_name) {
+		auto* suite = BOOST_TEST_SUITE(std::move(suite_name));
+
+		suite->add( BOOST_TEST_CASE( &logger_details::ring_buffer_bounded         ) );
+		suite->add( BOOST_TEST_CASE( &logger_details::ring_buffer_producers       ) );
+		suite->add( BOOST_TEST_CASE( &logger_details::async_sink_writes           ) );
+		suite->add( BOOST_TEST_CASE( &logger_details::deferred_copies_views       ) );
+		suite->add( BOOST_TEST_CASE( &logger_details::macro_respects_min_severity ) );
+
+		return suite;
+	}
+
+	struct capture_details {
+		using Reader = Twitch::irc::capture::Reader;
+		using Writer = Twitch::irc::capture::Writer;
+		using ReplayController = Twitch::irc::capture::ReplayController;
+		using clock_t = Twitch::irc::capture::clock_t;
+
+		static std::string temp_path() {
+			return (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()).string();
+		}
+
+		// lines of one read share its time, reads are as far apart as they were recorded
+		static void capture_round_trip() {
+			const auto path = temp_path();
+			const std::string long_line(300, 'x'); // length takes two varint bytes
+			{
+				Writer writer{ path };
+				const auto now = clock_t::now();
+				writer.write(now, { "PING :tmi.twitch.tv", long_line });
+				writer.write(now + std::chrono::milliseconds{ 5 }, { ":ronni!ronni@ronni.tmi.twitch.tv JOIN #dallas" });
+				writer.write(now - std::chrono::milliseconds{ 1 }, { "" }); // another shard, a bit behind
+				BOOST_CHECK_EQUAL(writer.records(), 4u);
+			}
+
+			Reader reader{ path };
+			const auto first = reader.next();
+			BOOST_REQUIRE(first);
+			BOOST_CHECK(first->line == "PING :tmi.twitch.tv");
+			const auto first_at = first->at;
+
+			const auto second = reader.next();
+			BOOST_REQUIRE(second);
+			BOOST_CHECK(second->line == long_line);
+			BOOST_CHECK(second->at == first_at);
+
+			const auto third = reader.next();
+			BOOST_REQUIRE(third);
+			BOOST_CHECK(third->line == ":ronni!ronni@ronni.tmi.twitch.tv JOIN #dallas");
+			BOOST_CHECK(third->at - first_at == std::chrono::milliseconds{ 5 });
+
+			const auto fourth = reader.next();
+			BOOST_REQUIRE(fourth);
+			BOOST_CHECK(fourth->line.empty());
+			BOOST_CHECK(fourth->at == third->at);
+
+			BOOST_CHECK(!reader.next());
+			BOOST_CHECK(reader.complete());
+			BOOST_CHECK(std::chrono::system_clock::now() - reader.started() < std::chrono::minutes{ 1 });
+			boost::filesystem::remove(path);
+		}
+
+		// reads of racing shards keep their own lines when they share a time, and replay apart
+		static void capture_interleaved_reads() {
+			const auto path = temp_path();
+			{
+				Writer writer{ path };
+				const auto now = clock_t::now();
+				writer.write(now, { "PING :tmi.twitch.tv", "PING :tmi.twitch.tv" });
+				writer.write(now, { ":ronni!ronni@ronni.tmi.twitch.tv JOIN #dallas" });
+				writer.write(now - std::chrono::milliseconds{ 1 }, { "PING :tmi.twitch.tv", "" }); // behind, clamped
+			}
+
+			Reader reader{ path };
+			std::vector<bool> first;
+			while (const auto record = reader.next()) { first.push_back(record->first); }
+			BOOST_CHECK(reader.complete());
+			BOOST_CHECK((first == std::vector<bool>{ true, false, true, true, false }));
+
+			ReplayController controller{ path, ReplayController::as_fast_as_possible };
+			std::vector<std::string_view> lines;
+			std::vector<std::size_t> reads;
+			while (!controller.read_lines(lines)) { reads.push_back(lines.size()); }
+			BOOST_CHECK((reads == std::vector<std::size_t>{ 2, 1, 2 }));
+			boost::filesystem::remove(path);
+		}
+
+		// a capture cut short by a crash reads up to the last whole record
+		static void capture_truncated() {
+			const auto path = temp_path();
+			{
+				Writer writer{ path };
+				writer.write(clock_t::now(), { "PING :tmi.twitch.tv", "PING :tmi.twitch.tv" });
+			}
+			boost::filesystem::resize_file(path, boost::filesystem::file_size(path) - 3);
+
+			Reader reader{ path };
+			BOOST_CHECK(reader.next());
+			BOOST_CHECK(!reader.next());
+			BOOST_CHECK(!reader.complete());
+
+			{
+				std::ofstream file{ path, std::ios::trunc };
+				file << "PING :tmi.twitch.tv\n";
+			}
+			BOOST_CHECK(!Reader::is_capture(path));
+			BOOST_CHECK_THROW(Reader{ path }, std::runtime_error);
+			boost::filesystem::remove(path);
+		}
+
+		// the bot parses and answers a replay like a live connection
+		static void replay_runs_bot() {
+			const auto path = temp_path();
+			{
+				Writer writer{ path };
+				const auto now = clock_t::now();
+				writer.write(now, { "PING :tmi.twitch.tv", ":ronni!ronni@ronni.tmi.twitch.tv PRIVMSG #dallas :Kappa" });
+				writer.write(now + std::chrono::microseconds{ 1 }, { "PING :tmi.twitch.tv" });
+			}
+
+			auto controller = std::make_shared<ReplayController>(path, ReplayController::as_fast_as_possible);
+			Twitch::irc::TwitchBot bot(
+				std::make_shared<Twitch::irc::Commands>(std::initializer_list<Twitch::irc::Commands::value_type>{}),
+				controller,
+				std::make_unique<message::MessageParser>(message::ParserVisitor::subscription()),
+				std::make_shared<Twitch::irc::CommandExecutor>(1, 1)
+			);
+			bot.run_async();
+
+			const auto snapshot = bot.metrics("replay");
+			BOOST_CHECK_EQUAL(snapshot.socket.lines_read, 3u);
+			BOOST_CHECK_EQUAL(snapshot.socket.lines_written, 2u); // PONGs
+			BOOST_CHECK_EQUAL(snapshot.parser.kinds[1].count, 2u);
+			BOOST_CHECK(!controller->is_alive());
+			BOOST_CHECK(controller->reader().complete());
+			boost::filesystem::remove(path);
+		}
+
+		// reads come as far apart as recorded, divided by speed
+		static void replay_keeps_pace() {
+			const auto path = temp_path();
+			{
+				Writer writer{ path };
+				const auto now = clock_t::now();
+				writer.write(now, { "PING :tmi.twitch.tv" });
+				writer.write(now + std::chrono::milliseconds{ 60 }, { "PING :tmi.twitch.tv" });
+			}
+
+			ReplayController controller{ path, 2.0 };
+			std::vector<std::string_view> lines;
+			BOOST_CHECK(!controller.read_lines(lines));
+			const auto first = clock_t::now();
+			BOOST_CHECK(!controller.read_lines(lines));
+			BOOST_CHECK(clock_t::now() - first >= std::chrono::milliseconds{ 29 });
+			BOOST_CHECK_EQUAL(lines.size(), 1u);
+			BOOST_CHECK(controller.read_lines(lines) == boost::asio::error::eof);
+			BOOST_CHECK(!controller.is_alive());
+			boost::filesystem::remove(path);
+		}
+	};
+
+	auto* capture_suite(const std::string& suite_name) {
+		auto* suite = BOOST_TEST_SUITE(std::move(suite_name));
+
+		suite->add( BOOST_TEST_CASE( &capture_details::capture_round_trip        ) );
+		suite->add( BOOST_TEST_CASE( &capture_details::capture_interleaved_reads ) );
+		suite->add( BOOST_TEST_CASE( &capture_details::capture_truncated         ) );
+		suite->add( BOOST_TEST_CASE( &capture_details::replay_runs_bot           ) );
+		suite->add( BOOST_TEST_CASE( &capture_details::replay_keeps_pace         ) );
+
+		return suite;
+	}
+
+	struct mock_server_details {
+		using MockServer = Twitch::irc::testing::MockServer;
+
+		static constexpr std::chrono::seconds timeout{ 10 };
+
+		// bot logged in to the server on its own thread, runs until the server drops it
+		struct Client
+		{
+			Client(MockServer& t_server, std::vector<std::string> channels) :
+				server(t_server),
+				bot(
+					std::make_shared<Twitch::irc::Commands>(std::initializer_list<Twitch::irc::Commands::value_type>{
+						{ "!Hello", [](const tags::PRIVMSG& msg) { return '@' + std::string{ msg.display_name } + " World!"; } }
+					}),
+					std::make_shared<Twitch::irc::Controller>("127.0.0.1", server.port(), std::move(channels), "bot", "oauth:token"),
+					std::make_unique<message::MessageParser>(message::ParserVisitor::subscription()),
+					std::make_shared<Twitch::irc::CommandExecutor>(1, 64)
+				),
+				thread([this]() {
+					bot.run_async();
+					finished = true;
+				})
+			{
+			}
+
+			~Client() {
+				server.disconnect();
+				thread.join();
+			}
+
+			MockServer& server;
+			Twitch::irc::TwitchBot bot;
+			std::atomic_bool finished{ false };
+			std::thread thread; // last, runs the bot
+		};
+
+		static void mock_handshake() {
+			MockServer server;
+			Client client{ server, { "#a", "#b" } };
+
+			BOOST_REQUIRE(server.wait_until([](const auto& stats) { return stats.joins == 2; }, timeout));
+			BOOST_CHECK((server.joined() == std::vector<std::string>{ "#a", "#b" }));
+
+			const auto received = server.received();
+			const auto sent = [&](const std::string& line) {
+				return std::find(received.begin(), received.end(), line) != received.end();
+			};
+			BOOST_CHECK(sent("CAP REQ :twitch.tv/tags twitch.tv/commands twitch.tv/membership"));
+			BOOST_CHECK(sent("PASS :oauth:token"));
+			BOOST_CHECK(sent("NICK :bot"));
+			BOOST_CHECK(sent("JOIN :#a"));
+			BOOST_CHECK_EQUAL(server.stats().logins, 1u);
+		}
+
+		static void mock_ping_pong() {
+			MockServer server;
+			Client client{ server, { "#a" } };
+			BOOST_REQUIRE(server.wait_until([](const auto& stats) { return stats.joins == 1; }, timeout));
+
+			server.ping();
+			BOOST_CHECK(server.wait_until([](const auto& stats) { return stats.pongs == 1; }, timeout));
+		}
+
+		// every command in the flood is answered, each answer is timed from its command
+		static void mock_command_latency() {
+			MockServer server;
+			Client client{ server, { "#a", "#b" } };
+			BOOST_REQUIRE(server.wait_until([](const auto& stats) { return stats.joins == 2; }, timeout));
+
+			MockServer::Flood flood;
+			flood.messages = 50;
+			flood.command_every = 10;
+			server.flood(flood);
+
+			BOOST_REQUIRE(server.wait_until([](const auto& stats) { return stats.responses == 5; }, timeout));
+			const auto stats = server.stats();
+			BOOST_CHECK_EQUAL(stats.sent, 50u);
+			BOOST_CHECK_EQUAL(stats.latency.count, 5u);
+			BOOST_CHECK(stats.latency.quantile(0.5) > 0u);
+			BOOST_CHECK(client.bot.metrics("0").socket.lines_written >= 5u);
+		}
+
+		// a paced flood takes as long as its rate says
+		static void mock_flood_rate() {
+			MockServer server;
+			Client client{ server, { "#a" } };
+			BOOST_REQUIRE(server.wait_until([](const auto& stats) { return stats.joins == 1; }, timeout));
+
+			MockServer::Flood flood;
+			flood.messages = 21;
+			flood.rate = 200.0; // 20 intervals of 5ms
+			const auto start = MockServer::clock_t::now();
+			server.flood(flood);
+
+			BOOST_REQUIRE(server.wait_until([](const auto& stats) { return stats.sent == 21; }, timeout));
+			BOOST_CHECK(MockServer::clock_t::now() - start >= std::chrono::milliseconds{ 99 });
+		}
+
+		// the bot comes back on its own and joins its channels again
+		static void mock_reconnect() {
+			MockServer server;
+			Client client{ server, { "#a" } };
+			BOOST_REQUIRE(server.wait_until([](const auto& stats) { return stats.joins == 1; }, timeout));
+
+			server.reconnect();
+			BOOST_CHECK(server.wait_until([](const auto& stats) {
+				return stats.connections == 2 && stats.logins == 2 && stats.joins == 2;
+			}, timeout));
+			BOOST_CHECK(!client.finished);
+
+			server.ping();
+			BOOST_CHECK(server.wait_until([](const auto& stats) { return stats.pongs == 1; }, timeout));
+		}
+
+		// with nothing listening reconnect() backs off between attempts and gives up after the last
+		static void mock_reconnect_gives_up() {
+			Twitch::irc::io_service_t io_service;
+			boost::asio::ip::tcp::acceptor acceptor{ io_service, { boost::asio::ip::address_v4::loopback(), 0 } };
+			const auto port = std::to_string(acceptor.local_endpoint().port());
+			acceptor.close();
+
+			Twitch::irc::Controller controller{ "127.0.0.1", port, { "#a" }, "bot", "oauth:token" };
+			controller.set_reconnect_policy({ 3, std::chrono::milliseconds{ 20 }, std::chrono::milliseconds{ 30 } });
+
+			auto start = MockServer::clock_t::now();
+			BOOST_CHECK(controller.reconnect()); // blocking, outside of run
+			BOOST_CHECK(MockServer::clock_t::now() - start >= std::chrono::milliseconds{ 50 });
+
+			// on the loop the read waits for the new connection and gets the last error
+			Twitch::irc::error_code_t read_error{};
+			controller.async_read([&](const Twitch::irc::error_code_t&, const std::vector<std::string_view>&) {
+				BOOST_CHECK(!controller.reconnect());
+				controller.async_read([&](const Twitch::irc::error_code_t& error, const std::vector<std::string_view>&) {
+					read_error = error;
+					controller.stop();
+				});
+			});
+			start = MockServer::clock_t::now();
+			controller.run();
+
+			BOOST_CHECK(read_error);
+			BOOST_CHECK(MockServer::clock_t::now() - start >= std::chrono::milliseconds{ 50 });
+		}
+
+		// JOINs over the budget wait in their lane, the connection keeps answering meanwhile
+		static void mock_join_budget() {
+			MockServer server;
+			const auto channels = Twitch::irc::RateLimiter::joins + 10;
+			Client client{ server, MockServer::channel_names(channels) };
+			BOOST_REQUIRE(server.wait_until([](const auto& stats) {
+				return stats.joins == Twitch::irc::RateLimiter::joins;
+			}, timeout));
+
+			server.ping();
+			BOOST_REQUIRE(server.wait_until([](const auto& stats) { return stats.pongs == 1; }, timeout));
+			BOOST_CHECK(server.stats().joins < channels);
+
+			// rejoining is budgeted the same way, without stalling the read loop
+			server.reconnect();
+			BOOST_REQUIRE(server.wait_until([](const auto& stats) { return stats.logins == 2; }, timeout));
+			server.ping();
+			BOOST_REQUIRE(server.wait_until([](const auto& stats) { return stats.pongs == 2; }, timeout));
+			BOOST_CHECK(server.stats().joins < 2 * channels);
+		}
+
+		// chat enqueued before run() waits in the limiter and goes out once the loop starts
+		static void mock_enqueue_before_run() {
+			MockServer server;
+			Twitch::irc::Controller controller{ "127.0.0.1", server.port(), { "#a" }, "bot", "oauth:token" };
+			BOOST_REQUIRE(!controller.connect());
+			BOOST_REQUIRE(!controller.login());
+			BOOST_REQUIRE(!controller.join_channel());
+
+			controller.enqueue("PRIVMSG #a :early", false);
+			BOOST_CHECK_EQUAL(controller.connection_metrics().queue_depth, 1u);
+
+			controller.run(); // returns once nothing is left to write
+			BOOST_CHECK_EQUAL(controller.connection_metrics().queue_depth, 0u);
+
+			const auto deadline = std::chrono::steady_clock::now() + timeout;
+			const auto written = [&]() {
+				const auto received = server.received();
+				return std::find(received.begin(), received.end(), "PRIVMSG #a :early") != received.end();
+			};
+			while (!written() && std::chrono::steady_clock::now() < deadline) {
+				std::this_thread::sleep_for(std::chrono::milliseconds{ 1 });
+			}
+			BOOST_CHECK(written());
+		}
+
+		// a dropped connection ends run_async
+		static void mock_disconnect() {
+			MockServer server;
+			Client client{ server, { "#a" } };
+			BOOST_REQUIRE(server.wait_until([](const auto& stats) { return stats.joins == 1; }, timeout));
+
+			server.disconnect();
+			const auto deadline = std::chrono::steady_clock::now() + timeout;
+			while (!client.finished && std::chrono::steady_clock::now() < deadline) {
+				std::this_thread::sleep_for(std::chrono::milliseconds{ 1 });
+			}
+			BOOST_CHECK(client.finished);
+		}
+	};
+
+	auto* mock_server_suite(const std::string& suite_name) {
+		auto* suite = BOOST_TEST_SUITE(std::move(suite_name));
+
+		suite->add( BOOST_TEST_CASE( &mock_server_details::mock_handshake          ) );
+		suite->add( BOOST_TEST_CASE( &mock_server_details::mock_ping_pong          ) );
+		suite->add( BOOST_TEST_CASE( &mock_server_details::mock_command_latency    ) );
+		suite->add( BOOST_TEST_CASE( &mock_server_details::mock_flood_rate         ) );
+		suite->add( BOOST_TEST_CASE( &mock_server_details::mock_reconnect          ) );
+		suite->add( BOOST_TEST_CASE( &mock_server_details::mock_reconnect_gives_up ) );
+		suite->add( BOOST_TEST_CASE( &mock_server_details::mock_join_budget        ) );
+		suite->add( BOOST_TEST_CASE( &mock_server_details::mock_enqueue_before_run ) );
+		suite->add( BOOST_TEST_CASE( &mock_server_details::mock_disconnect         ) );
+
+		return suite;
+	}
+
 	template<class M> auto* match_basic_messages_suite(const std::string& suite_name) {
 		auto* suite = BOOST_TEST_SUITE(std::move(suite_name));
 
@@ -814,6 +1978,20 @@ boost::unit_test::test_suite* init_unit_test_suite(int /*argc*/, char* /*argv*/[
 
 		boost::unit_test::framework::master_test_suite().add(tags_suite);
 	}
+	boost::unit_test::framework::master_test_suite().add(process_suite("process_suite"s));
+	boost::unit_test::framework::master_test_suite().add(view_suite("view_suite"s));
+	boost::unit_test::framework::master_test_suite().add(emotes_suite("emotes_suite"s));
+	boost::unit_test::framework::master_test_suite().add(badges_suite("badges_suite"s));
+	boost::unit_test::framework::master_test_suite().add(numeric_suite("numeric_suite"s));
+	boost::unit_test::framework::master_test_suite().add(scanner_suite("scanner_suite"s));
+	boost::unit_test::framework::master_test_suite().add(metrics_suite("metrics_suite"s));
+	boost::unit_test::framework::master_test_suite().add(rate_limiter_suite("rate_limiter_suite"s));
+	boost::unit_test::framework::master_test_suite().add(executor_suite("executor_suite"s));
+	boost::unit_test::framework::master_test_suite().add(logger_suite("logger_suite"s));
+	boost::unit_test::framework::master_test_suite().add(capture_suite("capture_suite"s));
+	boost::unit_test::framework::master_test_suite().add(mock_server_suite("mock_server_suite"s));
+	boost::unit_test::framework::master_test_suite().add(command_table_suite("command_table_suite"s));
+	boost::unit_test::framework::master_test_suite().add(pool_suite("pool_suite"s));
 
 	return 0;
 }
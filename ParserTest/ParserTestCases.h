@@ -0,0 +1,435 @@
+#ifndef PARSERTESTCASES_H
+#define PARSERTESTCASES_H
+#include "..\Twitch_C++_IRC_bot\TwitchMessage.h"
+#include <chrono>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+// TODO: find more test cases
+
+/// Twitch doc is incorrect in many examples, test cases mixed with real world examples
+namespace doc {
+	using namespace std::string_literals;
+	
+	namespace ping {
+		using Twitch::irc::message::PING;
+		
+		const std::vector<std::pair<std::string, PING>> tests{
+			{
+				"PING :tmi.twitch.tv",
+				PING{ "tmi.twitch.tv" }
+			}
+		};
+	}
+
+	namespace privmsg {
+		using Twitch::irc::message::PRIVMSG;
+		
+		const std::vector<std::pair<std::string, PRIVMSG>> tests{
+			{
+				":ronni!ronni@ronni.tmi.twitch.tv PRIVMSG #dallas :Kappa Keepo Kappa",
+				PRIVMSG{ "ronni", "tmi.twitch.tv", "#dallas", "Kappa Keepo Kappa" }
+			}
+		};
+	}
+
+	namespace cap {
+		namespace membership {
+			namespace join {
+				using Twitch::irc::message::cap::membership::JOIN;
+
+				const std::vector<std::pair<std::string, JOIN>> tests{
+					{
+						":ronni!ronni@ronni.tmi.twitch.tv JOIN #dallas",
+						JOIN{ "ronni", "#dallas" }
+					}
+				};
+			}
+			namespace mode {
+				using Twitch::irc::message::cap::membership::MODE;
+
+				const std::vector<std::pair<std::string, MODE>> tests{
+					{
+						":jtv MODE #dallas +o ronni",
+						MODE{ "#dallas", true, "ronni" }
+					},
+					{
+						":jtv MODE #dallas -o ronni",
+						MODE{ "#dallas", false, "ronni" }
+					}
+				};
+			}
+			namespace names {
+				using Twitch::irc::message::cap::membership::NAMES;
+				using Twitch::irc::message::names_t;
+
+				const std::vector<std::pair<std::string, NAMES>> tests{
+					{
+						":ronni.tmi.twitch.tv 353 ronni = #dallas :ronni fred wilma",
+						NAMES{ "ronni", "353", "#dallas", names_t{ "ronni", "fred", "wilma" } }
+					},
+					{
+						":ronni.tmi.twitch.tv 353 ronni = #dallas :barney betty",
+						NAMES{ "ronni", "353", "#dallas", names_t{ "barney", "betty" } }
+					},
+					{
+						":ronni.tmi.twitch.tv 366 ronni #dallas :End of /NAMES list",
+						NAMES{ "ronni", "366", "#dallas", names_t{} }
+					}
+				};
+			}
+			namespace part {
+				using Twitch::irc::message::cap::membership::PART;
+
+				const std::vector<std::pair<std::string, PART>> tests{
+					{
+						":ronni!ronni@ronni.tmi.twitch.tv PART #dallas",
+						PART{ "ronni", "#dallas" }
+					}
+				};
+			}
+		}
+		namespace tags {
+			namespace clearchat {
+				using Twitch::irc::message::cap::tags::CLEARCHAT;
+
+				const std::vector<std::pair<std::string, CLEARCHAT>> tests{
+					{
+						"@ban-duration=600;room-id=99999999;"
+						"target-user-id=99999999;tmi-sent-ts=1524962471755"
+						" :tmi.twitch.tv CLEARCHAT #channel :nick",
+						CLEARCHAT{
+							Twitch::irc::message::cap::commands::CLEARCHAT{ "#channel", "nick" },
+							std::chrono::seconds{ 600 },
+							std::nullopt,
+							"99999999",
+							"99999999",
+							std::chrono::seconds{ 1524962471755 }
+						}
+					},
+					{
+						"@ban-duration=1;ban-reason=test;room-id=99999999;"
+						"target-user-id=99999999;tmi-sent-ts=1525028799009"
+						" :tmi.twitch.tv CLEARCHAT #channel :nick",
+						CLEARCHAT{
+							Twitch::irc::message::cap::commands::CLEARCHAT{ "#channel", "nick" },
+							std::chrono::seconds{ 1 },
+							"test",
+							"99999999",
+							"99999999",
+							std::chrono::seconds{ 1525028799009 }
+						}
+					}
+				};
+			}
+			namespace globaluserstate {
+				using Twitch::irc::message::cap::tags::GLOBALUSERSTATE;
+				using Twitch::irc::parameters::Color;
+				using Twitch::irc::parameters::NoColor;
+
+				const std::vector<std::pair<std::string, GLOBALUSERSTATE>> tests{
+					{
+						"@badges=;color=#0000FF;display-name=Name;"
+						"emote-sets=0,33563;user-id=99999999;user-type="
+						" :tmi.twitch.tv GLOBALUSERSTATE",
+						GLOBALUSERSTATE{
+							{}, Color{ 0x00, 0x00, 0xFF }, "Name", "0,33563",
+							"99999999", Twitch::irc::message::cap::tags::UserType::empty
+						}
+					}
+				};
+			}
+			namespace privmsg {
+				using Twitch::irc::message::cap::tags::PRIVMSG;
+				using Twitch::irc::parameters::Color;
+				using Twitch::irc::parameters::NoColor;
+				using Twitch::irc::parameters::Badge;
+				using Twitch::irc::parameters::UserType;
+				
+				const std::vector<std::pair<std::string, PRIVMSG>> tests{
+					{
+						"@badges=staff/1,bits/1000;bits=100;color=;display-name=dallas;"
+						"emotes=;id=b34ccfc7-4977-403a-8a94-33c6bac34fb8;"
+						"mod=0;room-id=1337;subscriber=0;tmi-sent-ts=1507246572675;"
+						"turbo=1;user-id=1337;user-type=staff"
+						" :ronni!ronni@ronni.tmi.twitch.tv PRIVMSG #dallas :cheer100",
+						PRIVMSG{
+							Twitch::irc::message::PRIVMSG{ "ronni", "tmi.twitch.tv", "#dallas", "cheer100" },
+							{ { Badge::staff, 1 }, { Badge::bits, 1000 } }, 100, NoColor{}, "dallas",
+							false, "", "b34ccfc7-4977-403a-8a94-33c6bac34fb8",
+							false, "1337", false, std::chrono::seconds{ 1507246572675 },
+							true, "1337", UserType::staff
+						}
+					},
+					{
+						"@badges=broadcaster/1;color=#0000FF;display-name=Nick;"
+						"emote-only=1;emotes=25:0-4,12-16/1902:6-10;id=99999999-9999-9999-9999-999999999999;"
+						"mod=0;room-id=99999999;subscriber=0;tmi-sent-ts=1526424153891;"
+						"turbo=0;user-id=99999999;user-type="
+						" :user!user@user.tmi.twitch.tv PRIVMSG #channel :Kappa Keepo Kappa",
+						PRIVMSG{
+							Twitch::irc::message::PRIVMSG{ "user", "tmi.twitch.tv", "#channel", "Kappa Keepo Kappa" },
+							{ { Badge::broadcaster, 1 } }, 0, Color{ 0x00, 0x00, 0xFF }, "Nick",
+							true, "25:0-4,12-16/1902:6-10", "99999999-9999-9999-9999-999999999999",
+							false, "99999999", false, std::chrono::seconds{ 1526424153891 },
+							false, "99999999", UserType::empty
+						}
+					}
+				};
+			}
+			namespace roomstate {
+				using Twitch::irc::message::cap::tags::ROOMSTATE;
+
+				const std::vector<std::pair<std::string, ROOMSTATE>> tests{
+					{
+						"@broadcaster-lang=;emote-only=0;followers-only=-1;"
+						"r9k=0;rituals=0;room-id=99999999;slow=0;subs-only=0"
+						" :tmi.twitch.tv ROOMSTATE #channel",
+						ROOMSTATE{
+							Twitch::irc::message::cap::commands::ROOMSTATE{ "#channel" },
+							std::nullopt, false, -1, false, "0", "99999999", std::chrono::seconds{ 0 }, false
+						}
+					},
+					{
+						"@room-id=99999999;slow=10 :tmi.twitch.tv ROOMSTATE #channel",
+						ROOMSTATE{
+							Twitch::irc::message::cap::commands::ROOMSTATE{ "#channel" },
+							std::nullopt, std::nullopt, std::nullopt, std::nullopt, std::nullopt, "99999999",
+							std::chrono::seconds{ 10 }, std::nullopt
+						}
+					},
+					{
+						"@room-id=99999999;slow=0 :tmi.twitch.tv ROOMSTATE #channel",
+						ROOMSTATE{
+							Twitch::irc::message::cap::commands::ROOMSTATE{ "#channel" },
+							std::nullopt, std::nullopt, std::nullopt, std::nullopt, std::nullopt,
+							"99999999", std::chrono::seconds{ 0 }, std::nullopt
+						}
+					},
+					{
+						"@followers-only=30;room-id=99999999"
+						" :tmi.twitch.tv ROOMSTATE #channel",
+						ROOMSTATE{
+							Twitch::irc::message::cap::commands::ROOMSTATE{ "#channel" },
+							std::nullopt, std::nullopt, 30, std::nullopt, std::nullopt,
+							"99999999", std::nullopt, std::nullopt
+						}
+					},
+					{
+						"@followers-only=-1;room-id=99999999"
+						" :tmi.twitch.tv ROOMSTATE #channel",
+						ROOMSTATE{
+							Twitch::irc::message::cap::commands::ROOMSTATE{ "#channel" },
+							std::nullopt, std::nullopt, -1, std::nullopt, std::nullopt,
+							"99999999", std::nullopt, std::nullopt
+						}
+					}
+				};
+			}
+			namespace usernotice {
+				using Twitch::irc::message::cap::tags::USERNOTICE;
+				using Twitch::irc::parameters::Color;
+				using Twitch::irc::parameters::NoColor;
+				using Twitch::irc::parameters::Badge;
+				using Twitch::irc::parameters::UserType;
+
+				const std::vector<std::pair<std::string, USERNOTICE>> tests{
+					{
+						"@badges=staff/1,broadcaster/1,turbo/1;color=#008000;display-name=ronni;"
+						"emotes=;id=db25007f-7a18-43eb-9379-80131e44d633;login=ronni;"
+						"mod=0;msg-id=resub;msg-param-months=6;msg-param-sub-plan=Prime;"
+						"msg-param-sub-plan-name=Prime;room-id=1337;subscriber=1;"
+						R"(system-msg=ronni\shas\ssubscribed\sfor\s6\smonths!;)"
+						"tmi-sent-ts=1507246572675;turbo=1;user-id=1337;user-type=staff"
+						" :tmi.twitch.tv USERNOTICE #dallas :Great stream -- keep it up!",
+						USERNOTICE{
+							Twitch::irc::message::cap::commands::USERNOTICE{
+								"#dallas", "Great stream -- keep it up!"
+							},
+							{ {Badge::staff, 1}, {Badge::broadcaster, 1}, {Badge::turbo, 1} },
+							Color{ 0x00, 0x80, 0x00 }, "ronni", "", "db25007f-7a18-43eb-9379-80131e44d633",
+							"ronni", false, USERNOTICE::Sub{ 6, "Prime", "Prime" }, "1337",
+							true, "ronni has subscribed for 6 months!",
+							std::chrono::seconds{ 1507246572675 }, true, "1337", UserType::staff
+						}
+					},
+					{
+						"@badges=staff/1,premium/1;color=#0000FF;display-name=TWW2;"
+						"emotes=;id=e9176cd8-5e22-4684-ad40-ce53c2561c5e;login=tww2;"
+						"mod=0;msg-id=subgift;msg-param-months=1;"
+						"msg-param-recipient-display-name=Mr_Woodchuck;"
+						"msg-param-recipient-id=89614178;msg-param-recipient-name=mr_woodchuck;"
+						R"(msg-param-sub-plan-name=House\sof\sNyoro~n;msg-param-sub-plan=1000;)"
+						"room-id=19571752;subscriber=0;"
+						R"(system-msg=TWW2\sgifted\sa\sTier\s1\ssub\sto\sMr_Woodchuck!;)"
+						"tmi-sent-ts=1521159445153;turbo=0;user-id=13405587;"
+						"user-type=staff :tmi.twitch.tv USERNOTICE #forstycup",
+						USERNOTICE{
+							Twitch::irc::message::cap::commands::USERNOTICE{
+								"#forstycup", ""
+							},
+							// premium badge - wtf??? doc don't say a word about it
+							{ {Badge::staff, 1}, {Badge::unhandled_badge, 1} },
+							Color{ 00, 00, 0xFF }, "TWW2", "", "e9176cd8-5e22-4684-ad40-ce53c2561c5e",
+							"tww2", false,
+							USERNOTICE::Subgift{
+								1, "Mr_Woodchuck", "89614178", "mr_woodchuck",
+								"House of Nyoro~n", "1000"
+							}, "19571752", false, "TWW2 gifted a Tier 1 sub to Mr_Woodchuck!",
+							std::chrono::seconds{ 1521159445153 }, false, "13405587", UserType::staff
+						}
+					},
+					{
+						"@badges=turbo/1;color=#9ACD32;display-name=TestChannel;emotes=;"
+						"id=3d830f12-795c-447d-af3c-ea05e40fbddb;login=testchannel;mod=0;"
+						"msg-id=raid;msg-param-displayName=TestChannel;msg-param-login=testchannel;"
+						"msg-param-viewerCount=15;room-id=56379257;subscriber=0;"
+						R"(system-msg=15\sraiders\sfrom\sTestChannel\shave\sjoined\n!;)"
+						"tmi-sent-ts=1507246572675;turbo=1;user-id=123456;user-type="
+						" :tmi.twitch.tv USERNOTICE #othertestchannel",
+						USERNOTICE{
+							Twitch::irc::message::cap::commands::USERNOTICE{
+								"#othertestchannel", ""
+							},
+							{ {Badge::turbo, 1} },
+							Color{ 0x9A, 0xCD, 0x32 }, "TestChannel", "", "3d830f12-795c-447d-af3c-ea05e40fbddb",
+							"testchannel", false,
+							USERNOTICE::Raid{
+								"TestChannel", "testchannel",  15
+							}, "56379257", false, R"(15 raiders from TestChannel have joined\n!)",
+							std::chrono::seconds{ 1507246572675 }, true, "123456", UserType::empty
+						}
+					},
+					{
+						"@badges=;color=;display-name=SevenTest1;emotes=30259:0-6;"
+						"id=37feed0f-b9c7-4c3a-b475-21c6c6d21c3d;login=seventest1;"
+						"mod=0;msg-id=ritual;msg-param-ritual-name=new_chatter;"
+						R"(room-id=6316121;subscriber=0;system-msg=Seventoes\sis\snew\shere!;)"
+						"tmi-sent-ts=1508363903826;turbo=0;user-id=131260580;"
+						"user-type= :tmi.twitch.tv USERNOTICE #seventoes :HeyGuys",
+						USERNOTICE{
+							Twitch::irc::message::cap::commands::USERNOTICE{
+								"#seventoes", "HeyGuys"
+							},
+							{}, NoColor{},
+							"SevenTest1", "30259:0-6", "37feed0f-b9c7-4c3a-b475-21c6c6d21c3d",
+							"seventest1", false,
+							USERNOTICE::Ritual{},
+							"6316121", false, "Seventoes is new here!",
+							std::chrono::seconds{ 1508363903826 }, false, "131260580", UserType::empty
+						}
+					}
+				};
+			}
+			namespace userstate {
+				using Twitch::irc::message::cap::tags::USERSTATE;
+				using Twitch::irc::parameters::Color;
+				using Twitch::irc::parameters::Badge;
+				using Twitch::irc::parameters::UserType;
+
+				const std::vector<std::pair<std::string, USERSTATE>> tests{
+					{
+						"@badges=broadcaster/1;color=#0000FF;"
+						"display-name=Nick;emote-sets=0,33563;"
+						"mod=0;subscriber=0;user-type="
+						" :tmi.twitch.tv USERSTATE #channel",
+						USERSTATE{
+							Twitch::irc::message::cap::commands::USERSTATE{ "#channel" },
+							{ {Badge::broadcaster, 1} }, Color{ 00, 00, 0xFF}, "Nick", "0,33563",
+							false, false, UserType::empty
+						}
+					}
+				};
+			}
+		}
+		namespace commands {
+			namespace clearchat {
+				using Twitch::irc::message::cap::commands::CLEARCHAT;
+
+				const std::vector<std::pair<std::string, CLEARCHAT>> tests{
+					{
+						":tmi.twitch.tv CLEARCHAT #dallas",
+						CLEARCHAT{ "#dallas", "" }
+					},
+					{
+						":tmi.twitch.tv CLEARCHAT #<channel> :<user>",
+						CLEARCHAT{ "#<channel>", "<user>" }
+					}
+				};
+			}
+			namespace hosttarget {
+				using Twitch::irc::message::cap::commands::HOSTTARGET;
+
+				// TODO: find more rwe
+				const std::vector<std::pair<std::string, HOSTTARGET>> tests{
+					{
+						":tmi.twitch.tv HOSTTARGET #hosting_channel <channel> [0]",
+						HOSTTARGET{ "#hosting_channel", "<channel>", 0 }
+					},
+					{
+						":tmi.twitch.tv HOSTTARGET #hosting :channel -",
+						HOSTTARGET{ "#hosting", "channel", 0 }
+					},
+					{
+						":tmi.twitch.tv HOSTTARGET #hosting_channel :- [0]",
+						HOSTTARGET{ "#hosting_channel", "", 0 }
+					}
+				};
+			}
+			namespace notice {
+				using Twitch::irc::message::cap::commands::NOTICE;
+
+				const std::vector<std::pair<std::string, NOTICE>> tests{
+					{
+						"@msg-id=slow_off :tmi.twitch.tv NOTICE"
+						" #dallas :This room is no longer in slow mode.",
+						NOTICE{ "slow_off", "#dallas", "This room is no longer in slow mode." }
+					}
+				};
+			}
+			namespace reconnect {
+				using Twitch::irc::message::cap::commands::RECONNECT;
+
+				const std::vector<std::pair<std::string, RECONNECT>> tests{
+					{
+						":tmi.twitch.tv RECONNECT",
+						RECONNECT{}
+					}
+				};
+			}
+			namespace roomstate {
+				using Twitch::irc::message::cap::commands::ROOMSTATE;
+
+				const std::vector<std::pair<std::string, ROOMSTATE>> tests{
+					{
+						":tmi.twitch.tv ROOMSTATE #<channel>",
+						ROOMSTATE{ "#<channel>" }
+					}
+				};
+			}
+			namespace usernotice {
+				using Twitch::irc::message::cap::commands::USERNOTICE;
+
+				const std::vector<std::pair<std::string, USERNOTICE>> tests{
+					{
+						":tmi.twitch.tv USERNOTICE #<channel> :message",
+						USERNOTICE{ "#<channel>", "message" }
+					}
+				};
+			}
+			namespace userstate {
+				using Twitch::irc::message::cap::commands::USERSTATE;
+
+				const std::vector<std::pair<std::string, USERSTATE>> tests{
+					{
+						":tmi.twitch.tv USERSTATE #<channel>",
+						USERSTATE{ "#<channel>" }
+					}
+				};
+			}
+		}
+	}
+}
+#endif // !PARSERTESTCASES_H
\ No newline at end of file
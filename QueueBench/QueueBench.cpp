@@ -0,0 +1,230 @@
+#include "stdafx.h"
+#define _SILENCE_ALL_CXX17_DEPRECATION_WARNINGS
+#define _SCL_SECURE_NO_WARNINGS
+#include "..\Twitch_C++_IRC_bot\IRC_Bot.h"
+#include "..\Twitch_C++_IRC_bot\Logger.h"
+#include <boost\log\sources\severity_logger.hpp>
+#include <boost\make_shared.hpp>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+	using bench_clock = std::chrono::steady_clock;
+
+	// previous implementation, kept as the baseline
+	namespace locked {
+		struct MultithreadingRoutine final
+		{
+		public:
+			template<class Pred>
+			MultithreadingRoutine(
+				std::unique_lock<std::mutex>& t_lock,
+				std::condition_variable& t_cv,
+				std::atomic_bool& t_control_value,
+				Pred cv_predicate
+			) :
+				m_lock(t_lock), m_cv(t_cv), m_control_value(t_control_value)
+			{
+				t_cv.wait(m_lock, cv_predicate);
+				m_control_value = false;
+			}
+
+			~MultithreadingRoutine() {
+				m_control_value = true;
+				m_lock.unlock();
+				m_cv.notify_all();
+			}
+
+		private:
+			std::unique_lock<std::mutex>& m_lock;
+			std::condition_variable& m_cv;
+			std::atomic_bool& m_control_value;
+		};
+
+		class MessageQueue
+		{
+		public:
+			void push(std::string message, bool priority = false) {
+				std::unique_lock<std::mutex> lock{ m_mutex };
+				MultithreadingRoutine routine(
+					lock, m_cv, m_ready_for_task,
+					[&]() -> bool { return m_ready_for_task; }
+				);
+
+				try {
+					if (priority) { m_queue.emplace_front(std::move(message)); }
+					else { m_queue.emplace_back(std::move(message)); }
+				} catch (...) {}
+			}
+
+			std::optional<std::string> pop() {
+				std::unique_lock<std::mutex> lock{ m_mutex };
+				MultithreadingRoutine routine(
+					lock, m_cv,
+					m_ready_for_task,
+					[&]() { return !m_queue.empty() && m_ready_for_task; }
+				);
+
+				try {
+					if (m_queue.empty()) { return std::nullopt; }
+
+					std::string value = std::move(m_queue.front());
+					m_queue.pop_front();
+					return std::move(value);
+				} catch (...) {
+					return std::nullopt;
+				}
+			}
+
+		private:
+			std::deque<std::string> m_queue;
+
+			mutable std::mutex m_mutex{};
+			std::condition_variable m_cv{};
+			mutable std::atomic_bool m_ready_for_task{ true };
+		};
+	}
+
+	struct Result
+	{
+		std::string name;
+		std::size_t producers;
+		std::size_t messages;
+		double ns_per_message;
+		double messages_per_sec;
+	};
+
+	// every producer pushes its share, one consumer pops until everything arrived
+	template<class Queue>
+	Result contend(std::string name, std::size_t producers, std::size_t per_producer) {
+		Queue queue;
+		const auto total = producers * per_producer;
+		std::atomic_bool go{ false };
+
+		std::vector<std::thread> threads;
+		for (std::size_t p{ 0 }; p < producers; ++p) {
+			threads.emplace_back([&]() {
+				while (!go) { std::this_thread::yield(); }
+				for (std::size_t i{ 0 }; i < per_producer; ++i) {
+					// every 16th is a PONG-like priority message
+					queue.push("PRIVMSG #channel :command response", i % 16 == 0);
+				}
+			});
+		}
+
+		const auto start = bench_clock::now();
+		go = true;
+
+		std::size_t received{ 0 };
+		while (received < total) {
+			if (auto message = queue.pop(); message) { ++received; }
+		}
+
+		const auto elapsed = std::chrono::duration<double, std::nano>(bench_clock::now() - start);
+		for (auto& thread : threads) { thread.join(); }
+
+		const auto ns = elapsed.count() / static_cast<double>(total);
+		return Result{ std::move(name), producers, total, ns, 1e9 / ns };
+	}
+
+	// what a thread logging a trace line pays, the file is written by whoever the sink makes do it
+	Result log_lines(
+		std::string name,
+		boost::shared_ptr<boost::log::sinks::sink> sink,
+		std::size_t producers,
+		std::size_t per_producer
+	) {
+		using severity = boost::log::trivial::severity_level;
+		const auto total = producers * per_producer;
+		std::atomic_bool go{ false };
+
+		auto core = boost::log::core::get();
+		core->add_sink(sink); // no-op for add_file_log, that one is added already
+
+		std::vector<std::thread> threads;
+		for (std::size_t p{ 0 }; p < producers; ++p) {
+			threads.emplace_back([&]() {
+				boost::log::sources::severity_logger<severity> lg;
+				while (!go) { std::this_thread::yield(); }
+				for (std::size_t i{ 0 }; i < per_producer; ++i) {
+					BOOST_LOG_SEV(lg, severity::trace) << "JOIN #channel user" << i;
+				}
+			});
+		}
+
+		const auto start = bench_clock::now();
+		go = true;
+		for (auto& thread : threads) { thread.join(); }
+		const auto elapsed = std::chrono::duration<double, std::nano>(bench_clock::now() - start);
+
+		core->flush();
+		core->remove_sink(sink);
+
+		const auto ns = elapsed.count() / static_cast<double>(total);
+		return Result{ std::move(name), producers, total, ns, 1e9 / ns };
+	}
+
+	void print_header() {
+		std::cout
+			<< std::left  << std::setw(28) << "benchmark"
+			<< std::right << std::setw(10) << "producers"
+			<< std::right << std::setw(12) << "messages"
+			<< std::right << std::setw(12) << "ns/msg"
+			<< std::right << std::setw(14) << "msgs/sec"
+			<< '\n';
+	}
+
+	void print(const Result& result) {
+		std::cout
+			<< std::left  << std::setw(28) << result.name
+			<< std::right << std::setw(10) << result.producers
+			<< std::right << std::setw(12) << result.messages
+			<< std::fixed << std::setprecision(1)
+			<< std::right << std::setw(12) << result.ns_per_message
+			<< std::setprecision(0)
+			<< std::right << std::setw(14) << result.messages_per_sec
+			<< '\n';
+	}
+}
+
+// usage: QueueBench [messages per producer]
+int main(int argc, char* argv[]) {
+	const std::size_t per_producer = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+
+	print_header();
+	for (const std::size_t producers : { 1, 2, 4, 8 }) {
+		print(contend<locked::MessageQueue>("locked MessageQueue", producers, per_producer));
+		print(contend<Twitch::irc::MessageQueue>("MPSC MessageQueue", producers, per_producer));
+	}
+
+	boost::log::add_common_attributes();
+	boost::log::register_simple_formatter_factory<boost::log::trivial::severity_level, char>("Severity");
+	const auto path = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+	const auto log_messages = per_producer / 10;
+
+	for (const std::size_t producers : { 1, 4 }) {
+		print(log_lines("log, synchronous file", boost::log::add_file_log(
+			boost::log::keywords::file_name = path,
+			boost::log::keywords::format = "[%TimeStamp%] (%LineID%) <%Severity%>: %Message%",
+			boost::log::keywords::auto_flush = true
+		), producers, log_messages));
+
+		Logger::Options options;
+		options.console = false;
+		print(log_lines("log, AsyncSink (drop)", boost::make_shared<Logger::AsyncSink>(options, path), producers, log_messages));
+		options.overflow = Logger::Overflow::block;
+		print(log_lines("log, AsyncSink (block)", boost::make_shared<Logger::AsyncSink>(options, path), producers, log_messages));
+	}
+	boost::filesystem::remove(path);
+	return 0;
+}
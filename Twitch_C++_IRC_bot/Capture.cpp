@@ -0,0 +1,280 @@
+#include "stdafx.h"
+#include "Capture.h"
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+
+namespace Twitch::irc::capture {
+	namespace {
+		constexpr std::size_t max_varint{ 10 }; // 64 bits, 7 per byte
+		constexpr std::size_t read_chunk{ 64 * 1024 };
+
+		std::chrono::nanoseconds::rep to_ns(clock_t::duration duration) {
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+		}
+	}
+
+	Writer::Writer(const std::string& t_path) :
+		m_file(std::fopen(t_path.c_str(), "wb"))
+	{
+		if (!m_file) { throw std::runtime_error{ "capture: can't open " + t_path }; }
+
+		m_buffer.reserve(buffer_size);
+		m_buffer.append(magic);
+		m_buffer.push_back(static_cast<char>(version));
+
+		auto started = static_cast<std::uint64_t>(
+			std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count()
+		);
+		for (int i{ 0 }; i < 8; ++i, started >>= 8) { m_buffer.push_back(static_cast<char>(started & 0xFF)); }
+	}
+
+	Writer::~Writer() {
+		flush();
+		std::fclose(m_file);
+	}
+
+	void Writer::write(clock_t::time_point received, const std::vector<std::string_view>& lines) {
+		if (lines.empty()) { return; }
+
+		std::lock_guard<std::mutex> lock{ m_mutex };
+		received = std::max(received, m_last);
+		const auto delta = static_cast<std::uint64_t>(to_ns(received - m_last));
+		m_last = received;
+
+		put(delta);
+		put(lines.size());
+		for (const auto line : lines) {
+			put(line.size());
+			m_buffer.append(line);
+
+			if (m_buffer.size() >= buffer_size) { write_out(); }
+		}
+		m_records += lines.size();
+	}
+
+	void Writer::flush() {
+		std::lock_guard<std::mutex> lock{ m_mutex };
+		write_out();
+		std::fflush(m_file);
+	}
+
+	std::uint64_t Writer::records() const {
+		std::lock_guard<std::mutex> lock{ m_mutex };
+		return m_records;
+	}
+
+	void Writer::put(std::uint64_t value) {
+		while (value >= 0x80) {
+			m_buffer.push_back(static_cast<char>((value & 0x7F) | 0x80));
+			value >>= 7;
+		}
+		m_buffer.push_back(static_cast<char>(value));
+	}
+
+	void Writer::write_out() {
+		if (m_buffer.empty()) { return; }
+
+		std::fwrite(m_buffer.data(), 1, m_buffer.size(), m_file);
+		m_buffer.clear();
+	}
+
+	Reader::Reader(const std::string& t_path) :
+		m_file(t_path, std::ios::binary)
+	{
+		if (!fill(header_size)
+			|| std::string_view{ m_buffer }.substr(0, magic.size()) != magic
+			|| static_cast<std::uint8_t>(m_buffer[magic.size()]) != version
+		) {
+			throw std::runtime_error{ "capture: " + t_path + " isn't a capture" };
+		}
+
+		std::uint64_t started{ 0 };
+		for (std::size_t i{ header_size }; i-- > magic.size() + 1; ) {
+			started = (started << 8) | static_cast<unsigned char>(m_buffer[i]);
+		}
+		m_started = std::chrono::system_clock::time_point{
+			std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds{ started })
+		};
+		m_pos = header_size;
+	}
+
+	bool Reader::is_capture(const std::string& path) {
+		std::ifstream file{ path, std::ios::binary };
+		std::string head(magic.size(), '\0');
+		return file.read(head.data(), head.size()) && head == magic;
+	}
+
+	std::optional<Record> Reader::next() {
+		if (!m_complete) { return std::nullopt; }
+
+		fill(3 * max_varint); // the last records are shorter than that
+		if (m_pos == m_buffer.size()) {
+			m_complete = m_remaining == 0; // a read cut short
+			return std::nullopt;
+		}
+
+		auto pos = m_pos;
+		const auto first = m_remaining == 0;
+		if (first) {
+			const auto delta = get(pos);
+			const auto count = get(pos);
+			if (!delta || !count || *count == 0) {
+				m_complete = false;
+				return std::nullopt;
+			}
+			m_at += std::chrono::nanoseconds{ *delta };
+			m_remaining = *count;
+		}
+
+		const auto length = get(pos);
+		if (!length || *length > max_line) {
+			m_complete = false;
+			return std::nullopt;
+		}
+
+		const auto head = pos - m_pos;
+		if (!fill(head + *length)) {
+			m_complete = false;
+			return std::nullopt;
+		}
+
+		const Record record{ m_at, std::string_view{ m_buffer.data() + m_pos + head, *length }, first };
+		m_pos += head + *length;
+		--m_remaining;
+		return record;
+	}
+
+	bool Reader::fill(std::size_t needed) {
+		if (m_buffer.size() - m_pos >= needed) { return true; }
+
+		// views handed out before are gone from here on
+		m_buffer.erase(0, m_pos);
+		m_pos = 0;
+
+		while (m_buffer.size() < needed && m_file) {
+			const auto size = m_buffer.size();
+			const auto chunk = std::max(read_chunk, needed - size);
+			m_buffer.resize(size + chunk);
+			m_file.read(m_buffer.data() + size, chunk);
+			m_buffer.resize(size + static_cast<std::size_t>(m_file.gcount()));
+		}
+		return m_buffer.size() >= needed;
+	}
+
+	std::optional<std::uint64_t> Reader::get(std::size_t& pos) const {
+		std::uint64_t value{ 0 };
+		for (unsigned shift{ 0 }; pos < m_buffer.size() && shift < 64; shift += 7) {
+			const auto byte = static_cast<unsigned char>(m_buffer[pos++]);
+			value |= std::uint64_t{ byte & 0x7Fu } << shift;
+			if (!(byte & 0x80)) { return value; }
+		}
+		return std::nullopt;
+	}
+
+	ReplayController::ReplayController(
+		const std::string& t_path,
+		double t_speed,
+		std::vector<std::string> t_channels
+	) :
+		m_reader(t_path),
+		m_speed(t_speed),
+		m_channels(std::move(t_channels)),
+		m_next(m_reader.next())
+	{
+	}
+
+	bool ReplayController::next_batch() {
+		m_lines.clear();
+		m_text.clear();
+		m_ends.clear();
+		m_handed_out = 0;
+		if (!m_next) {
+			m_finished = true;
+			return false;
+		}
+
+		// the record's view dies with the next read, its text is copied first
+		m_at = m_next->at;
+		do {
+			m_text.append(m_next->line);
+			m_ends.push_back(m_text.size());
+			m_next = m_reader.next();
+		} while (m_next && !m_next->first);
+
+		std::size_t begin{ 0 };
+		for (const auto end : m_ends) {
+			m_lines.emplace_back(m_text.data() + begin, end - begin);
+			begin = end;
+		}
+
+		m_metrics.bytes_read.add(m_text.size() + m_lines.size() * Controller::m_delimiter.size());
+		m_metrics.lines_read.add(m_lines.size());
+		return true;
+	}
+
+	clock_t::time_point ReplayController::due() {
+		const auto now = clock_t::now();
+		if (!m_origin) { m_origin.emplace(now, m_at); }
+		if (m_speed <= as_fast_as_possible) { return now; }
+
+		const auto recorded = std::chrono::duration<double, std::nano>(m_at - m_origin->second);
+		return m_origin->first + std::chrono::duration_cast<clock_t::duration>(recorded / m_speed);
+	}
+
+	std::pair<error_code_t, std::string> ReplayController::read() {
+		if (m_handed_out == m_lines.size()) {
+			if (!next_batch()) { return { boost::asio::error::eof, {} }; }
+			std::this_thread::sleep_until(due());
+		}
+		return { error_code_t{}, std::string{ m_lines[m_handed_out++] } };
+	}
+
+	error_code_t ReplayController::read_lines(std::vector<std::string_view>& lines) {
+		lines.clear();
+		if (!next_batch()) { return boost::asio::error::eof; }
+
+		std::this_thread::sleep_until(due());
+		lines.assign(m_lines.begin(), m_lines.end());
+		m_handed_out = m_lines.size();
+		return {};
+	}
+
+	error_code_t ReplayController::write(const std::string& message) {
+		m_metrics.bytes_written.add(message.size() + Controller::m_delimiter.size());
+		m_metrics.lines_written.add();
+		return {};
+	}
+
+	void ReplayController::enqueue(std::string message, bool) {
+		write(message);
+	}
+
+	metrics::ConnectionMetrics::Snapshot ReplayController::connection_metrics() const {
+		return m_metrics.snapshot(0);
+	}
+
+	void ReplayController::async_read(read_handler_t handler) {
+		if (!next_batch()) {
+			boost::asio::post(m_io_service, [this, handler = std::move(handler)]() {
+				handler(boost::asio::error::eof, m_lines);
+			});
+			return;
+		}
+
+		// a due time in the past still goes through the io_service, reads never nest
+		m_timer.expires_at(due());
+		m_timer.async_wait([this, handler = std::move(handler)](const error_code_t& error) {
+			handler(error, m_lines);
+		});
+	}
+
+	void ReplayController::run() {
+		m_io_service.restart();
+		m_io_service.run();
+	}
+
+	void ReplayController::stop() {
+		m_io_service.stop();
+	}
+} // namespace Twitch::irc::capture
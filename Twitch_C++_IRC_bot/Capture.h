@@ -0,0 +1,161 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+#include "IRC_Bot.h"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+/// raw IRC traffic as it was read, for load tests and reproducing incidents offline
+///
+/// file layout, integers are little endian:
+///   header  "TWIRCAP" version(1 byte) started(8 bytes, system_clock ns since epoch)
+///   read    delta(varint) count(varint), then count records
+///   record  length(varint) line(length bytes, without CRLF)
+/// delta is steady_clock ns since the previous read, reads of racing shards may share a time,
+/// varints are LEB128, so a chat line costs 1-2 bytes on top of its text
+namespace Twitch::irc::capture {
+	using clock_t = std::chrono::steady_clock;
+
+	inline constexpr std::string_view magic{ "TWIRCAP" };
+	inline constexpr std::uint8_t version{ 2 };
+	inline constexpr std::size_t header_size{ 16 };
+	inline constexpr std::size_t max_line{ 1024 * 1024 }; // anything longer is taken for a corrupt file
+
+	/// appends whole read batches, threadsafe so shards can share one file
+	/// records go through a 64 KiB buffer, a crash loses at most what is still in it
+	class Writer
+	{
+	public:
+		static constexpr std::size_t buffer_size = 64 * 1024;
+
+		explicit Writer(const std::string& t_path); // truncates, throws std::runtime_error if it can't
+		~Writer(); // flushes
+
+		Writer(const Writer&) = delete;
+		Writer& operator=(const Writer&) = delete;
+
+		// lines of one read, received is when the read completed
+		void write(clock_t::time_point received, const std::vector<std::string_view>& lines);
+		void flush();
+
+		std::uint64_t records() const;
+
+	private:
+		void put(std::uint64_t value); // varint, m_mutex has to be held
+		void write_out();             // m_mutex has to be held
+
+		std::FILE* m_file;
+		std::string m_buffer;
+		const clock_t::time_point m_started{ clock_t::now() };
+		clock_t::time_point m_last{ m_started }; // never goes back, shards may race
+		std::uint64_t m_records{ 0 };
+		mutable std::mutex m_mutex;
+	};
+
+	struct Record
+	{
+		std::chrono::nanoseconds at; // since the capture was started
+		std::string_view line;       // valid until the next Reader::next()
+		bool first;                  // of the lines of its read
+	};
+
+	/// reads records in 64 KiB chunks, memory stays flat whatever the size of the capture
+	class Reader
+	{
+	public:
+		explicit Reader(const std::string& t_path); // throws std::runtime_error if it's not a capture
+		static bool is_capture(const std::string& path);
+
+		// nullopt at the end, or at the first truncated or corrupt record
+		std::optional<Record> next();
+		// false if next() stopped before the end of the file
+		inline bool complete() const noexcept { return m_complete; }
+
+		inline std::chrono::system_clock::time_point started() const noexcept { return m_started; }
+
+	private:
+		bool fill(std::size_t needed); // at least needed unread bytes, false at the end of the file
+		std::optional<std::uint64_t> get(std::size_t& pos) const; // varint at pos, advances it
+
+		std::ifstream m_file;
+		std::string m_buffer;
+		std::size_t m_pos{ 0 }; // first unread byte of m_buffer
+		std::chrono::nanoseconds m_at{ 0 };
+		std::uint64_t m_remaining{ 0 }; // records left in the current read
+		std::chrono::system_clock::time_point m_started;
+		bool m_complete{ true };
+	};
+
+	/// plays a capture back as a connection, TwitchBot runs over it like over a socket
+	/// every recorded read is delivered as one batch, spaced out like it was recorded divided by speed
+	/// writes are counted and dropped, nothing leaves the process
+	class ReplayController : public IAsyncController
+	{
+	public:
+		static constexpr double as_fast_as_possible = 0.0;
+
+		ReplayController(
+			const std::string& t_path,
+			double t_speed = 1.0,                    // 2.0 plays twice as fast, as_fast_as_possible doesn't wait
+			std::vector<std::string> t_channels = {} // set up like the recorded connection, for per channel state
+		);
+
+		error_code_t connect() override { return {}; }
+		error_code_t login() override { return {}; }
+		error_code_t join_channel() override { return {}; }
+		error_code_t join_channel(const std::string&) override { return {}; }
+		error_code_t part_channel(const std::string&) override { return {}; }
+		std::vector<std::string> channels() const override { return m_channels; }
+		error_code_t cap_req(const std::string&) override { return {}; }
+		error_code_t reconnect() override { return {}; }
+		bool is_alive() const noexcept override { return !m_finished; }
+		void set_moderator(std::string_view, bool) override {}
+		void share_join_budget(std::shared_ptr<SharedTokenBucket>) override {}
+		void share_message_budget(std::shared_ptr<MessageBudget>) override {}
+
+		std::pair<error_code_t, std::string> read() override; // one line per call, like Controller::read
+		error_code_t read_lines(std::vector<std::string_view>& lines) override;
+		error_code_t write(const std::string& message) override;
+		void enqueue(std::string message, bool priority) override;
+		void wait_for_work(std::chrono::milliseconds timeout) override { std::this_thread::sleep_for(timeout); }
+		metrics::ConnectionMetrics::Snapshot connection_metrics() const override;
+
+		void async_read(read_handler_t handler) override;
+		void run() override;
+		void stop() override;
+
+		inline const Reader& reader() const noexcept { return m_reader; }
+
+	private:
+		bool next_batch();          // false at the end of the capture
+		clock_t::time_point due();  // when the batch in m_lines was read, scaled by speed
+
+		Reader m_reader;
+		const double m_speed;
+		const std::vector<std::string> m_channels;
+
+		std::optional<Record> m_next;   // first record of the following batch
+		std::chrono::nanoseconds m_at{ 0 }; // of the batch in m_lines
+		std::optional<std::pair<clock_t::time_point, std::chrono::nanoseconds>> m_origin; // first batch delivered
+		std::string m_text;             // lines of the current batch
+		std::vector<std::size_t> m_ends; // of every line in m_text
+		std::vector<std::string_view> m_lines;
+		std::size_t m_handed_out{ 0 };  // lines of m_lines read() returned
+		std::atomic_bool m_finished{ false };
+
+		metrics::ConnectionMetrics m_metrics{};
+
+		io_service_t m_io_service;
+		boost::asio::steady_timer m_timer{ m_io_service };
+	};
+} // namespace Twitch::irc::capture
+#endif // CAPTURE_H
@@ -3,45 +3,272 @@
 #define _SCL_SECURE_NO_WARNINGS
 #include "IRC_Bot.h"
 #include "TwitchMessage.h"
+#include "Capture.h"
 #include "Logger.h"
 #include <boost\algorithm\string.hpp>
 #include <boost\algorithm\string\predicate.hpp>
+#include <algorithm>
 #include <iostream>
+#include <limits>
 #include <thread>
 #include <regex>
+#include <set>
 #include <optional>
+#include <utility>
 
 namespace Twitch::irc {
 	void MessageQueue::push(std::string message, bool priority) {
-		std::unique_lock<std::mutex> lock{ m_mutex };
-		MultithreadingRoutine routine(
-			lock, m_cv, m_ready_for_task,
-			[&]() -> bool { return m_ready_for_task; }
-		);
+		m_size.fetch_add(1, std::memory_order_relaxed);
+		if (priority) { m_priority.push(std::move(message)); }
+		else { m_queue.push(std::move(message)); }
 
-		try {
-			if (priority) { m_queue.emplace_front(std::move(message)); }
-			else { m_queue.emplace_back(std::move(message)); }
-		} catch (...) {}
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (m_sleeping.load(std::memory_order_relaxed)) {
+			std::lock_guard<std::mutex> lock{ m_mutex };
+			m_cv.notify_one();
+		}
 	}
 
-	std::optional<std::string> MessageQueue::pop() {
+	std::optional<std::string> MessageQueue::try_pop() {
+		auto message = m_priority.pop();
+		if (!message) { message = m_queue.pop(); }
+		if (message) { m_size.fetch_sub(1, std::memory_order_relaxed); }
+		return message;
+	}
+
+	std::optional<std::string> MessageQueue::pop(std::chrono::milliseconds timeout) {
+		// short back-off first, parking costs producers a lock and a notify
+		for (int spin{ 0 }; spin < 64; ++spin) {
+			if (auto message = try_pop(); message) { return message; }
+			std::this_thread::yield();
+		}
+
 		std::unique_lock<std::mutex> lock{ m_mutex };
-		MultithreadingRoutine routine(
-			lock, m_cv,
-			m_ready_for_task,
-			[&]() { return !m_queue.empty() && m_ready_for_task; }
-		);
+		m_sleeping.store(true, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+
+		m_cv.wait_for(lock, timeout, [&]() { return !m_priority.empty() || !m_queue.empty(); });
+		m_sleeping.store(false, std::memory_order_relaxed);
+
+		return try_pop();
+	}
+
+	TokenBucket::TokenBucket(std::size_t t_capacity, clock_t::duration t_period) noexcept
+		: m_capacity(static_cast<double>(t_capacity)),
+		m_period(t_period),
+		m_tokens(static_cast<double>(t_capacity))
+	{
+	}
+
+	void TokenBucket::refill(clock_t::time_point now) noexcept {
+		if (now <= m_last) { return; }
+
+		const auto elapsed = std::chrono::duration<double>(now - m_last) / m_period;
+		m_tokens = std::min(m_capacity, m_tokens + elapsed * m_capacity);
+		m_last = now;
+	}
+
+	bool TokenBucket::try_consume(clock_t::time_point now) noexcept {
+		refill(now);
+		if (m_tokens < 1.0) { return false; }
+
+		m_tokens -= 1.0;
+		return true;
+	}
 
-		try {
-			if (m_queue.empty()) { return std::nullopt; }
+	TokenBucket::clock_t::duration TokenBucket::time_to_token(clock_t::time_point now) noexcept {
+		refill(now);
+		if (m_tokens >= 1.0) { return clock_t::duration::zero(); }
 
-			std::string value = std::move(m_queue.front());
-			m_queue.pop_front();
-			return std::move(value);
-		} catch (...) {
-			return std::nullopt;
+		const auto missing = (1.0 - m_tokens) / m_capacity;
+		return std::chrono::duration_cast<clock_t::duration>(m_period * missing) + clock_t::duration{ 1 };
+	}
+
+	void TokenBucket::set_capacity(std::size_t t_capacity, clock_t::time_point now) noexcept {
+		refill(now);
+		const auto capacity = static_cast<double>(t_capacity);
+		// a bigger window only adds to what's left of the current one
+		m_tokens = std::min(capacity, m_tokens + std::max(0.0, capacity - m_capacity));
+		m_capacity = capacity;
+	}
+
+	SharedTokenBucket::SharedTokenBucket(std::size_t t_capacity, clock_t::duration t_period) noexcept
+		: m_bucket(t_capacity, t_period)
+	{
+	}
+
+	bool SharedTokenBucket::try_consume(clock_t::time_point now) {
+		std::lock_guard<std::mutex> lock{ m_mutex };
+		return m_bucket.try_consume(now);
+	}
+
+	SharedTokenBucket::clock_t::duration SharedTokenBucket::time_to_token(clock_t::time_point now) {
+		std::lock_guard<std::mutex> lock{ m_mutex };
+		return m_bucket.time_to_token(now);
+	}
+
+	MessageBudget::MessageBudget(std::size_t t_user, std::size_t t_total, clock_t::duration t_period) noexcept
+		: m_user(t_user, t_period),
+		m_total(t_total, t_period)
+	{
+	}
+
+	bool MessageBudget::try_consume(bool moderator, clock_t::time_point now) {
+		std::lock_guard<std::mutex> lock{ m_mutex };
+		if (m_total.time_to_token(now) != clock_t::duration::zero()) { return false; }
+		if (!moderator && !m_user.try_consume(now)) { return false; }
+		return m_total.try_consume(now);
+	}
+
+	MessageBudget::clock_t::duration MessageBudget::time_to_token(bool moderator, clock_t::time_point now) {
+		std::lock_guard<std::mutex> lock{ m_mutex };
+		const auto total = m_total.time_to_token(now);
+		return moderator ? total : std::max(total, m_user.time_to_token(now));
+	}
+
+	RateLimiter::Lane RateLimiter::classify(std::string_view message) noexcept {
+		using namespace std::string_view_literals;
+		const auto command = message.substr(0, message.find(' '));
+
+		if (command == "PRIVMSG"sv) { return Lane::message; }
+		if (command == "JOIN"sv) { return Lane::join; }
+		if (command == "PONG"sv || command == "PASS"sv ||
+			command == "NICK"sv || command == "CAP"sv ||
+			command == "PART"sv) { return Lane::immediate; }
+
+		return Lane::message;
+	}
+
+	std::string_view RateLimiter::channel_of(std::string_view message) noexcept {
+		auto begin = message.find(' ');
+		if (begin == std::string_view::npos) { return {}; }
+		if (begin + 1 < message.size() && message[begin + 1] == ':') { ++begin; } // JOIN/PART :#channel
+
+		if (begin + 1 >= message.size() || message[begin + 1] != '#') { return {}; }
+
+		const auto channel = message.substr(begin + 1);
+		return channel.substr(0, channel.find(' '));
+	}
+
+	RateLimiter::ChannelLane& RateLimiter::lane(std::string_view channel) {
+		if (auto pos = m_channels.find(channel); pos != m_channels.end()) { return pos->second; }
+		return m_channels.emplace(std::string{ channel }, ChannelLane{}).first->second;
+	}
+
+	std::string RateLimiter::take_join() {
+		std::string join = std::move(m_joins.front());
+		m_joins.pop_front();
+		--lane(channel_of(join)).joins;
+		return join;
+	}
+
+	void RateLimiter::push(std::string message, bool priority) {
+		const auto kind = classify(message);
+		std::lock_guard<std::mutex> lock{ m_mutex };
+
+		if (kind == Lane::join) { ++lane(channel_of(message)).joins; }
+		auto& queue = kind == Lane::immediate ? m_immediate
+			: kind == Lane::join ? m_joins
+			: lane(channel_of(message)).queue;
+		if (priority) { queue.emplace_front(std::move(message)); }
+		else { queue.emplace_back(std::move(message)); }
+	}
+
+	void RateLimiter::requeue(std::string message) {
+		push(std::move(message), true);
+	}
+
+	std::optional<std::string> RateLimiter::pop(clock_t::time_point now) {
+		std::lock_guard<std::mutex> lock{ m_mutex };
+
+		const auto take = [](std::deque<std::string>& queue) {
+			std::string value = std::move(queue.front());
+			queue.pop_front();
+			return value;
+		};
+
+		if (!m_immediate.empty()) { return take(m_immediate); }
+		if (!m_joins.empty() && m_join_bucket->try_consume(now)) { return take_join(); }
+
+		// start right after the channel served last, so a busy one can't starve the others
+		auto pos = m_channels.upper_bound(m_last_served);
+		for (std::size_t i{ 0 }; i < m_channels.size(); ++i, ++pos) {
+			if (pos == m_channels.end()) { pos = m_channels.begin(); }
+
+			auto& [channel, channel_lane] = *pos;
+			if (!channel_lane.queue.empty() && !channel_lane.joins
+				&& m_message_budget->try_consume(channel_lane.moderator, now)) {
+				m_last_served = channel;
+				return take(channel_lane.queue);
+			}
+		}
+
+		return std::nullopt;
+	}
+
+	std::optional<RateLimiter::clock_t::duration> RateLimiter::next_release(clock_t::time_point now) {
+		std::lock_guard<std::mutex> lock{ m_mutex };
+
+		if (!m_immediate.empty()) { return clock_t::duration::zero(); }
+
+		std::optional<clock_t::duration> wait;
+		const auto earliest = [&](clock_t::duration candidate) {
+			wait = wait ? std::min(*wait, candidate) : candidate;
+		};
+
+		if (!m_joins.empty()) { earliest(m_join_bucket->time_to_token(now)); }
+
+		// the account's budget is the same for every lane, ask it once per kind of channel
+		std::optional<clock_t::duration> user, moderator;
+		for (auto& [channel, channel_lane] : m_channels) {
+			// a lane waiting for its JOIN is released with it
+			if (channel_lane.queue.empty() || channel_lane.joins) { continue; }
+
+			auto& budget = channel_lane.moderator ? moderator : user;
+			if (!budget) {
+				budget = m_message_budget->time_to_token(channel_lane.moderator, now);
+				earliest(*budget);
+			}
 		}
+		return wait;
+	}
+
+	void RateLimiter::reconnect(const std::vector<std::string>& handshake) {
+		std::lock_guard<std::mutex> lock{ m_mutex };
+		m_immediate.clear();
+		m_joins.clear();
+		for (auto& [channel, channel_lane] : m_channels) { channel_lane.joins = 0; }
+
+		for (const auto& message : handshake) {
+			if (classify(message) == Lane::join) {
+				++lane(channel_of(message)).joins;
+				m_joins.push_back(message);
+			}
+			else { m_immediate.push_back(message); }
+		}
+	}
+
+	std::size_t RateLimiter::pending() const {
+		std::lock_guard<std::mutex> lock{ m_mutex };
+
+		auto count = m_immediate.size() + m_joins.size();
+		for (const auto& [channel, channel_lane] : m_channels) { count += channel_lane.queue.size(); }
+		return count;
+	}
+
+	void RateLimiter::set_moderator(std::string_view channel, bool moderator) {
+		std::lock_guard<std::mutex> lock{ m_mutex };
+		lane(channel).moderator = moderator;
+	}
+
+	void RateLimiter::share_join_budget(std::shared_ptr<SharedTokenBucket> budget) {
+		std::lock_guard<std::mutex> lock{ m_mutex };
+		m_join_bucket = std::move(budget);
+	}
+
+	void RateLimiter::share_message_budget(std::shared_ptr<MessageBudget> budget) {
+		std::lock_guard<std::mutex> lock{ m_mutex };
+		m_message_budget = std::move(budget);
 	}
 
 	using namespace std::string_literals;
@@ -51,38 +278,345 @@ namespace Twitch::irc {
 		return cmd_indicator.size() + 3;
 	}
 
-	Commands::cmd_handle_t Commands::find(const std::string& key) const {
-		std::lock_guard<std::mutex> lock{ m_mutex };
-		const auto pos = m_commands.find(key);
+	std::unique_ptr<const Commands::Table> Commands::Table::build(entries_t t_entries) {
+		auto table = std::make_unique<Table>();
+		table->entries = std::move(t_entries);
 
-		if (pos == m_commands.end()) { return nullptr; }
+		std::size_t size{ 1 };
+		while (size < table->entries.size() * 2) { size <<= 1; }
 
-		return pos->second;
+		for (std::uint64_t seed{ 0 }; ; ++seed) {
+			if (seed != 0 && seed % 64 == 0) { size <<= 1; } // too crowded, give it more room
+
+			std::vector<std::uint32_t> slots(size, 0);
+			bool collision{ false };
+			for (std::size_t i{ 0 }; i < table->entries.size() && !collision; ++i) {
+				auto& slot = slots[seeded_hash(table->entries[i].first, seed) & (size - 1)];
+				collision = slot != 0;
+				slot = static_cast<std::uint32_t>(i + 1);
+			}
+
+			if (!collision) {
+				table->slots = std::move(slots);
+				table->seed = seed;
+				table->mask = size - 1;
+				return table;
+			}
+		}
 	}
 
-	Commands::Commands(std::initializer_list<value_type> init)
-		: m_commands(init)
-	{
+	const Commands::cmd_handle_t* Commands::Table::find(std::string_view key) const noexcept {
+		const auto index = slots[seeded_hash(key, seed) & mask];
+		if (index == 0) { return nullptr; }
+
+		const auto& entry = entries[index - 1];
+		return entry.first == key ? &entry.second : nullptr;
+	}
+
+	namespace { // epoch based reclamation of command tables
+		constexpr std::uint64_t unpinned = std::numeric_limits<std::uint64_t>::max();
+
+		std::atomic<std::uint64_t> global_epoch{ 1 };
+
+		// epoch every thread that ever pinned announced, unpinned while it isn't reading
+		struct PinRegistry
+		{
+			std::mutex mutex;
+			std::vector<const std::atomic<std::uint64_t>*> epochs;
+		};
+
+		PinRegistry& pin_registry() {
+			static auto* registry = new PinRegistry{}; // never destroyed, threads may exit after main
+			return *registry;
+		}
+
+		struct ThreadPin
+		{
+			ThreadPin() {
+				auto& registry = pin_registry();
+				std::lock_guard<std::mutex> lock{ registry.mutex };
+				registry.epochs.push_back(&epoch);
+			}
+			~ThreadPin() {
+				auto& registry = pin_registry();
+				std::lock_guard<std::mutex> lock{ registry.mutex };
+				registry.epochs.erase(std::find(registry.epochs.begin(), registry.epochs.end(), &epoch));
+			}
+
+			alignas(64) std::atomic<std::uint64_t> epoch{ unpinned }; // written by its own thread only
+			std::size_t depth{ 0 };
+		};
+
+		ThreadPin& thread_pin() {
+			thread_local ThreadPin pin; // registers on the first pin of the thread
+			return pin;
+		}
+
+		// oldest epoch a pinned thread may still be reading in, unpinned if there is none
+		std::uint64_t oldest_pin() {
+			auto& registry = pin_registry();
+			std::lock_guard<std::mutex> lock{ registry.mutex };
+
+			auto oldest = unpinned;
+			for (const auto* epoch : registry.epochs) { oldest = std::min(oldest, epoch->load()); }
+			return oldest;
+		}
 	}
 
-	Commands::Commands(const Commands& c)
-		: m_commands(c.m_commands)
+	struct Commands::Retired
 	{
+		std::mutex mutex;
+		std::vector<std::pair<std::uint64_t, std::unique_ptr<const Table>>> tables;
+		std::atomic<std::size_t> count{ 0 }; // tables.size(), read without the lock
+	};
+
+	Commands::Retired& Commands::retired_tables() {
+		static auto* retired = new Retired{}; // never destroyed, pins may be released after main
+		return *retired;
+	}
+
+	Commands::Pin::Pin() noexcept {
+		auto& pin = thread_pin();
+		if (pin.depth++ != 0) { return; }
+
+		pin.epoch.store(global_epoch.load());
+		// the announced epoch is visible before any table is loaded
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+	}
+
+	Commands::Pin::~Pin() {
+		auto& pin = thread_pin();
+		if (--pin.depth != 0) { return; }
+
+		pin.epoch.store(unpinned, std::memory_order_release);
+		// the last reader of a table frees it, no need to wait for the next change
+		if (retired_tables().count.load(std::memory_order_relaxed) != 0) { reclaim(); }
+	}
+
+	const Commands::cmd_handle_t* Commands::find(std::string_view key) const noexcept {
+		return m_table.load(std::memory_order_acquire)->find(key);
+	}
+
+	Commands::entries_t Commands::entries() const {
+		return m_table.load(std::memory_order_relaxed)->entries;
+	}
+
+	void Commands::reclaim() noexcept {
+		auto& retired = retired_tables();
+		std::unique_lock<std::mutex> lock{ retired.mutex, std::try_to_lock };
+		if (!lock) { return; } // whoever holds it sweeps, or the next release does
+
+		const auto oldest = oldest_pin();
+		retired.tables.erase(
+			std::remove_if(retired.tables.begin(), retired.tables.end(),
+				[&](const auto& table) { return table.first < oldest; }),
+			retired.tables.end()
+		);
+		retired.count.store(retired.tables.size(), std::memory_order_relaxed);
+	}
+
+	void Commands::publish(entries_t t_entries) {
+		std::unique_ptr<const Table> old{ m_table.exchange(Table::build(std::move(t_entries)).release()) };
+		if (old) {
+			auto& retired = retired_tables();
+			std::lock_guard<std::mutex> lock{ retired.mutex };
+			// a pin announcing a later epoch loads the new table
+			retired.tables.emplace_back(global_epoch.fetch_add(1), std::move(old));
+			retired.count.store(retired.tables.size(), std::memory_order_relaxed);
+		}
+		reclaim();
+	}
+
+	std::size_t Commands::retired() {
+		return retired_tables().count.load(std::memory_order_relaxed);
+	}
+
+	void Commands::insert_or_assign(std::string key, cmd_handle_t handle) {
+		std::lock_guard<std::mutex> lock{ m_mutex };
+		auto updated = entries();
+
+		const auto pos = std::find_if(updated.begin(), updated.end(),
+			[&](const auto& entry) { return entry.first == key; });
+		if (pos != updated.end()) { pos->second = std::move(handle); }
+		else { updated.emplace_back(std::move(key), std::move(handle)); }
+
+		publish(std::move(updated));
+	}
+
+	bool Commands::erase(std::string_view key) {
+		std::lock_guard<std::mutex> lock{ m_mutex };
+		auto updated = entries();
+
+		const auto pos = std::find_if(updated.begin(), updated.end(),
+			[&](const auto& entry) { return entry.first == key; });
+		if (pos == updated.end()) { return false; }
+
+		updated.erase(pos);
+		publish(std::move(updated));
+		return true;
+	}
+
+	Commands::Commands(std::initializer_list<value_type> init) {
+		entries_t unique;
+		for (const auto& command : init) { // first one wins, like std::map
+			const auto duplicate = std::any_of(unique.begin(), unique.end(),
+				[&](const auto& entry) { return entry.first == command.first; });
+			if (!duplicate) { unique.emplace_back(command.first, command.second); }
+		}
+		publish(std::move(unique));
+	}
+
+	Commands::Commands(const Commands& c) {
+		std::lock_guard<std::mutex> lock{ c.m_mutex };
+		publish(c.entries());
 	}
 
 	Commands& Commands::operator=(const Commands& c) {
-		m_commands = c.m_commands;
+		if (this == &c) { return *this; }
+
+		std::scoped_lock lock{ m_mutex, c.m_mutex };
+		publish(c.entries());
 		return *this;
 	}
 
+	Commands::~Commands() {
+		delete m_table.load(std::memory_order_relaxed); // nobody reads a table of a dead Commands
+		reclaim();
+	}
+
+	Channels::Channels(std::shared_ptr<Commands> t_default_commands)
+		: m_default_commands(std::move(t_default_commands))
+	{
+	}
+
+	ChannelState& Channels::add(std::string_view channel) {
+		if (auto* state = find(channel); state) { return *state; }
+		return m_channels.emplace(
+			std::string{ channel },
+			ChannelState{ m_default_commands, {}, false }
+		).first->second;
+	}
+
+	ChannelState* Channels::find(std::string_view channel) noexcept {
+		const auto pos = m_channels.find(channel);
+		return pos == m_channels.end() ? nullptr : &pos->second;
+	}
+
+	void Channels::set_commands(std::string_view channel, std::shared_ptr<Commands> commands) {
+		add(channel).commands = commands ? std::move(commands) : m_default_commands;
+	}
+
+	const std::shared_ptr<Commands>& Channels::commands(std::string_view channel) const noexcept {
+		const auto pos = m_channels.find(channel);
+		return pos == m_channels.end() ? m_default_commands : pos->second.commands;
+	}
+
+	namespace {
+		thread_local BatchArena* current_arena{ nullptr };
+	}
+
+	BatchArena::BatchArena() :
+		m_buffer(std::make_unique<std::byte[]>(initial_size)),
+		m_resource(m_buffer.get(), initial_size, std::pmr::new_delete_resource())
+	{}
+
+	BatchArena* BatchArena::current() noexcept {
+		return current_arena;
+	}
+
+	std::pmr::memory_resource* BatchArena::resource() noexcept {
+		return current_arena ? current_arena->get() : std::pmr::get_default_resource();
+	}
+
+	BatchArena::Scope::Scope(BatchArena& t_arena) noexcept :
+		m_arena(t_arena), m_previous(current_arena)
+	{
+		current_arena = &m_arena;
+	}
+
+	BatchArena::Scope::~Scope() {
+		current_arena = m_previous;
+		m_arena.m_resource.release(); // back to the initial buffer
+	}
+
+	CommandExecutor::CommandExecutor(
+		std::size_t t_threads,
+		std::size_t t_capacity,
+		Overflow t_overflow
+	) :
+		m_capacity(std::max<std::size_t>(t_capacity, 1)),
+		m_overflow(t_overflow)
+	{
+		const auto threads = std::max<std::size_t>(t_threads, 1);
+		m_workers.reserve(threads);
+		for (std::size_t i{ 0 }; i < threads; ++i) {
+			m_workers.emplace_back([this]() { work(); });
+		}
+	}
+
+	CommandExecutor::~CommandExecutor() {
+		{
+			std::lock_guard<std::mutex> lock{ m_mutex };
+			m_stop = true;
+		}
+		m_not_empty.notify_all();
+		m_not_full.notify_all();
+
+		for (auto& worker : m_workers) { worker.join(); }
+	}
+
+	bool CommandExecutor::submit(task_t task) {
+		{
+			std::unique_lock<std::mutex> lock{ m_mutex };
+			if (m_overflow == Overflow::block) {
+				m_not_full.wait(lock, [&]() { return m_stop || m_tasks.size() < m_capacity; });
+			}
+
+			if (m_stop || m_tasks.size() >= m_capacity) {
+				++m_rejected;
+				return false;
+			}
+
+			m_tasks.emplace_back(std::move(task));
+			m_queued = m_tasks.size();
+		}
+		m_not_empty.notify_one();
+		return true;
+	}
+
+	CommandExecutor::Stats CommandExecutor::stats() const noexcept {
+		return { m_queued.load(), m_running.load(), m_rejected.load(), m_completed.load() };
+	}
+
+	void CommandExecutor::work() {
+		while (true) {
+			task_t task;
+			{
+				std::unique_lock<std::mutex> lock{ m_mutex };
+				m_not_empty.wait(lock, [&]() { return m_stop || !m_tasks.empty(); });
+				if (m_tasks.empty()) { return; } // stopped and drained
+
+				task = std::move(m_tasks.front());
+				m_tasks.pop_front();
+				m_queued = m_tasks.size();
+				++m_running;
+			}
+			m_not_full.notify_one();
+
+			try { task(); } catch (...) {} // a broken command must not take the worker down
+
+			--m_running;
+			++m_completed;
+		}
+	}
+
 	WritingThread::WritingThread(std::shared_ptr<IRCWriter> t_writer)
 		: m_writer(t_writer),
 		m_writing_thread(
 			[&](std::shared_ptr<IRCWriter> writer) {
 				while (!m_terminate) {
-					if (auto response = writer->get_message_queue()->pop()) {
-						writer->write(response.value());
-					}
+					writer->wait_for_work(std::chrono::milliseconds{ 100 });
+					writer->flush();
 				}
 			},
 			m_writer
@@ -99,17 +633,15 @@ namespace Twitch::irc {
 	Controller::Controller(
 		std::string t_server,
 		std::string t_port,
-		std::string t_channel,
+		std::vector<std::string> t_channels,
 		std::string t_nick,
-		std::string t_pass,
-		std::chrono::milliseconds t_write_delay
+		std::string t_pass
 	) :
 		m_server(std::move(t_server)),
 		m_port(std::move(t_port)),
-		m_channel(std::move(t_channel)),
+		m_channels(std::move(t_channels)),
 		m_nick(std::move(t_nick)),
-		m_pass(std::move(t_pass)),
-		m_write_delay(t_write_delay)
+		m_pass(std::move(t_pass))
 	{
 	}
 
@@ -144,7 +676,38 @@ namespace Twitch::irc {
 
 	error_code_t Controller::join_channel() {
 		using namespace std::string_literals;
-		return this->write("JOIN :"s + this->m_channel);
+		for (const auto& channel : channels()) {
+			if (auto error = this->write("JOIN :"s + channel); error) { return error; }
+		}
+		return {};
+	}
+
+	error_code_t Controller::join_channel(const std::string& channel) {
+		{
+			std::lock_guard<std::mutex> lock{ m_channels_mutex };
+			if (std::find(m_channels.begin(), m_channels.end(), channel) == m_channels.end()) {
+				m_channels.push_back(channel);
+			}
+		}
+		using namespace std::string_literals;
+		return this->write("JOIN :"s + channel);
+	}
+
+	error_code_t Controller::part_channel(const std::string& channel) {
+		{
+			std::lock_guard<std::mutex> lock{ m_channels_mutex };
+			m_channels.erase(
+				std::remove(m_channels.begin(), m_channels.end(), channel),
+				m_channels.end()
+			);
+		}
+		using namespace std::string_literals;
+		return this->write("PART :"s + channel);
+	}
+
+	std::vector<std::string> Controller::channels() const {
+		std::lock_guard<std::mutex> lock{ m_channels_mutex };
+		return m_channels;
 	}
 
 	error_code_t Controller::cap_req(const std::string& cap) {
@@ -153,6 +716,7 @@ namespace Twitch::irc {
 	}
 
 	std::pair<error_code_t, std::string> Controller::read() {
+		m_buffer.consume(std::exchange(m_consumed, 0));
 		error_code_t error{};
 
 		std::size_t n = boost::asio::read_until(
@@ -163,6 +727,8 @@ namespace Twitch::irc {
 		);
 
 		if (error) { return { error, {} }; }
+		m_metrics.bytes_read.add(n);
+		m_metrics.lines_read.add();
 		
 		std::string recived_message;
 		std::getline(std::istream(&m_buffer), recived_message);
@@ -170,49 +736,320 @@ namespace Twitch::irc {
 		return { error, std::move(recived_message) };
 	}
 
+	error_code_t Controller::read_lines(std::vector<std::string_view>& lines) {
+		lines.clear();
+		m_buffer.consume(std::exchange(m_consumed, 0));
+		error_code_t error{};
+
+		boost::asio::read_until(
+			m_socket,
+			m_buffer,
+			m_delimiter,
+			error
+		);
+
+		if (error) { return error; }
+
+		split_lines(lines);
+		return error;
+	}
+
+	void Controller::split_lines(std::vector<std::string_view>& lines) {
+		const auto data = m_buffer.data();
+		const std::string_view received{
+			static_cast<const char*>(data.data()),
+			data.size()
+		};
+
+		const auto first = lines.size();
+		std::size_t begin{ 0 };
+		for (auto end = received.find(m_delimiter, begin);
+			end != std::string_view::npos;
+			end = received.find(m_delimiter, begin)
+		) {
+			lines.emplace_back(received.substr(begin, end - begin));
+			begin = end + m_delimiter.size();
+		}
+		m_consumed = begin; // partial line stays in the buffer
+
+		m_metrics.bytes_read.add(begin);
+		m_metrics.lines_read.add(lines.size() - first);
+	}
+
 	error_code_t Controller::write(const std::string& message) {
-		std::unique_lock<std::mutex> lock{ m_mutex };
-		m_cv.wait(lock, [&]() { return m_ready_to_write && !m_reconnecting; });
+		// over budget it stays in its lane, the caller never waits for it
+		m_limiter.push(message);
+		return drain();
+	}
+
+	error_code_t Controller::drain() {
+		if (!m_async) { return flush(); }
 
+		boost::asio::post(m_io_service, [this]() { async_write_next(); });
+		return {};
+	}
+
+	error_code_t Controller::flush() {
+		const auto start = metrics::clock_t::now();
+		std::lock_guard<std::mutex> lock{ m_mutex };
+
+		while (auto message = m_limiter.pop(start)) {
+			if (auto error = send(*message); error) { return error; }
+			m_metrics.write_wait.record(metrics::clock_t::now() - start);
+		}
+		return {};
+	}
+
+	error_code_t Controller::send(const std::string& message) {
 		error_code_t error{};
 
-		boost::asio::write(
+		const auto n = boost::asio::write(
 			m_socket,
 			boost::asio::buffer(message + m_delimiter),
 			error
 		);
 
-		if (!error) { std::this_thread::sleep_for(m_write_delay); }
-
+		if (!error) {
+			m_metrics.bytes_written.add(n);
+			m_metrics.lines_written.add();
+		}
 		return error;
 	}
 
 	void Controller::enqueue(std::string message, bool priority) {
-		m_queue->push(std::move(message), priority);
+		const auto immediate = RateLimiter::classify(message) == RateLimiter::Lane::immediate;
+		m_limiter.push(std::move(message), priority);
+
+		// run() starts writing whatever was enqueued before it
+		if (m_async) {
+			boost::asio::post(m_io_service, [this]() { async_write_next(); });
+			return;
+		}
+
+		if (immediate) { flush(); return; } // not budgeted, doesn't wait for the writing thread
+		{
+			std::lock_guard<std::mutex> lock{ m_work_mutex };
+			m_work = true;
+		}
+		m_work_cv.notify_one();
+	}
+
+	void Controller::wait_for_work(std::chrono::milliseconds timeout) {
+		auto wait = timeout;
+		if (const auto release = m_limiter.next_release(); release) {
+			if (*release == RateLimiter::clock_t::duration::zero()) { return; }
+			wait = std::min(wait, std::chrono::ceil<std::chrono::milliseconds>(*release));
+		}
+
+		std::unique_lock<std::mutex> lock{ m_work_mutex };
+		m_work_cv.wait_for(lock, wait, [&]() { return m_work; });
+		m_work = false;
+	}
+
+	void Controller::async_write_next() {
+		if (m_writing || m_reconnecting) { return; } // reconnected() starts writing again
+
+		const auto now = metrics::clock_t::now();
+		auto message = m_limiter.pop(now);
+		if (!message) {
+			if (const auto wait = m_limiter.next_release(now); wait) {
+				if (!m_throttled_since) { m_throttled_since = now; }
+				m_write_timer.expires_after(*wait);
+				m_write_timer.async_wait([this](const error_code_t& error) {
+					if (error != boost::asio::error::operation_aborted) { async_write_next(); }
+				});
+			}
+			return;
+		}
+
+		m_writing = true;
+		m_write_buffer = std::move(*message) + m_delimiter;
+		// waited since the budget first held the queue back, or not at all
+		const auto ready = std::exchange(m_throttled_since, std::nullopt).value_or(now);
+
+		boost::asio::async_write(
+			m_socket,
+			boost::asio::buffer(m_write_buffer),
+			[this, ready](const error_code_t& error, std::size_t n) {
+				if (error) {
+					auto message = m_write_buffer.substr(0, m_write_buffer.size() - m_delimiter.size());
+					// reconnect() replaced the socket, chat goes out on the new one after its JOIN, the rest was for the old
+					const bool retry = error == boost::asio::error::operation_aborted
+						&& RateLimiter::classify(message) == RateLimiter::Lane::message;
+					std::cerr << (retry ? "Write aborted, queued again: " : "Write failed, dropped: ")
+						<< message << " (" << error.message() << ")\n";
+					if (retry) { m_limiter.requeue(std::move(message)); }
+				}
+				else {
+					m_metrics.bytes_written.add(n);
+					m_metrics.lines_written.add();
+					m_metrics.write_wait.record(metrics::clock_t::now() - ready);
+				}
+
+				m_writing = false;
+				async_write_next();
+			}
+		);
+	}
+
+	void Controller::async_read(read_handler_t handler) {
+		if (m_reconnecting) { // started by reconnected() on the new socket
+			m_pending_read = std::move(handler);
+			return;
+		}
+
+		m_lines.clear();
+		m_buffer.consume(std::exchange(m_consumed, 0));
+
+		boost::asio::async_read_until(
+			m_socket,
+			m_buffer,
+			m_delimiter,
+			[this, handler = std::move(handler)](const error_code_t& error, std::size_t) {
+				if (error) { return handler(error, m_lines); }
+
+				split_lines(m_lines);
+				handler(error, m_lines);
+			}
+		);
+	}
+
+	void Controller::run() {
+		m_async = true;
+		m_io_service.restart();
+		// JOINs over the budget are still waiting since setup
+		boost::asio::post(m_io_service, [this]() { async_write_next(); });
+		m_io_service.run();
+		m_async = false;
+	}
+
+	void Controller::stop() {
+		m_io_service.stop();
 	}
 
 	error_code_t Controller::reconnect() {
-		std::lock_guard lock(m_mutex);
+		if (!m_async) { return reconnect_now(); }
+		if (m_reconnecting) { return {}; } // the attempt in flight makes a new connection anyway
+
+		reset_connection();
 		m_reconnecting = true;
-		m_socket = socket_t{ m_io_service };
+		m_reconnect_failures = 0;
+		async_reconnect();
+		return {};
+	}
 
-		if (auto error = connect(); error) { return error; }
+	void Controller::set_reconnect_policy(ReconnectPolicy policy) {
+		policy.attempts = std::max<std::size_t>(policy.attempts, 1);
+		m_reconnect_policy = policy;
+	}
+
+	std::chrono::milliseconds Controller::backoff(std::size_t failures) const noexcept {
+		auto wait = m_reconnect_policy.backoff;
+		for (std::size_t i{ 1 }; i < failures && wait < m_reconnect_policy.max_backoff; ++i) { wait *= 2; }
+		return std::min(wait, m_reconnect_policy.max_backoff);
+	}
+
+	std::vector<std::string> Controller::handshake() const {
 		using namespace std::string_literals;
-		if (auto error = cap_req(":twitch.tv/tags twitch.tv/commands twitch.tv/membership"s);
-			error) { return error; }
-		if (auto error = login(); error) { return error; }
-		if (auto error = join_channel(); error) { return error; }
+		std::vector<std::string> handshake{
+			"CAP REQ :twitch.tv/tags twitch.tv/commands twitch.tv/membership"s,
+			"PASS :"s + m_pass,
+			"NICK :"s + m_nick
+		};
+		for (const auto& channel : channels()) { handshake.push_back("JOIN :"s + channel); }
+		return handshake;
+	}
+
+	void Controller::reset_connection() {
+		// flush() can't write to the old socket meanwhile, JOINs over the budget wait in their lane
+		std::lock_guard lock(m_mutex);
+		m_socket = socket_t{ m_io_service };
+		// a partial line of the old connection must not be spliced onto the first one of the new
+		m_buffer.consume(m_buffer.size());
+		m_consumed = 0;
+	}
+
+	error_code_t Controller::reconnect_now() {
+		error_code_t error{};
+		for (std::size_t attempt{ 0 }; attempt < m_reconnect_policy.attempts; ++attempt) {
+			if (attempt != 0) {
+				const auto wait = backoff(attempt);
+				TWITCH_IRC_LOG(m_lg, warning, "Reconnect failed: ", error.message(), ", next attempt in ", wait.count(), "ms");
+				std::this_thread::sleep_for(wait);
+			}
+
+			reset_connection();
+			{
+				std::lock_guard lock(m_mutex);
+				if (error = connect(); error) { continue; }
+				m_limiter.reconnect(handshake());
+			}
+			return flush();
+		}
+
+		TWITCH_IRC_LOG(m_lg, error, "Reconnect failed ", m_reconnect_policy.attempts, " times, giving up: ", error.message());
+		return error;
+	}
+
+	void Controller::async_reconnect() {
+		m_resolver.async_resolve(m_server, m_port,
+			[this](const error_code_t& error, resolver_t::results_type endpoints) {
+				if (error) { return reconnect_failed(error); }
+
+				boost::asio::async_connect(m_socket, endpoints,
+					[this](const error_code_t& error, const resolver_t::endpoint_type&) {
+						if (error) { return reconnect_failed(error); }
+						reconnected();
+					}
+				);
+			}
+		);
+	}
+
+	void Controller::reconnect_failed(const error_code_t& error) {
+		if (++m_reconnect_failures >= m_reconnect_policy.attempts) {
+			TWITCH_IRC_LOG(m_lg, error, "Reconnect failed ", m_reconnect_failures, " times, giving up: ", error.message());
+			m_reconnecting = false;
+			// the read loop sees the error like a dropped connection
+			if (auto handler = std::exchange(m_pending_read, nullptr); handler) { handler(error, m_lines); }
+			else { stop(); }
+			return;
+		}
+
+		const auto wait = backoff(m_reconnect_failures);
+		TWITCH_IRC_LOG(m_lg, warning, "Reconnect failed: ", error.message(), ", next attempt in ", wait.count(), "ms");
+		m_reconnect_timer.expires_after(wait);
+		m_reconnect_timer.async_wait([this](const error_code_t& error) {
+			if (error != boost::asio::error::operation_aborted) { async_reconnect(); }
+		});
+	}
 
+	void Controller::reconnected() {
+		std::cout << "Reconnected!\n";
 		m_reconnecting = false;
-		return {};
+		m_limiter.reconnect(handshake());
+		async_write_next();
+		if (auto handler = std::exchange(m_pending_read, nullptr); handler) { async_read(std::move(handler)); }
 	}
 
 	bool Controller::is_alive() const noexcept {
 		return m_socket.is_open();
 	}
 
-	std::shared_ptr<MessageQueue> Controller::get_message_queue() {
-		return m_queue;
+	void Controller::set_moderator(std::string_view channel, bool moderator) {
+		m_limiter.set_moderator(channel, moderator);
+	}
+
+	void Controller::share_join_budget(std::shared_ptr<SharedTokenBucket> budget) {
+		m_limiter.share_join_budget(std::move(budget));
+	}
+
+	void Controller::share_message_budget(std::shared_ptr<MessageBudget> budget) {
+		m_limiter.share_message_budget(std::move(budget));
+	}
+
+	metrics::ConnectionMetrics::Snapshot Controller::connection_metrics() const {
+		return m_metrics.snapshot(m_limiter.pending());
 	}
 
 	const std::string Controller::m_delimiter{ "\r\n" };
@@ -220,18 +1057,28 @@ namespace Twitch::irc {
 	TwitchBot::TwitchBot(
 		std::shared_ptr<Commands> t_commands,
 		std::shared_ptr<IController> irc_controller,
-		std::unique_ptr<message::MessageParser> t_parser
+		std::unique_ptr<message::MessageParser> t_parser,
+		std::shared_ptr<CommandExecutor> t_executor
 	) :
-		m_commands(std::move(t_commands)),
+		m_channels(std::make_shared<Channels>(std::move(t_commands))),
 		m_controller(std::move(irc_controller)),
-		m_parser(std::move(t_parser))
+		m_parser(std::move(t_parser)),
+		m_executor(std::move(t_executor))
 	{
 	}
 
-	void TwitchBot::run() {
+	void TwitchBot::set_commands(std::string_view channel, std::shared_ptr<Commands> commands) {
+		m_channels->set_commands(channel, std::move(commands));
+	}
+
+	void TwitchBot::set_capture(std::shared_ptr<capture::Writer> writer) {
+		m_capture = std::move(writer);
+	}
+
+	bool TwitchBot::setup() {
 		if (auto error = m_controller->connect(); error) {
 			std::cerr << error.message() << '\n';
-			return;
+			return false;
 		}
 
 		using namespace std::string_literals;
@@ -239,40 +1086,191 @@ namespace Twitch::irc {
 				":twitch.tv/tags twitch.tv/commands twitch.tv/membership"s
 			); error) {
 			std::cerr << error.message() << '\n';
-			return;
+			return false;
 		}
 
 		if (auto error = m_controller->login(); error) {
 			std::cerr << error.message() << '\n';
-			return;
+			return false;
 		}
 
 		if (auto error = m_controller->join_channel(); error) {
 			std::cerr << error.message() << '\n';
-			return;
+			return false;
 		}
+		for (const auto& channel : m_controller->channels()) { m_channels->add(channel); }
+
+		return true;
+	}
+
+	void TwitchBot::run() {
+		if (!setup()) { return; }
 
 		WritingThread writing_thread(m_controller);
+		std::vector<std::string_view> recived_messages;
 		
+		// read_lines blocks until at least one line is in, no need to pace the loop
 		while (m_controller->is_alive()) {
-			auto [error, recived_message] = m_controller->read();
-			if (error) {
+			if (auto error = m_controller->read_lines(recived_messages); error) {
 				std::cerr << error.message() << '\n';
 				return;
 			}
-#ifdef TWITCH_IRC_COLLECT_SAMPLES
-			using severity = boost::log::trivial::severity_level;
-			BOOST_LOG_SEV(m_lg, severity::trace)
-				<< " UNPROCESSED: " << recived_message;
-#endif
+			process(recived_messages);
+		}
+	}
+
+	void TwitchBot::run_async() {
+		auto controller = std::dynamic_pointer_cast<IAsyncController>(m_controller);
+		if (!controller) { return run(); }
+
+		if (!setup()) { return; }
+
+		async_read_loop(controller);
+		controller->run();
+	}
+
+	void TwitchBot::stop() {
+		if (auto controller = std::dynamic_pointer_cast<IAsyncController>(m_controller); controller) {
+			controller->stop();
+		}
+	}
+
+	metrics::Snapshot TwitchBot::metrics(std::string connection) const {
+		return metrics::Snapshot{
+			std::move(connection),
+			m_parser->metrics().snapshot(),
+			m_controller->connection_metrics()
+		};
+	}
+
+	void TwitchBot::async_read_loop(std::shared_ptr<IAsyncController> controller) {
+		controller->async_read(
+			[this, controller](const error_code_t& error, const std::vector<std::string_view>& recived_messages) {
+				if (error) {
+					std::cerr << error.message() << '\n';
+					controller->stop();
+					return;
+				}
+				process(recived_messages);
+				async_read_loop(controller);
+			}
+		);
+	}
+
+	void TwitchBot::process(const std::vector<std::string_view>& recived_messages) {
+		// parse results die in the loop, the arena is released once the batch is done
+		BatchArena::Scope batch{ m_arena };
+		// command lookups of the whole batch share one pin, the thread is quiescent between batches
+		Commands::Pin pin;
+		if (m_capture) { m_capture->write(capture::clock_t::now(), recived_messages); }
+
+		for (const auto recived_message : recived_messages) {
 			auto parse_result = m_parser->process(recived_message);
-			boost::apply_visitor(
-				m_parser->get_visitor(m_controller, m_commands, m_lg),
+			m_parser->dispatch(
+				m_parser->get_visitor(m_controller, m_channels, m_executor, m_lg),
 				parse_result
 			);
+		}
+	}
+
+	ConnectionPool::ConnectionPool(
+		std::vector<std::string> t_channels,
+		std::size_t t_shards,
+		controller_factory_t t_make_controller,
+		std::shared_ptr<Commands> t_commands,
+		std::shared_ptr<CommandExecutor> t_executor
+	) {
+		// a channel joined twice would answer every command twice
+		std::set<std::string, std::less<>> seen;
+		std::vector<std::string> unique;
+		unique.reserve(t_channels.size());
+		for (auto& channel : t_channels) {
+			if (seen.insert(channel).second) { unique.push_back(std::move(channel)); }
+		}
+		t_channels = std::move(unique);
+
+		const auto channels = t_channels.size();
+		const auto shards = std::max<std::size_t>({
+			1,
+			(channels + channels_per_connection - 1) / channels_per_connection,
+			std::min(t_shards, channels)
+		});
+
+		// round robin keeps shards within one channel of each other
+		std::vector<std::vector<std::string>> shard_channels(shards);
+		for (std::size_t i{ 0 }; i < channels; ++i) {
+			m_shard_of.emplace(t_channels[i], i % shards);
+			shard_channels[i % shards].push_back(std::move(t_channels[i]));
+		}
+
+		const auto join_budget = std::make_shared<SharedTokenBucket>(
+			RateLimiter::joins, RateLimiter::joins_period
+		);
+		const auto message_budget = std::make_shared<MessageBudget>(
+			RateLimiter::user_messages, RateLimiter::moderator_messages, RateLimiter::messages_period
+		);
+		for (auto& channels : shard_channels) {
+			auto controller = t_make_controller(std::move(channels));
+			controller->share_join_budget(join_budget);
+			controller->share_message_budget(message_budget);
+
+			m_bots.push_back(std::make_unique<TwitchBot>(
+				t_commands,
+				controller,
+				std::make_unique<message::MessageParser>(message::ParserVisitor::subscription()),
+				t_executor
+			));
+			m_controllers.push_back(std::move(controller));
+		}
+	}
+
+	void ConnectionPool::set_commands(std::string_view channel, std::shared_ptr<Commands> commands) {
+		if (const auto shard = shard_of(channel); shard) {
+			m_bots[*shard]->set_commands(channel, std::move(commands));
+		}
+	}
+
+	void ConnectionPool::set_capture(std::shared_ptr<capture::Writer> writer) {
+		for (auto& bot : m_bots) { bot->set_capture(writer); }
+	}
+
+	bool ConnectionPool::enqueue(std::string message, bool priority) {
+		const auto shard = shard_of(RateLimiter::channel_of(message));
+		if (!shard) { return false; }
+
+		m_controllers[*shard]->enqueue(std::move(message), priority);
+		return true;
+	}
+
+	std::optional<std::size_t> ConnectionPool::shard_of(std::string_view channel) const noexcept {
+		const auto pos = m_shard_of.find(channel);
+		if (pos == m_shard_of.end()) { return std::nullopt; }
+		return pos->second;
+	}
+
+	std::size_t ConnectionPool::size() const noexcept {
+		return m_bots.size();
+	}
+
+	void ConnectionPool::run() {
+		std::vector<std::thread> threads;
+		threads.reserve(m_bots.size());
+		for (auto& bot : m_bots) {
+			threads.emplace_back([&bot]() { bot->run_async(); });
+		}
+		for (auto& thread : threads) { thread.join(); }
+	}
+
+	void ConnectionPool::stop() {
+		for (auto& bot : m_bots) { bot->stop(); }
+	}
 
-			using namespace std::chrono_literals;
-			std::this_thread::sleep_for(1ms);
+	std::vector<metrics::Snapshot> ConnectionPool::metrics() const {
+		std::vector<metrics::Snapshot> snapshots;
+		snapshots.reserve(m_bots.size());
+		for (std::size_t i{ 0 }; i < m_bots.size(); ++i) {
+			snapshots.push_back(m_bots[i]->metrics(std::to_string(i)));
 		}
+		return snapshots;
 	}
 }
\ No newline at end of file
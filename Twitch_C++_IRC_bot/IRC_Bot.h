@@ -1,17 +1,26 @@
 #ifndef IRC_BOT_H
 #define IRC_BOT_H
 #include "Logger.h"
+#include "Metrics.h"
+#include "TwitchMessageParams.h"
 #include <WinSock2.h>
 #include <boost\asio.hpp>
+#include <atomic>
 #include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <memory_resource>
 #include <map>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <optional>
 #include <deque>
 #include <mutex>
 #include <condition_variable>
+#include <functional>
+#include <thread>
 
 namespace Twitch::irc {
 	namespace message {
@@ -20,50 +29,196 @@ namespace Twitch::irc {
 			struct PRIVMSG;
 		}
 	}
+	namespace capture {
+		class Writer;
+	}
 
-	// RAII blessing for thread synchronization
-	struct MultithreadingRoutine final
+	// Vyukov's intrusive MPSC queue, push() is wait-free
+	// pop() and empty() may only be called from a single consumer thread
+	template<class T>
+	class MPSCQueue
 	{
 	public:
-		template<class Pred>
-		MultithreadingRoutine(
-			std::unique_lock<std::mutex>& t_lock,
-			std::condition_variable& t_cv,
-			std::atomic_bool& t_control_value,
-			Pred cv_predicate
-		) :
-			m_lock(t_lock), m_cv(t_cv), m_control_value(t_control_value)
-		{
-			t_cv.wait(m_lock, cv_predicate);
-			m_control_value = false;
+		MPSCQueue() : m_head(new node_t{}), m_tail(m_head.load(std::memory_order_relaxed)) {}
+		~MPSCQueue() {
+			while (pop()) {}
+			delete m_tail;
+		}
+
+		MPSCQueue(const MPSCQueue&) = delete;
+		MPSCQueue& operator=(const MPSCQueue&) = delete;
+
+		void push(T value) {
+			auto* node = new node_t{ std::move(value) };
+			auto* prev = m_head.exchange(node, std::memory_order_acq_rel);
+			prev->next.store(node, std::memory_order_release);
 		}
 
-		~MultithreadingRoutine() {
-			m_control_value = true;
-			m_lock.unlock();
-			m_cv.notify_all();
+		std::optional<T> pop() {
+			auto* next = m_tail->next.load(std::memory_order_acquire);
+			if (!next) { return std::nullopt; }
+
+			// next becomes the new stub, its value is moved out
+			std::optional<T> value{ std::move(next->value) };
+			delete m_tail;
+			m_tail = next;
+			return value;
+		}
+
+		bool empty() const noexcept {
+			return m_tail->next.load(std::memory_order_acquire) == nullptr;
 		}
 
 	private:
-		std::unique_lock<std::mutex>& m_lock;
-		std::condition_variable& m_cv;
-		std::atomic_bool& m_control_value;
+		struct node_t
+		{
+			T value{};
+			std::atomic<node_t*> next{ nullptr };
+		};
+
+		alignas(64) std::atomic<node_t*> m_head; // producers
+		alignas(64) node_t* m_tail;              // consumer
 	};
 
-	// threadsafe, all public ops are sync'd
+	// lock-free for producers, single consumer
 	class MessageQueue
 	{
 	public:
 		void push(std::string message, bool priority = false);
 
-		std::optional<std::string> pop();
+		std::optional<std::string> try_pop();
+		// parks the consumer until a message arrives or timeout expires
+		std::optional<std::string> pop(std::chrono::milliseconds timeout = std::chrono::milliseconds{ 100 });
+
+		// approximate while producers push, for metrics
+		inline std::size_t size() const noexcept { return m_size.load(std::memory_order_relaxed); }
 
 	private:
-		std::deque<std::string> m_queue;
+		MPSCQueue<std::string> m_priority;
+		MPSCQueue<std::string> m_queue;
+		std::atomic<std::size_t> m_size{ 0 };
 
-		mutable std::mutex m_mutex{};
+		// only touched when the consumer goes to sleep on an empty queue
+		std::atomic_bool m_sleeping{ false };
+		std::mutex m_mutex{};
 		std::condition_variable m_cv{};
-		mutable std::atomic_bool m_ready_for_task{ true };
+	};
+
+	// refills continuously, at most capacity tokens are stored
+	class TokenBucket
+	{
+	public:
+		using clock_t = std::chrono::steady_clock;
+
+		TokenBucket(std::size_t t_capacity, clock_t::duration t_period) noexcept;
+
+		bool try_consume(clock_t::time_point now) noexcept;
+		clock_t::duration time_to_token(clock_t::time_point now) noexcept;
+		void set_capacity(std::size_t t_capacity, clock_t::time_point now) noexcept;
+
+	private:
+		void refill(clock_t::time_point now) noexcept;
+
+		double m_capacity;
+		clock_t::duration m_period;
+		double m_tokens;
+		clock_t::time_point m_last{ clock_t::now() };
+	};
+
+	// threadsafe, for budgets shared between connections of the same account
+	class SharedTokenBucket
+	{
+	public:
+		using clock_t = TokenBucket::clock_t;
+
+		SharedTokenBucket(std::size_t t_capacity, clock_t::duration t_period) noexcept;
+
+		bool try_consume(clock_t::time_point now);
+		clock_t::duration time_to_token(clock_t::time_point now);
+
+	private:
+		TokenBucket m_bucket;
+		std::mutex m_mutex{};
+	};
+
+	// threadsafe, twitch counts chat per account: every message takes from the total,
+	// messages to channels the account doesn't moderate also take from the smaller user budget
+	class MessageBudget
+	{
+	public:
+		using clock_t = TokenBucket::clock_t;
+
+		MessageBudget(std::size_t t_user, std::size_t t_total, clock_t::duration t_period) noexcept;
+
+		bool try_consume(bool moderator, clock_t::time_point now);
+		clock_t::duration time_to_token(bool moderator, clock_t::time_point now);
+
+	private:
+		TokenBucket m_user;
+		TokenBucket m_total;
+		std::mutex m_mutex{};
+	};
+
+	// threadsafe, never blocks
+	class RateLimiter
+	{ /// https://dev.twitch.tv/docs/irc#irc-command-and-message-limits
+	public:
+		using clock_t = TokenBucket::clock_t;
+
+		enum class Lane { immediate, join, message };
+
+		static constexpr std::size_t user_messages{ 20 };
+		static constexpr std::size_t moderator_messages{ 100 };
+		static constexpr std::chrono::seconds messages_period{ 30 };
+		static constexpr std::size_t joins{ 50 };
+		static constexpr std::chrono::seconds joins_period{ 15 };
+
+		// PONG and connection setup aren't counted by twitch
+		static Lane classify(std::string_view message) noexcept;
+		// "PRIVMSG #channel :..." or "JOIN :#channel" -> "#channel", empty if there is none
+		static std::string_view channel_of(std::string_view message) noexcept;
+
+		// priority puts it at the front of its own lane, chat never jumps into the immediate one
+		void push(std::string message, bool priority = false);
+		// a line the socket didn't take goes back to the front of its lane, budget is spent again
+		void requeue(std::string message);
+		// next message the budget allows to send, channels take turns
+		std::optional<std::string> pop(clock_t::time_point now = clock_t::now());
+		// time until pop() can return something, nullopt if nothing is pending
+		std::optional<clock_t::duration> next_release(clock_t::time_point now = clock_t::now());
+		std::size_t pending() const; // messages waiting in any lane
+		// PONGs, PARTs and JOINs still waiting were meant for the old connection,
+		// handshake replaces them and goes out first, chat keeps its place
+		void reconnect(const std::vector<std::string>& handshake);
+
+		void set_moderator(std::string_view channel, bool moderator);
+		// twitch counts JOINs and chat per account, connections of one account have to share them
+		void share_join_budget(std::shared_ptr<SharedTokenBucket> budget);
+		void share_message_budget(std::shared_ptr<MessageBudget> budget);
+
+	private:
+		// channels take turns on the account's budget, moderated ones may use more of it
+		struct ChannelLane
+		{
+			std::deque<std::string> queue;
+			bool moderator{ false };
+			std::size_t joins{ 0 }; // queued in m_joins, chat waits until they went out
+		};
+
+		ChannelLane& lane(std::string_view channel);
+		std::string take_join(); // m_mutex has to be held
+
+		std::deque<std::string> m_immediate;
+		std::deque<std::string> m_joins;
+		std::shared_ptr<SharedTokenBucket> m_join_bucket{ std::make_shared<SharedTokenBucket>(joins, joins_period) };
+		std::shared_ptr<MessageBudget> m_message_budget{
+			std::make_shared<MessageBudget>(user_messages, moderator_messages, messages_period)
+		};
+
+		std::map<std::string, ChannelLane, std::less<>> m_channels;
+		std::string m_last_served; // round robin between channels
+
+		mutable std::mutex m_mutex{};
 	};
 
 	using io_service_t = boost::asio::io_service;
@@ -73,8 +228,20 @@ namespace Twitch::irc {
 	using error_code_t = boost::system::error_code;
 	using logger_t     = boost::log::sources::severity_logger_mt<boost::log::trivial::severity_level>;
 
+	// FNV-1a, seeded so perfect hash tables can search for a collision free one
+	constexpr std::uint64_t seeded_hash(std::string_view key, std::uint64_t seed) noexcept {
+		std::uint64_t hash = 14695981039346656037ull ^ (seed * 0x9E3779B97F4A7C15ull);
+		for (const char c : key) {
+			hash ^= static_cast<unsigned char>(c);
+			hash *= 1099511628211ull;
+		}
+		return hash ^ (hash >> 32);
+	}
+
+	// lookups take no lock and don't allocate, just an acquire load of the current table,
+	// changes rebuild the table and swap it in atomically
 	struct Commands
-	{ // TODO: thread safety
+	{
 		using key_type = std::string;
 		using cmd_handle_t = std::function<std::string(const message::cap::tags::PRIVMSG &)>;
 		using value_type = std::map<std::string, cmd_handle_t>::value_type;
@@ -82,15 +249,186 @@ namespace Twitch::irc {
 		static const std::string cmd_indicator; // symbol to distinct commands from regular messages, usually '!'
 		static size_t min_cmd_word_size() noexcept; // min size of word used as command name, e.g. "!uptime"
 
-		cmd_handle_t find(const std::string& key) const;
+		// a thread reading tables while they may change holds one of these,
+		// retired tables are freed once every thread that could still see them let go of its pin,
+		// by the next change or the release of the last such pin
+		// nests, the outermost pin on a thread does the work
+		class Pin
+		{
+		public:
+			Pin() noexcept;
+			~Pin();
+
+			Pin(const Pin&) = delete;
+			Pin& operator=(const Pin&) = delete;
+		};
+
+		// nullptr if there is none, valid while the calling thread is pinned,
+		// without a pin only until the next change
+		const cmd_handle_t* find(std::string_view key) const noexcept;
+
+		void insert_or_assign(std::string key, cmd_handle_t handle);
+		bool erase(std::string_view key);
 
 		Commands(std::initializer_list<value_type> init);
 		Commands(const Commands& c);
 		Commands& operator=(const Commands& c);
+		~Commands();
+
+		static std::size_t retired(); // old tables of every Commands a pinned thread may still be reading
 
 	private:
-		std::map<std::string, cmd_handle_t> m_commands;
-		mutable std::mutex m_mutex;
+		using entries_t = std::vector<std::pair<std::string, cmd_handle_t>>;
+
+		// perfect hash, every key has its own slot: one hash, one compare
+		struct Table
+		{
+			static std::unique_ptr<const Table> build(entries_t t_entries);
+			const cmd_handle_t* find(std::string_view key) const noexcept;
+
+			entries_t entries;
+			std::vector<std::uint32_t> slots; // index + 1 into entries, 0 is empty
+			std::uint64_t seed{ 0 };
+			std::size_t mask{ 0 };
+		};
+
+		// replaced tables of every Commands, with the epoch they were replaced in
+		struct Retired;
+		static Retired& retired_tables();
+		static void reclaim() noexcept; // frees what no pin is old enough to see, skipped if busy
+
+		entries_t entries() const; // m_mutex has to be held
+		void publish(entries_t t_entries); // m_mutex has to be held, unless constructing
+
+		std::atomic<const Table*> m_table{ nullptr }; // owned
+		mutable std::mutex m_mutex; // writers only
+	};
+
+	/// bump allocator for one read batch: parsed messages and their text come from here
+	/// and are dropped together when the batch ends, so nothing parsed may outlive it
+	/// long-lived consumers copy out, copies of pmr strings use the default resource
+	class BatchArena
+	{
+	public:
+		static constexpr std::size_t initial_size = 64 * 1024; // a full read buffer of chat
+
+		BatchArena();
+		BatchArena(const BatchArena&) = delete;
+		BatchArena& operator=(const BatchArena&) = delete;
+
+		// arena of the batch open on this thread, nullptr outside of one
+		static BatchArena* current() noexcept;
+		// where parsed text goes: current arena or the default resource
+		static std::pmr::memory_resource* resource() noexcept;
+
+		inline std::pmr::memory_resource* get() noexcept { return &m_resource; }
+
+		// opens a batch on this thread, everything allocated in it is released at the end
+		class Scope
+		{
+		public:
+			explicit Scope(BatchArena& t_arena) noexcept;
+			~Scope();
+
+			Scope(const Scope&) = delete;
+			Scope& operator=(const Scope&) = delete;
+
+		private:
+			BatchArena& m_arena;
+			BatchArena* m_previous;
+		};
+
+	private:
+		std::unique_ptr<std::byte[]> m_buffer;
+		std::pmr::monotonic_buffer_resource m_resource;
+	};
+
+	// last known ROOMSTATE, an update only changes what it carries
+	struct RoomState
+	{
+		std::optional<std::string>             broadcaster_lang;
+		std::optional<bool>                    emote_only;
+		std::optional<int>                     followers_only; // -1 == disabled
+		std::optional<bool>                    r9k;
+		std::optional<parameters::timestamp_t> slow;
+		std::optional<bool>                    subs_only;
+		std::string                            room_id;
+	};
+
+	struct ChannelState
+	{
+		std::shared_ptr<Commands> commands;
+		RoomState room;
+		bool moderator{ false };
+	};
+
+	// per channel state, owned by the reading thread once the bot runs
+	class Channels
+	{
+	public:
+		explicit Channels(std::shared_ptr<Commands> t_default_commands);
+
+		ChannelState& add(std::string_view channel); // returns the existing one if already there
+		ChannelState* find(std::string_view channel) noexcept;
+		void set_commands(std::string_view channel, std::shared_ptr<Commands> commands);
+		// channel's own table, default one for unknown channels
+		const std::shared_ptr<Commands>& commands(std::string_view channel) const noexcept;
+
+	private:
+		std::shared_ptr<Commands> m_default_commands;
+		std::map<std::string, ChannelState, std::less<>> m_channels;
+	};
+
+	// fixed number of threads running command handlers from a bounded queue
+	class CommandExecutor
+	{
+	public:
+		using task_t = std::function<void()>;
+
+		enum class Overflow {
+			drop,  // submit() rejects the task
+			block  // submit() waits for a free slot
+		};
+
+		struct Stats
+		{
+			std::size_t queued;
+			std::size_t running;
+			std::size_t rejected;
+			std::size_t completed;
+		};
+
+		CommandExecutor(
+			std::size_t t_threads = 2,
+			std::size_t t_capacity = 64,
+			Overflow t_overflow = Overflow::drop
+		);
+		~CommandExecutor(); // runs what is already queued, then joins
+
+		CommandExecutor(const CommandExecutor&) = delete;
+		CommandExecutor& operator=(const CommandExecutor&) = delete;
+
+		bool submit(task_t task);
+		Stats stats() const noexcept;
+
+	private:
+		void work();
+
+		const std::size_t m_capacity;
+		const Overflow m_overflow;
+
+		std::deque<task_t> m_tasks;
+		mutable std::mutex m_mutex{};
+		std::condition_variable m_not_empty{};
+		std::condition_variable m_not_full{};
+		bool m_stop{ false };
+
+		std::atomic<std::size_t> m_queued{ 0 };
+		std::atomic<std::size_t> m_running{ 0 };
+		std::atomic<std::size_t> m_rejected{ 0 };
+		std::atomic<std::size_t> m_completed{ 0 };
+
+		std::vector<std::thread> m_workers; // last, tasks need everything above
 	};
 
 	struct IRCWriter;
@@ -102,13 +440,16 @@ namespace Twitch::irc {
 
 	private:
 		std::shared_ptr<IRCWriter> m_writer;
+		std::atomic_bool m_terminate{ false }; // has to be ready before the thread starts
 		std::thread m_writing_thread;
-		bool m_terminate{ false };
 	};
 
 	struct IRCReader
 	{
 		virtual std::pair<error_code_t, std::string> read() = 0;
+		// every complete line already received, without CRLF
+		// views are valid until the next read call
+		virtual error_code_t read_lines(std::vector<std::string_view>& lines) = 0;
 		virtual ~IRCReader() = default;
 	};
 
@@ -116,7 +457,10 @@ namespace Twitch::irc {
 	{
 		virtual error_code_t write(const std::string&) = 0;
 		virtual void enqueue(std::string message, bool priority = false) = 0;
-		virtual std::shared_ptr<MessageQueue> get_message_queue() = 0;
+		// blocks until something was enqueued, the rate limit released a message or timeout expired
+		virtual void wait_for_work(std::chrono::milliseconds timeout) = 0;
+		// sends what writers holding messages back for a rate limit can send by now
+		virtual error_code_t flush() { return {}; }
 		virtual ~IRCWriter() = default;
 	};
 
@@ -124,46 +468,103 @@ namespace Twitch::irc {
 	{
 		virtual error_code_t connect() = 0;
 		virtual error_code_t login() = 0;
-		virtual error_code_t join_channel() = 0;
+		virtual error_code_t join_channel() = 0; // all channels
+		virtual error_code_t join_channel(const std::string& channel) = 0;
+		virtual error_code_t part_channel(const std::string& channel) = 0;
+		virtual std::vector<std::string> channels() const = 0;
 		virtual error_code_t cap_req(const std::string& cap) = 0;
+		// new connection, handshake and JOINs again, retried with a backoff
+		// an async controller returns at once and keeps trying on its loop,
+		// giving up fails its pending read, others block and return the last error
 		virtual error_code_t reconnect() = 0;
 		virtual bool is_alive() const noexcept = 0;
+		virtual void set_moderator(std::string_view channel, bool moderator) = 0; // raises message rate limit
+		virtual void share_join_budget(std::shared_ptr<SharedTokenBucket> budget) = 0;
+		virtual void share_message_budget(std::shared_ptr<MessageBudget> budget) = 0;
+		// socket counters, empty for controllers that don't keep any
+		virtual metrics::ConnectionMetrics::Snapshot connection_metrics() const { return {}; }
 		~IController() override = default;
 	};
 
-	class Controller : public IController
+	// single threaded event loop, handlers are invoked from run()
+	struct IAsyncController : public IController
+	{
+		using read_handler_t = std::function<void(const error_code_t&, const std::vector<std::string_view>&)>;
+
+		virtual void async_read(read_handler_t handler) = 0;
+		virtual void run() = 0;  // blocks until stop() or no more work
+		virtual void stop() = 0;
+		~IAsyncController() override = default;
+	};
+
+	class Controller : public IAsyncController
 	{ /// https://dev.twitch.tv/docs/irc#connecting-to-twitch-irc
 	public:
+		// first attempt goes out at once, the wait doubles after every failure up to max_backoff
+		struct ReconnectPolicy
+		{
+			std::size_t attempts{ 8 };
+			std::chrono::milliseconds backoff{ 1000 };
+			std::chrono::milliseconds max_backoff{ 60000 };
+		};
+
 		Controller(
 			std::string t_server,
 			std::string t_port,
-			std::string t_channel, // should start with '#'
+			std::vector<std::string> t_channels, // should start with '#'
 			std::string t_nick,	   // all lower case
-			std::string t_pass,    // should start with "oauth:"
-			std::chrono::milliseconds t_write_delay
+			std::string t_pass     // should start with "oauth:"
 		);
 
 		error_code_t connect() override;
 		error_code_t login() override;
 		error_code_t join_channel() override;
+		error_code_t join_channel(const std::string& channel) override;
+		error_code_t part_channel(const std::string& channel) override;
+		std::vector<std::string> channels() const override;
 		error_code_t cap_req(const std::string& cap) override;
 		std::pair<error_code_t, std::string> read() override;
-		error_code_t write(const std::string& message) override;
+		error_code_t read_lines(std::vector<std::string_view>& lines) override;
+		error_code_t write(const std::string& message) override; // never waits for the budget
 		void enqueue(std::string message, bool priority) override;
+		error_code_t flush() override;
 		error_code_t reconnect() override;
 		bool is_alive() const noexcept override;
-		std::shared_ptr<MessageQueue> get_message_queue() override;
+		void set_moderator(std::string_view channel, bool moderator) override;
+		void share_join_budget(std::shared_ptr<SharedTokenBucket> budget) override;
+		void share_message_budget(std::shared_ptr<MessageBudget> budget) override;
+		void wait_for_work(std::chrono::milliseconds timeout) override;
+		metrics::ConnectionMetrics::Snapshot connection_metrics() const override;
+
+		void async_read(read_handler_t handler) override;
+		void run() override;
+		void stop() override;
+
+		void set_reconnect_policy(ReconnectPolicy policy); // call before run
 
 	private:
+		std::chrono::milliseconds backoff(std::size_t failures) const noexcept;
+		std::vector<std::string> handshake() const;
+		void reset_connection();      // fresh socket and read buffer
+		error_code_t reconnect_now(); // blocking, outside of the io_service
+		// io_service thread only
+		void async_reconnect();
+		void reconnect_failed(const error_code_t& error);
+		void reconnected();
+		void async_write_next(); // io_service thread only
+		error_code_t drain();    // async_write_next() on the io_service while it runs, flush() before
+		error_code_t send(const std::string& message); // m_mutex has to be held
+		void split_lines(std::vector<std::string_view>& lines);
+
 		const std::string m_server;
 		const std::string m_port;
-		const std::string m_channel;
+		std::vector<std::string> m_channels;
+		mutable std::mutex m_channels_mutex;
 		const std::string m_nick;
 		const std::string m_pass;
 
 	public:
 		static const std::string m_delimiter;
-		const std::chrono::milliseconds m_write_delay{ 667 };
 
 	protected:
 		io_service_t m_io_service;
@@ -171,12 +572,32 @@ namespace Twitch::irc {
 		resolver_t m_resolver{ m_io_service };
 		socket_t m_socket{ m_io_service };
 		streambuf_t m_buffer{};
-		std::shared_ptr<MessageQueue> m_queue{ std::make_shared<MessageQueue>() };
+		std::size_t m_consumed{ 0 }; // bytes handed out by the last read_lines
+		RateLimiter m_limiter{}; // every write waits here, in both modes
+		// wakes the thread flushing in sync mode
+		std::mutex m_work_mutex{};
+		std::condition_variable m_work_cv{};
+		bool m_work{ false };
+
+		mutable std::mutex m_mutex; // socket, for writes outside of the io_service
 
-		mutable std::mutex m_mutex;
-		mutable std::condition_variable m_cv;
-		mutable std::atomic_bool m_ready_to_write{ true };
-		std::atomic_bool m_reconnecting{ false };
+		metrics::ConnectionMetrics m_metrics{};
+
+		std::atomic_bool m_async{ false };
+		// async mode, touched only from the io_service thread
+		std::string m_write_buffer;
+		std::vector<std::string_view> m_lines;
+		bool m_writing{ false };
+		boost::asio::steady_timer m_write_timer{ m_io_service };
+		std::optional<metrics::clock_t::time_point> m_throttled_since; // head of m_limiter waits for budget
+		// reads and writes wait while reconnecting, the read is started again once connected
+		bool m_reconnecting{ false };
+		std::size_t m_reconnect_failures{ 0 };
+		read_handler_t m_pending_read;
+		boost::asio::steady_timer m_reconnect_timer{ m_io_service };
+
+		ReconnectPolicy m_reconnect_policy{};
+		mutable logger_t m_lg{};
 	};
 
 	class TwitchBot
@@ -185,24 +606,89 @@ namespace Twitch::irc {
 		TwitchBot(
 			std::shared_ptr<Commands> t_commands,
 			std::shared_ptr<IController> irc_controller,
-			std::unique_ptr<message::MessageParser> t_parser
+			std::unique_ptr<message::MessageParser> t_parser,
+			std::shared_ptr<CommandExecutor> t_executor = std::make_shared<CommandExecutor>()
 		);
-		TwitchBot(TwitchBot&&) = default;
-		TwitchBot& operator=(TwitchBot&&) = default;
+		// pinned: the arena and the handlers of a running loop point into it
+		TwitchBot(TwitchBot&&) = delete;
+		TwitchBot& operator=(TwitchBot&&) = delete;
 
 		TwitchBot(const TwitchBot&) = delete;
 		TwitchBot& operator=(const TwitchBot&) = delete;
 
 		~TwitchBot() = default;
 
-		void run();
+		// channels without their own table use the one passed to the constructor, call before run,
+		// the table itself can still be changed at any time through Commands
+		void set_commands(std::string_view channel, std::shared_ptr<Commands> commands);
+		// every read is recorded before it's parsed, nullptr stops it, call before run
+		void set_capture(std::shared_ptr<capture::Writer> writer);
+
+		void run();       // blocking read loop, one batch of lines per read
+		void run_async(); // falls back to run() if controller isn't IAsyncController
+
+		void stop(); // only stops run_async()
+
+		// parser and socket metrics of this connection, callable from any thread
+		metrics::Snapshot metrics(std::string connection) const;
 
 	private:
-		std::shared_ptr<Commands> m_commands;
+		bool setup();
+		void process(const std::vector<std::string_view>& recived_messages);
+		void async_read_loop(std::shared_ptr<IAsyncController> controller);
+
+		std::shared_ptr<Channels> m_channels;
 		std::shared_ptr<IController> m_controller;
 		std::unique_ptr<message::MessageParser> m_parser;
+		std::shared_ptr<CommandExecutor> m_executor;
+		BatchArena m_arena; // parsed messages of the batch being processed
+		std::shared_ptr<capture::Writer> m_capture;
 
 		mutable logger_t m_lg{};
 	};
+
+	// spreads channels over several connections of the same account,
+	// every shard reads, parses and writes on its own thread and io_service
+	class ConnectionPool
+	{
+	public:
+		using controller_factory_t = std::function<
+			std::shared_ptr<IAsyncController>(std::vector<std::string> channels)
+		>;
+
+		static constexpr std::size_t channels_per_connection{ 100 };
+
+		// at least one connection per hundred channels, more up to t_shards while there are channels
+		// to spread, duplicate channels are joined once
+		ConnectionPool(
+			std::vector<std::string> t_channels,
+			std::size_t t_shards,
+			controller_factory_t t_make_controller,
+			std::shared_ptr<Commands> t_commands,
+			std::shared_ptr<CommandExecutor> t_executor = std::make_shared<CommandExecutor>()
+		);
+
+		ConnectionPool(const ConnectionPool&) = delete;
+		ConnectionPool& operator=(const ConnectionPool&) = delete;
+
+		void set_commands(std::string_view channel, std::shared_ptr<Commands> commands); // call before run
+		void set_capture(std::shared_ptr<capture::Writer> writer); // shared by every shard, call before run
+
+		// goes out through the shard that joined the channel, e.g. "PRIVMSG #channel :..."
+		bool enqueue(std::string message, bool priority = false);
+		std::optional<std::size_t> shard_of(std::string_view channel) const noexcept;
+		std::size_t size() const noexcept;
+
+		void run(); // blocks until every shard is done
+		void stop();
+
+		// one snapshot per shard, labelled with its index
+		std::vector<metrics::Snapshot> metrics() const;
+
+	private:
+		std::vector<std::shared_ptr<IAsyncController>> m_controllers;
+		std::vector<std::unique_ptr<TwitchBot>> m_bots;
+		std::map<std::string, std::size_t, std::less<>> m_shard_of;
+	};
 }  // namespace Twitch::irc
 #endif
\ No newline at end of file
@@ -0,0 +1,221 @@
+#include "stdafx.h"
+#include "Logger.h"
+#include <boost/log/utility/formatting_ostream.hpp>
+#include <boost/log/utility/setup/formatter_parser.hpp>
+#include <boost/make_shared.hpp>
+#include <algorithm>
+#include <stdexcept>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace Logger {
+	namespace {
+		// a record carries either a Message (BOOST_LOG_SEV) or a Deferred one (TWITCH_IRC_LOG)
+		const std::string format{ "[%TimeStamp%] (%LineID%) <%Severity%>: %Message%%Deferred%" };
+		constexpr std::size_t write_chunk{ 64 * 1024 };
+
+		boost::shared_ptr<AsyncSink> installed; // sink added by init(), if async
+	}
+
+	AsyncSink::AsyncSink(Options t_options, const boost::filesystem::path& t_file) :
+		boost::log::sinks::sink(true), // records are handed to another thread
+		m_options(t_options),
+		m_ring(t_options.capacity),
+		m_file(std::fopen(t_file.string().c_str(), "ab")),
+		m_formatter(boost::log::parse_formatter(format)),
+		m_writer([this]() { write_loop(); })
+	{
+		if (!m_file) {
+			{
+				std::lock_guard<std::mutex> lock{ m_mutex };
+				m_stop = true;
+			}
+			m_cv.notify_one();
+			m_writer.join();
+			throw std::runtime_error{ "Logger: can't open " + t_file.string() };
+		}
+	}
+
+	AsyncSink::~AsyncSink() {
+		{
+			std::lock_guard<std::mutex> lock{ m_mutex };
+			m_stop = true;
+		}
+		m_cv.notify_one();
+		m_writer.join();
+
+		if (m_file) { std::fclose(m_file); }
+	}
+
+	bool AsyncSink::push(boost::log::record_view record) {
+		if (!m_ring.try_push(record)) { return false; }
+		if (m_ring.size() >= m_ring.capacity() / 2) { wake(); }
+		return true;
+	}
+
+	void AsyncSink::wake() {
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (m_sleeping.load(std::memory_order_relaxed)) {
+			std::lock_guard<std::mutex> lock{ m_mutex };
+			m_cv.notify_one();
+		}
+	}
+
+	void AsyncSink::consume(const boost::log::record_view& record) {
+		if (push(record)) { return; }
+
+		if (m_options.overflow == Overflow::drop) {
+			m_dropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+		do {
+			wake();
+			std::this_thread::yield();
+		} while (!push(record));
+	}
+
+	bool AsyncSink::try_consume(const boost::log::record_view& record) {
+		return push(record);
+	}
+
+	void AsyncSink::flush() {
+		std::unique_lock<std::mutex> lock{ m_mutex };
+		const auto generation = ++m_flush_requested;
+		m_cv.notify_one();
+		m_flushed_cv.wait(lock, [&]() { return m_flushed >= generation || m_stop; });
+	}
+
+	void AsyncSink::write_loop() {
+		while (true) {
+			drain();
+			if (m_unsynced >= m_options.sync_batch
+				|| (m_unsynced != 0 && std::chrono::steady_clock::now() - m_last_sync >= m_options.sync_period)
+			) {
+				sync();
+			}
+
+			std::unique_lock<std::mutex> lock{ m_mutex };
+			if (m_stop || m_flushed != m_flush_requested) {
+				const auto generation = m_flush_requested;
+				const bool stop = m_stop;
+				lock.unlock();
+
+				drain();
+				sync();
+
+				lock.lock();
+				m_flushed = generation;
+				m_flushed_cv.notify_all();
+				if (stop) { return; }
+				continue;
+			}
+
+			// records showing up meanwhile wait for the next tick unless the queue fills up
+			std::chrono::steady_clock::duration timeout = m_options.write_period;
+			if (m_unsynced != 0) {
+				timeout = std::min(timeout, m_options.sync_period - (std::chrono::steady_clock::now() - m_last_sync));
+			}
+
+			m_sleeping.store(true, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			m_cv.wait_for(lock, timeout, [&]() {
+				return m_stop || m_flushed != m_flush_requested || m_ring.size() >= m_ring.capacity() / 2;
+			});
+			m_sleeping.store(false, std::memory_order_relaxed);
+		}
+	}
+
+	std::size_t AsyncSink::drain() {
+		if (!m_file) { return 0; }
+
+		std::size_t count{ 0 };
+		{
+			boost::log::formatting_ostream stream{ m_text };
+			boost::log::record_view record;
+			while (m_ring.try_pop(record)) {
+				m_formatter(record, stream);
+				stream << '\n';
+				++count;
+
+				if (m_text.size() >= write_chunk) {
+					stream.flush();
+					write_out();
+				}
+			}
+
+			if (const auto dropped = m_dropped.load(std::memory_order_relaxed); dropped != m_reported_dropped) {
+				stream << "<warning>: log queue full, " << dropped - m_reported_dropped << " records dropped\n";
+				m_reported_dropped = dropped;
+			}
+			stream.flush();
+		}
+		write_out();
+
+		m_unsynced += count;
+		return count;
+	}
+
+	void AsyncSink::write_out() {
+		if (m_text.empty()) { return; }
+
+		std::fwrite(m_text.data(), 1, m_text.size(), m_file);
+		if (m_options.console) {
+			std::fwrite(m_text.data(), 1, m_text.size(), stdout);
+			std::fflush(stdout);
+		}
+		m_text.clear();
+	}
+
+	void AsyncSink::sync() {
+		if (!m_file) { return; }
+
+		std::fflush(m_file);
+#ifdef _WIN32
+		_commit(_fileno(m_file));
+#else
+		fsync(fileno(m_file));
+#endif
+		m_unsynced = 0;
+		m_last_sync = std::chrono::steady_clock::now();
+	}
+
+	void init(Options options) {
+		boost::log::add_common_attributes();
+		boost::log::register_simple_formatter_factory<boost::log::trivial::severity_level, char>("Severity");
+		boost::log::register_simple_formatter_factory<Deferred, char>(Deferred::attribute);
+
+		if (options.async) {
+			installed = boost::make_shared<AsyncSink>(options, log_path);
+			boost::log::core::get()->add_sink(installed);
+			return;
+		}
+
+		boost::log::add_file_log(
+			boost::log::keywords::file_name = log_path,
+			boost::log::keywords::open_mode = std::ios_base::app,
+			boost::log::keywords::format = format,
+			boost::log::keywords::auto_flush = true
+		);
+		if (options.console) {
+			boost::log::add_console_log(
+				std::cout,
+				boost::log::keywords::format = format,
+				boost::log::keywords::auto_flush = true
+			);
+		}
+	}
+
+	void shutdown() {
+		auto core = boost::log::core::get();
+		core->flush();
+		core->remove_all_sinks();
+		installed.reset(); // joins the writer
+	}
+
+	std::uint64_t dropped() noexcept {
+		return installed ? installed->dropped() : 0;
+	}
+} // namespace Logger
@@ -4,33 +4,293 @@
 #define _SCL_SECURE_NO_WARNINGS
 #include <boost/log/core.hpp>
 #include <boost/log/trivial.hpp>
+#include <boost/log/sinks/sink.hpp>
+#include <boost/log/expressions/formatter.hpp>
+#include <boost/log/attributes/attribute_value_impl.hpp>
+#include <boost/log/utility/formatting_ostream.hpp>
 #include <boost/log/utility/setup/file.hpp>
 #include <boost/log/utility/setup/console.hpp>
 #include <boost/log/utility/setup/common_attributes.hpp>
 #include <boost/filesystem.hpp>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
 #include <ios>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// records below it are compiled out, e.g. /DTWITCH_IRC_LOG_MIN_SEVERITY=info
+#ifndef TWITCH_IRC_LOG_MIN_SEVERITY
+#ifdef NDEBUG
+#define TWITCH_IRC_LOG_MIN_SEVERITY debug
+#else
+#define TWITCH_IRC_LOG_MIN_SEVERITY trace
+#endif
+#endif
+
+// TWITCH_IRC_LOG(m_lg, trace, "Joins: ", msg.user);
+// nothing is evaluated below the minimum severity, arguments are copied and formatted by the sink
+#define TWITCH_IRC_LOG(lg, level, ...)                                                   \
+	do {                                                                                  \
+		if constexpr (::Logger::enabled(::boost::log::trivial::level)) {                  \
+			::Logger::log((lg), ::boost::log::trivial::level, __VA_ARGS__);               \
+		}                                                                                 \
+	} while (false)
 
 namespace Logger {
 	const boost::filesystem::path log_path{
 		boost::filesystem::current_path().branch_path().append("log.txt")
 	};
 
-	inline void init() {
-		boost::log::add_common_attributes();
-		boost::log::register_simple_formatter_factory<boost::log::trivial::severity_level, char>("Severity");
+	using severity = boost::log::trivial::severity_level;
 
-		boost::log::add_file_log(
-			boost::log::keywords::file_name = log_path,
-			boost::log::keywords::open_mode = std::ios_base::app,
-			boost::log::keywords::format = "[%TimeStamp%] (%LineID%) <%Severity%>: %Message%",
-			boost::log::keywords::auto_flush = true
-		);
-		boost::log::add_console_log(
-			std::cout,
-			boost::log::keywords::format = "[%TimeStamp%] (%LineID%) <%Severity%>: %Message%",
-			boost::log::keywords::auto_flush = true
+	inline constexpr severity min_severity{ boost::log::trivial::TWITCH_IRC_LOG_MIN_SEVERITY };
+	constexpr bool enabled(severity level) noexcept { return level >= min_severity; }
+
+	namespace details {
+		// views and C strings may point into the read buffer or the batch arena,
+		// both are gone by the time the sink formats, so they are copied
+		// string literals are the only pointers kept
+		template<class T, class Bare = std::remove_cv_t<std::remove_reference_t<T>>>
+		using capture_t = std::conditional_t<
+			std::is_array_v<Bare>,
+			const std::remove_extent_t<Bare>*,
+			std::conditional_t<
+				std::is_convertible_v<const Bare&, std::string_view> && !std::is_same_v<Bare, std::string>,
+				std::string,
+				Bare
+			>
+		>;
+
+		template<class T>
+		inline decltype(auto) capture(T&& value) {
+			if constexpr (std::is_same_v<capture_t<T>, std::string> && !std::is_same_v<std::decay_t<T>, std::string>) {
+				return std::string{ std::string_view{ value } };
+			}
+			else { return std::forward<T>(value); }
+		}
+	}
+
+	/// message arguments captured at the call site, streamed only when a sink formats the record
+	class Deferred
+	{
+	public:
+		static constexpr const char* attribute{ "Deferred" };
+		static constexpr std::size_t max_capture_size{ 64 };
+
+		template<class... Args>
+		static Deferred capture(Args&&... args) {
+			// every record pays for the copy, log the fields that get printed rather than a whole message
+			static_assert(((sizeof(details::capture_t<Args>) <= max_capture_size) && ...),
+				"argument too big to be captured by a log record");
+			return Deferred{ std::make_shared<const Captured<details::capture_t<Args>...>>(
+				details::capture(std::forward<Args>(args))...
+			) };
+		}
+
+		friend boost::log::formatting_ostream& operator<<(boost::log::formatting_ostream& out, const Deferred& message) {
+			if (message.m_message) { message.m_message->format(out); }
+			return out;
+		}
+
+	private:
+		struct Message
+		{
+			virtual ~Message() = default;
+			virtual void format(boost::log::formatting_ostream& out) const = 0;
+		};
+
+		template<class... Ts>
+		struct Captured final : Message
+		{
+			template<class... Args>
+			explicit Captured(Args&&... args) : values(std::forward<Args>(args)...) {}
+
+			void format(boost::log::formatting_ostream& out) const override {
+				std::apply([&](const auto&... value) { (out << ... << value); }, values);
+			}
+
+			std::tuple<Ts...> values;
+		};
+
+		explicit Deferred(std::shared_ptr<const Message> t_message) : m_message(std::move(t_message)) {}
+
+		std::shared_ptr<const Message> m_message;
+	};
+
+	// use TWITCH_IRC_LOG, it keeps disabled levels out of the binary
+	template<class Logger_t, class... Args>
+	void log(Logger_t& lg, severity level, Args&&... args) {
+		auto record = lg.open_record(boost::log::keywords::severity = level);
+		if (!record) { return; }
+
+		record.attribute_values().insert(
+			Deferred::attribute,
+			boost::log::attributes::make_attribute_value(Deferred::capture(std::forward<Args>(args)...))
 		);
+		lg.push_record(std::move(record));
 	}
+
+	enum class Overflow {
+		drop,  // the record is lost and counted, logging never waits
+		block  // the logging thread yields until the writer makes room
+	};
+
+	struct Options
+	{
+		bool async{ true };                             // false: synchronous sinks flushing every record
+		std::size_t capacity{ 8192 };                   // queued records, rounded up to a power of two
+		Overflow overflow{ Overflow::drop };
+		std::chrono::milliseconds write_period{ 10 };   // writer wakes this often, earlier if the queue is half full
+		std::size_t sync_batch{ 4096 };                 // records written before the file is synced
+		std::chrono::milliseconds sync_period{ 1000 };  // longest a written record stays unsynced
+		bool console{ true };
+	};
+
+	// Vyukov's bounded queue, producers are lock-free, single consumer
+	// try_pop() and empty() may only be called from the consumer thread, size() from anywhere
+	template<class T>
+	class RingBuffer
+	{
+	public:
+		explicit RingBuffer(std::size_t t_capacity) :
+			m_mask(round_up(t_capacity) - 1),
+			m_cells(std::make_unique<cell_t[]>(m_mask + 1))
+		{
+			for (std::size_t i{ 0 }; i <= m_mask; ++i) { m_cells[i].sequence.store(i, std::memory_order_relaxed); }
+		}
+
+		RingBuffer(const RingBuffer&) = delete;
+		RingBuffer& operator=(const RingBuffer&) = delete;
+
+		// false if the buffer is full, value is left untouched then
+		bool try_push(T& value) {
+			auto position = m_enqueue.load(std::memory_order_relaxed);
+			cell_t* cell;
+			while (true) {
+				cell = &m_cells[position & m_mask];
+				const auto sequence = cell->sequence.load(std::memory_order_acquire);
+				const auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+				if (diff == 0) {
+					if (m_enqueue.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) { break; }
+				}
+				else if (diff < 0) { return false; }
+				else { position = m_enqueue.load(std::memory_order_relaxed); }
+			}
+
+			cell->value = std::move(value);
+			cell->sequence.store(position + 1, std::memory_order_release);
+			return true;
+		}
+
+		bool try_pop(T& value) {
+			const auto position = m_dequeue.load(std::memory_order_relaxed);
+			auto& cell = m_cells[position & m_mask];
+			if (cell.sequence.load(std::memory_order_acquire) != position + 1) { return false; }
+
+			value = std::move(cell.value);
+			cell.value = T{};
+			cell.sequence.store(position + m_mask + 1, std::memory_order_release);
+			m_dequeue.store(position + 1, std::memory_order_relaxed);
+			return true;
+		}
+
+		bool empty() const noexcept {
+			const auto position = m_dequeue.load(std::memory_order_relaxed);
+			return m_cells[position & m_mask].sequence.load(std::memory_order_acquire) != position + 1;
+		}
+
+		// approximate while producers push
+		inline std::size_t size() const noexcept {
+			const auto dequeue = m_dequeue.load(std::memory_order_relaxed);
+			const auto enqueue = m_enqueue.load(std::memory_order_relaxed);
+			return enqueue > dequeue ? enqueue - dequeue : 0;
+		}
+
+		inline std::size_t capacity() const noexcept { return m_mask + 1; }
+
+	private:
+		struct cell_t
+		{
+			std::atomic<std::size_t> sequence{ 0 };
+			T value{};
+		};
+
+		static std::size_t round_up(std::size_t n) noexcept {
+			std::size_t capacity{ 2 };
+			while (capacity < n) { capacity <<= 1; }
+			return capacity;
+		}
+
+		const std::size_t m_mask;
+		const std::unique_ptr<cell_t[]> m_cells;
+		alignas(64) std::atomic<std::size_t> m_enqueue{ 0 }; // producers
+		alignas(64) std::atomic<std::size_t> m_dequeue{ 0 }; // consumer
+	};
+
+	/// formats and writes records on its own thread, logging only queues them
+	/// the writer wakes up on its own every write_period, loggers wake it only once the queue is half full
+	/// the file is synced once per sync_batch records or sync_period, whichever comes first
+	class AsyncSink : public boost::log::sinks::sink
+	{
+	public:
+		AsyncSink(Options t_options, const boost::filesystem::path& t_file);
+		~AsyncSink() override; // writes what is queued, syncs and joins
+
+		bool will_consume(const boost::log::attribute_value_set&) override { return true; }
+		void consume(const boost::log::record_view& record) override;
+		bool try_consume(const boost::log::record_view& record) override; // never blocks, false if full
+		void flush() override; // returns once everything queued so far is written and synced
+
+		inline std::uint64_t dropped() const noexcept { return m_dropped.load(std::memory_order_relaxed); }
+
+	private:
+		bool push(boost::log::record_view record);
+		void wake();
+
+		void write_loop();
+		std::size_t drain(); // writer thread only
+		void write_out();
+		void sync();
+
+		const Options m_options;
+		RingBuffer<boost::log::record_view> m_ring;
+		std::atomic<std::uint64_t> m_dropped{ 0 };
+
+		// writer thread only
+		std::FILE* m_file;
+		boost::log::formatter m_formatter;
+		std::string m_text;
+		std::uint64_t m_reported_dropped{ 0 };
+		std::size_t m_unsynced{ 0 };
+		std::chrono::steady_clock::time_point m_last_sync{ std::chrono::steady_clock::now() };
+
+		// only touched when the writer goes to sleep on an empty queue, or to flush
+		std::atomic_bool m_sleeping{ false };
+		std::mutex m_mutex{};
+		std::condition_variable m_cv{};
+		std::condition_variable m_flushed_cv{};
+		std::uint64_t m_flush_requested{ 0 };
+		std::uint64_t m_flushed{ 0 };
+		bool m_stop{ false };
+
+		std::thread m_writer; // last, runs with everything above
+	};
+
+	void init(Options options = {});
+	void shutdown(); // writes out and removes the sinks, call before leaving main
+
+	// records lost to a full queue since init
+	std::uint64_t dropped() noexcept;
 } // namespace Logger
-#endif // LOGGER_H
\ No newline at end of file
+#endif // LOGGER_H
@@ -0,0 +1,222 @@
+#include "stdafx.h"
+#include "Metrics.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <utility>
+
+namespace Twitch::irc::metrics {
+	std::size_t LatencyHistogram::bucket_of(std::uint64_t ns) noexcept {
+		std::size_t width{ 0 };
+		while (ns != 0 && width < buckets - 1) {
+			ns >>= 1;
+			++width;
+		}
+		return width;
+	}
+
+	void LatencyHistogram::record(clock_t::duration elapsed) noexcept {
+		const auto ns = static_cast<std::uint64_t>(
+			std::max<std::chrono::nanoseconds::rep>(0, std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count())
+		);
+		m_counts[bucket_of(ns)].fetch_add(1, std::memory_order_relaxed);
+		m_sum_ns.fetch_add(ns, std::memory_order_relaxed);
+	}
+
+	LatencyHistogram::Snapshot LatencyHistogram::snapshot() const noexcept {
+		Snapshot snapshot;
+		for (std::size_t i{ 0 }; i < buckets; ++i) {
+			snapshot.counts[i] = m_counts[i].load(std::memory_order_relaxed);
+			snapshot.count += snapshot.counts[i];
+		}
+		snapshot.sum_ns = m_sum_ns.load(std::memory_order_relaxed);
+		return snapshot;
+	}
+
+	std::uint64_t LatencyHistogram::Snapshot::quantile(double q) const noexcept {
+		if (count == 0) { return 0; }
+
+		const auto rank = static_cast<std::uint64_t>(std::clamp(q, 0.0, 1.0) * static_cast<double>(count - 1)) + 1;
+		std::uint64_t seen{ 0 };
+		for (std::size_t i{ 0 }; i < buckets; ++i) {
+			seen += counts[i];
+			if (seen >= rank) { return upper_bound_ns(i); }
+		}
+		return upper_bound_ns(buckets - 1);
+	}
+
+	ParserMetrics::ParserMetrics(std::vector<std::string_view> t_kinds, std::vector<std::string_view> t_reasons) :
+		m_kind_names(std::move(t_kinds)),
+		m_reason_names(std::move(t_reasons)),
+		m_kinds(m_kind_names.size()),
+		m_errors(m_reason_names.size())
+	{
+	}
+
+	ParserMetrics::Snapshot ParserMetrics::snapshot() const {
+		Snapshot snapshot;
+		snapshot.kinds.reserve(m_kinds.size());
+		for (std::size_t i{ 0 }; i < m_kinds.size(); ++i) {
+			snapshot.kinds.push_back(Kind{
+				m_kind_names[i],
+				m_kinds[i].count.get(),
+				m_kinds[i].parse.snapshot(),
+				m_kinds[i].handle.snapshot()
+			});
+		}
+		snapshot.errors.reserve(m_errors.size());
+		for (std::size_t i{ 0 }; i < m_errors.size(); ++i) {
+			snapshot.errors.push_back(Error{ m_reason_names[i], m_errors[i].get() });
+		}
+		return snapshot;
+	}
+
+	ConnectionMetrics::Snapshot ConnectionMetrics::snapshot(std::size_t queue_depth) const noexcept {
+		return Snapshot{
+			bytes_read.get(),
+			lines_read.get(),
+			bytes_written.get(),
+			lines_written.get(),
+			queue_depth,
+			write_wait.snapshot()
+		};
+	}
+
+	namespace {
+		// {connection="0",kind="PRIVMSG"}
+		std::string labels(std::string_view connection, std::string_view name = {}, std::string_view value = {}) {
+			std::string out{ "{connection=\"" };
+			out.append(connection).append("\"");
+			if (!name.empty()) { out.append(",").append(name).append("=\"").append(value).append("\""); }
+			return out + "}";
+		}
+
+		// cumulative buckets, empty tail buckets are left out, +Inf always closes it
+		void histogram(
+			std::ostringstream& out,
+			std::string_view metric,
+			const std::string& label_set,
+			const LatencyHistogram::Snapshot& snapshot
+		) {
+			const auto inner = label_set.substr(1, label_set.size() - 2);
+
+			std::size_t last{ 0 };
+			for (std::size_t i{ 0 }; i < LatencyHistogram::buckets; ++i) {
+				if (snapshot.counts[i] != 0) { last = i; }
+			}
+
+			std::uint64_t cumulative{ 0 };
+			for (std::size_t i{ 0 }; i <= last && i + 1 < LatencyHistogram::buckets; ++i) {
+				cumulative += snapshot.counts[i];
+				out << metric << "_bucket{" << inner << ",le=\""
+					<< static_cast<double>(LatencyHistogram::upper_bound_ns(i)) / 1e9 << "\"} " << cumulative << '\n';
+			}
+			out << metric << "_bucket{" << inner << ",le=\"+Inf\"} " << snapshot.count << '\n';
+			out << metric << "_sum" << label_set << ' ' << static_cast<double>(snapshot.sum_ns) / 1e9 << '\n';
+			out << metric << "_count" << label_set << ' ' << snapshot.count << '\n';
+		}
+	}
+
+	std::string to_prometheus(const std::vector<Snapshot>& snapshots) {
+		std::ostringstream out;
+
+		const auto counter = [&](std::string_view metric, std::string_view help, auto value_of) {
+			out << "# HELP " << metric << ' ' << help << '\n' << "# TYPE " << metric << " counter\n";
+			for (const auto& snapshot : snapshots) {
+				out << metric << labels(snapshot.connection) << ' ' << value_of(snapshot.socket) << '\n';
+			}
+		};
+		counter("twitch_irc_read_bytes_total", "Bytes of complete lines read from the socket",
+			[](const auto& socket) { return socket.bytes_read; });
+		counter("twitch_irc_read_lines_total", "Lines read from the socket",
+			[](const auto& socket) { return socket.lines_read; });
+		counter("twitch_irc_written_bytes_total", "Bytes written to the socket",
+			[](const auto& socket) { return socket.bytes_written; });
+		counter("twitch_irc_written_lines_total", "Lines written to the socket",
+			[](const auto& socket) { return socket.lines_written; });
+
+		out << "# HELP twitch_irc_write_queue_depth Lines waiting to be written\n"
+			<< "# TYPE twitch_irc_write_queue_depth gauge\n";
+		for (const auto& snapshot : snapshots) {
+			out << "twitch_irc_write_queue_depth" << labels(snapshot.connection) << ' ' << snapshot.socket.queue_depth << '\n';
+		}
+
+		out << "# HELP twitch_irc_write_wait_seconds Time from a line being ready to go to it leaving the socket\n"
+			<< "# TYPE twitch_irc_write_wait_seconds histogram\n";
+		for (const auto& snapshot : snapshots) {
+			histogram(out, "twitch_irc_write_wait_seconds", labels(snapshot.connection), snapshot.socket.write_wait);
+		}
+
+		out << "# HELP twitch_irc_messages_total Lines by what they were parsed into\n"
+			<< "# TYPE twitch_irc_messages_total counter\n";
+		for (const auto& snapshot : snapshots) {
+			for (const auto& kind : snapshot.parser.kinds) {
+				out << "twitch_irc_messages_total" << labels(snapshot.connection, "kind", kind.name) << ' ' << kind.count << '\n';
+			}
+		}
+
+		out << "# HELP twitch_irc_parse_errors_total Lines that didn't parse, by reason\n"
+			<< "# TYPE twitch_irc_parse_errors_total counter\n";
+		for (const auto& snapshot : snapshots) {
+			for (const auto& error : snapshot.parser.errors) {
+				out << "twitch_irc_parse_errors_total" << labels(snapshot.connection, "reason", error.reason) << ' ' << error.count << '\n';
+			}
+		}
+
+		out << "# HELP twitch_irc_parse_seconds Time spent in MessageParser::process\n"
+			<< "# TYPE twitch_irc_parse_seconds histogram\n";
+		for (const auto& snapshot : snapshots) {
+			for (const auto& kind : snapshot.parser.kinds) {
+				if (kind.parse.count != 0) { histogram(out, "twitch_irc_parse_seconds", labels(snapshot.connection, "kind", kind.name), kind.parse); }
+			}
+		}
+
+		out << "# HELP twitch_irc_handle_seconds Time spent in the ParserVisitor handler\n"
+			<< "# TYPE twitch_irc_handle_seconds histogram\n";
+		for (const auto& snapshot : snapshots) {
+			for (const auto& kind : snapshot.parser.kinds) {
+				if (kind.handle.count != 0) { histogram(out, "twitch_irc_handle_seconds", labels(snapshot.connection, "kind", kind.name), kind.handle); }
+			}
+		}
+
+		return out.str();
+	}
+
+	Reporter::Reporter(collect_t t_collect, std::string t_path, std::chrono::seconds t_period) :
+		m_collect(std::move(t_collect)),
+		m_path(std::move(t_path)),
+		m_period(t_period),
+		m_thread([this]() {
+			std::unique_lock<std::mutex> lock{ m_mutex };
+			while (!m_cv.wait_for(lock, m_period, [this]() { return m_stop; })) {
+				lock.unlock();
+				write();
+				lock.lock();
+			}
+		})
+	{
+	}
+
+	Reporter::~Reporter() {
+		{
+			std::lock_guard<std::mutex> lock{ m_mutex };
+			m_stop = true;
+		}
+		m_cv.notify_all();
+		m_thread.join();
+		write();
+	}
+
+	bool Reporter::write() const {
+		const auto temporary = m_path + ".tmp";
+		{
+			std::ofstream file{ temporary, std::ios::trunc };
+			if (!file) { return false; }
+			file << to_prometheus(m_collect());
+			if (!file) { return false; }
+		}
+		std::remove(m_path.c_str()); // rename doesn't replace on windows
+		return std::rename(temporary.c_str(), m_path.c_str()) == 0;
+	}
+} // namespace Twitch::irc::metrics
@@ -0,0 +1,175 @@
+#ifndef METRICS_H
+#define METRICS_H
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+/// counters and latency histograms of one connection and its parser
+/// every connection owns its own, written from its threads without locks
+/// and read through snapshot() from anywhere
+namespace Twitch::irc::metrics {
+	using clock_t = std::chrono::steady_clock;
+
+	class Counter
+	{
+	public:
+		inline void add(std::uint64_t n = 1) noexcept { m_value.fetch_add(n, std::memory_order_relaxed); }
+		inline std::uint64_t get() const noexcept { return m_value.load(std::memory_order_relaxed); }
+
+	private:
+		std::atomic<std::uint64_t> m_value{ 0 };
+	};
+
+	/// log2 buckets of nanoseconds, bucket i holds [2^(i-1), 2^i), the last one everything above
+	class LatencyHistogram
+	{
+	public:
+		static constexpr std::size_t buckets = 40; // 2^39 ns is about 9 minutes
+
+		struct Snapshot
+		{
+			std::array<std::uint64_t, buckets> counts{};
+			std::uint64_t count{ 0 };
+			std::uint64_t sum_ns{ 0 };
+
+			// upper bound of the bucket holding quantile q (0..1), 0 if nothing was recorded
+			std::uint64_t quantile(double q) const noexcept;
+		};
+
+		static constexpr std::uint64_t upper_bound_ns(std::size_t bucket) noexcept {
+			return std::uint64_t{ 1 } << bucket;
+		}
+		static std::size_t bucket_of(std::uint64_t ns) noexcept;
+
+		void record(clock_t::duration elapsed) noexcept;
+		Snapshot snapshot() const noexcept;
+
+	private:
+		std::array<std::atomic<std::uint64_t>, buckets> m_counts{};
+		std::atomic<std::uint64_t> m_sum_ns{ 0 };
+	};
+
+	/// what went through MessageParser, per result_t alternative
+	class ParserMetrics
+	{
+	public:
+		struct Kind
+		{
+			std::string_view name;
+			std::uint64_t count;
+			LatencyHistogram::Snapshot parse;
+			LatencyHistogram::Snapshot handle;
+		};
+
+		struct Error
+		{
+			std::string_view reason;
+			std::uint64_t count;
+		};
+
+		struct Snapshot
+		{
+			std::vector<Kind> kinds;
+			std::vector<Error> errors;
+		};
+
+		// names outlive the metrics, index in kinds is result_t::index()
+		ParserMetrics(std::vector<std::string_view> t_kinds, std::vector<std::string_view> t_reasons);
+
+		ParserMetrics(const ParserMetrics&) = delete;
+		ParserMetrics& operator=(const ParserMetrics&) = delete;
+
+		inline void parsed(std::size_t kind, clock_t::duration elapsed) noexcept {
+			m_kinds[kind].count.add();
+			m_kinds[kind].parse.record(elapsed);
+		}
+		inline void handled(std::size_t kind, clock_t::duration elapsed) noexcept {
+			m_kinds[kind].handle.record(elapsed);
+		}
+		inline void error(std::size_t reason) noexcept { m_errors[reason].add(); }
+
+		Snapshot snapshot() const;
+
+	private:
+		struct Slot
+		{
+			Counter count;
+			LatencyHistogram parse;
+			LatencyHistogram handle;
+		};
+
+		std::vector<std::string_view> m_kind_names;
+		std::vector<std::string_view> m_reason_names;
+		std::vector<Slot> m_kinds;
+		std::vector<Counter> m_errors;
+	};
+
+	/// socket side of a connection
+	struct ConnectionMetrics
+	{
+		struct Snapshot
+		{
+			std::uint64_t bytes_read{ 0 };
+			std::uint64_t lines_read{ 0 };
+			std::uint64_t bytes_written{ 0 };
+			std::uint64_t lines_written{ 0 };
+			std::size_t queue_depth{ 0 };          // lines waiting to be written
+			LatencyHistogram::Snapshot write_wait; // line ready to go -> socket, throttling included
+		};
+
+		Snapshot snapshot(std::size_t queue_depth) const noexcept;
+
+		Counter bytes_read;
+		Counter lines_read;
+		Counter bytes_written;
+		Counter lines_written;
+		LatencyHistogram write_wait;
+	};
+
+	struct Snapshot
+	{
+		std::string connection; // label, e.g. shard index
+		ParserMetrics::Snapshot parser;
+		ConnectionMetrics::Snapshot socket;
+	};
+
+	/// Prometheus text exposition format, histograms in seconds
+	std::string to_prometheus(const std::vector<Snapshot>& snapshots);
+
+	/// writes to_prometheus() of whatever collect returns to path every period,
+	/// through a temporary file so readers (e.g. node_exporter's textfile collector)
+	/// never see half of it
+	class Reporter
+	{
+	public:
+		using collect_t = std::function<std::vector<Snapshot>()>;
+
+		Reporter(collect_t t_collect, std::string t_path, std::chrono::seconds t_period);
+		~Reporter(); // writes one last time
+
+		Reporter(const Reporter&) = delete;
+		Reporter& operator=(const Reporter&) = delete;
+
+		bool write() const;
+
+	private:
+		collect_t m_collect;
+		std::string m_path;
+		std::chrono::seconds m_period;
+
+		std::mutex m_mutex{};
+		std::condition_variable m_cv{};
+		bool m_stop{ false };
+		std::thread m_thread; // last, runs with everything above
+	};
+} // namespace Twitch::irc::metrics
+#endif // METRICS_H
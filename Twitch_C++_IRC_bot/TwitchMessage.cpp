@@ -7,36 +7,60 @@
 #include <boost\log\trivial.hpp>
 #include <boost\algorithm\string\classification.hpp>
 #include <boost\algorithm\string\split.hpp>
-#include <boost\algorithm\string\replace.hpp>
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstdint>
 #include <iostream>
 #include <exception>
 #include <string_view>
-#include <sstream>
+#include <tuple>
 #include <type_traits>
 
+#if !defined(TWITCH_IRC_SCAN_SCALAR) && defined(__AVX2__)
+#define TWITCH_IRC_SCAN_AVX2
+#include <immintrin.h>
+#elif !defined(TWITCH_IRC_SCAN_SCALAR) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define TWITCH_IRC_SCAN_SSE2
+#include <emmintrin.h>
+#endif
+
 namespace { // helpers
 	using Twitch::irc::parameters::Badge;
 	using Twitch::irc::parameters::BadgeLevel;
 	using Twitch::irc::parameters::UserType;
+	using Twitch::irc::message::string_t;
 
-	std::map<Badge, BadgeLevel> get_badges(std::string_view raw_badges) {
-		if (raw_badges.empty()) { return {}; }
+	// owned copy of raw text, lands in the batch arena while one is open
+	inline string_t to_text(std::string_view raw) {
+		return string_t{ raw, Twitch::irc::BatchArena::resource() };
+	}
 
-		std::vector<std::string> splitted;
-		boost::split(
-			splitted,
-			raw_badges,
-			boost::is_any_of(",/"),
-			boost::algorithm::token_compress_on
-		);
-		if (splitted.size() % 2 != 0 || splitted.empty()) { return {}; }
+	// const members copy instead of moving, keeps the copy on the source's resource
+	inline string_t copy_text(const string_t& text) {
+		return string_t{ text, text.get_allocator() };
+	}
 
-		std::map<Badge, BadgeLevel> badges;
-		for (std::size_t i{ 0 }; i < splitted.size(); i += 2) {
-			badges.emplace(
-				Badge::from_string(splitted[i]),
-				std::stoi(splitted[i + 1])
-			);
+	// "name/level,name/level", malformed list gives no badges
+	Twitch::irc::parameters::Badges get_badges(std::string_view raw_badges) noexcept {
+		Twitch::irc::parameters::Badges badges;
+
+		std::size_t pos{ 0 };
+		while (pos < raw_badges.size()) {
+			const auto entry_end = std::min(raw_badges.find(',', pos), raw_badges.size());
+			const auto entry = raw_badges.substr(pos, entry_end - pos);
+			pos = entry_end + 1;
+			if (entry.empty()) { continue; }
+
+			const auto slash = entry.find('/');
+			if (slash == std::string_view::npos) { return {}; }
+
+			BadgeLevel level{ 0 };
+			const char* last = entry.data() + entry.size();
+			const auto [stop, err] = std::from_chars(entry.data() + slash + 1, last, level);
+			if (err != std::errc{} || stop != last) { return {}; }
+
+			badges.insert(Badge::from_string(entry.substr(0, slash)), level);
 		}
 		return badges;
 	}
@@ -46,117 +70,352 @@ namespace { // helpers
 		return raw_message == "1"sv;
 	}
 
-	std::vector<std::string> get_list_of_names(std::string_view raw_list) {
+	Twitch::irc::message::names_t get_list_of_names(std::string_view raw_list) {
 		using namespace std::string_view_literals;
-		if (raw_list == "End of /NAMES list"sv) { return {}; }
-
-		std::vector<std::string> names;
-		boost::split(
-			names,
-			raw_list,
-			[](auto c) -> bool { return c == ' '; },
-			boost::token_compress_on
-		);
+		Twitch::irc::message::names_t names{ Twitch::irc::BatchArena::resource() };
+		if (raw_list == "End of /NAMES list"sv) { return names; }
+
+		// the vector hands its resource down, every name lands on the arena too
+		for (std::size_t first{ 0 }; first < raw_list.size();) {
+			const auto last = std::min(raw_list.find(' ', first), raw_list.size());
+			if (last != first) { names.emplace_back(raw_list.substr(first, last - first)); }
+			first = last + 1;
+		}
 		return names;
 	}
 
-	unsigned int get_bits(std::string_view raw_bits) {
-		std::stringstream stream{ raw_bits.data() };
-		unsigned long bits{ 0 };
-		stream >> bits;
-		return bits;
+	inline unsigned int get_bits(std::string_view raw_bits) noexcept {
+		return Twitch::irc::parameters::parse_integer<unsigned int>(raw_bits).value_or(0);
 	}
 
+	// numeric and flag tags, missing or unparsable value == nullopt
 	template<typename T>
-	std::optional<T> get_optional(std::string&& raw) {
-		try {
-			std::stringstream str{ raw };
-			T result{};
-			str >> result;
-			return result;
-		}
-		catch (...) {
+	std::optional<T> get_optional(std::string_view raw) noexcept {
+		using Twitch::irc::parameters::timestamp_t;
+		using namespace std::string_view_literals;
+
+		if constexpr (std::is_same_v<T, bool>) {
+			if (raw == "1"sv) { return true; }
+			if (raw == "0"sv) { return false; }
 			return std::nullopt;
 		}
+		else if constexpr (std::is_same_v<T, timestamp_t>) {
+			return Twitch::irc::parameters::parse_seconds(raw).value;
+		}
+		else {
+			return Twitch::irc::parameters::parse_integer<T>(raw).value;
+		}
 	}
 
-	template<>
-	std::optional<bool> get_optional(std::string&& raw) {
-		using namespace std::string_literals;
-		if (raw == "1"s) { return 1; }
-		if (raw == "0"s) { return 0; }
+	// text tags
+	template<typename T>
+	std::optional<T> get_optional(string_t&& raw) {
+		static_assert(std::is_same_v<T, string_t>, "numeric tags are parsed from views");
+		if (raw.empty()) { return std::nullopt; }
 
-		return std::nullopt;
+		return std::move(raw);
 	}
 
-	template<>
-	std::optional<std::string> get_optional(std::string&& raw) {
-		if (raw.empty()) { return std::nullopt; }
+	inline Twitch::irc::parameters::timestamp_t get_ts(std::string_view raw) noexcept {
+		using namespace std::chrono_literals;
+		return Twitch::irc::parameters::parse_seconds(raw).value_or(0s);
+	}
 
-		return std::move(raw);
+	inline auto get_color(std::string_view raw_color) noexcept {
+		using Twitch::irc::parameters::Color;
+		using Twitch::irc::parameters::NoColor;
+
+		return Color::from_string(raw_color).value_or(Color{ NoColor{} });
 	}
 
-	template<>
-	std::optional<Twitch::irc::message::cap::tags::timestamp_t> get_optional(std::string&& raw) {
-		try {
-			return Twitch::irc::message::cap::tags::timestamp_t{ std::stoll(raw) };
-		}
-		catch (...) {
-			return std::nullopt;
+	// "\s" -> ' '
+	inline string_t unescape_spaces(std::string_view raw) {
+		string_t unescaped{ Twitch::irc::BatchArena::resource() };
+		unescaped.reserve(raw.size());
+		for (std::size_t i{ 0 }; i < raw.size(); ++i) {
+			if (raw[i] == '\\' && i + 1 < raw.size() && raw[i + 1] == 's') {
+				unescaped += ' ';
+				++i;
+			}
+			else { unescaped += raw[i]; }
 		}
+		return unescaped;
 	}
 
-	template<>
-	std::optional<int> get_optional(std::string&& raw) {
-		try {
-			return std::stoi(raw);
-		}
-		catch (...) {
-			return std::nullopt;
-		}
+	inline bool is_channel(std::string_view raw) noexcept {
+		return !raw.empty() && raw.front() == '#';
 	}
 
-	inline Twitch::irc::message::cap::tags::timestamp_t get_ts(std::string&& raw) {
-		using namespace std::chrono_literals;
-		return get_optional<Twitch::irc::message::cap::tags::timestamp_t>(std::move(raw)).value_or(0s);
+	// "nick!user@host", returns nick
+	inline std::string_view get_user(std::string_view prefix) noexcept {
+		return prefix.substr(0, prefix.find('!'));
 	}
 
-	auto get_color(const std::string& raw_color) {
-		using Twitch::irc::parameters::Color;
-		using Twitch::irc::parameters::NoColor;
+	// "nick!user@nick.tmi.twitch.tv", returns "tmi.twitch.tv"
+	inline std::string_view get_host(std::string_view prefix) noexcept {
+		const auto at = prefix.find('@');
+		if (at == std::string_view::npos) { return {}; }
 
-		// raw_color format = #RRGGBB
-		constexpr const std::size_t proper_length = 7;
-		if (raw_color.size() != proper_length) { return Color{ NoColor{} }; }
+		const auto dot = prefix.find('.', at);
+		if (dot == std::string_view::npos) { return {}; }
 
-		constexpr const std::size_t offset = 1;
-		constexpr const std::size_t length = 2;
-		constexpr const std::size_t r = offset;
-		constexpr const std::size_t g = r + length;
-		constexpr const std::size_t b = g + length;
+		return prefix.substr(dot + 1);
+	}
+
+	// tagged value or empty string if not present
+	inline string_t get_tag(
+		const Twitch::irc::message::TokenizedMessage& message, std::string_view key
+	) {
+		return to_text(message.tag(key).value_or(std::string_view{}));
+	}
+
+	inline string_t get_tag(const Twitch::irc::message::TagIndex& tags, std::string_view key) {
+		return to_text(tags.find(key).value_or(std::string_view{}));
+	}
 
-		return Color::from_string(
-			raw_color.substr(r, length),
-			raw_color.substr(g, length),
-			raw_color.substr(b, length)
+}
+
+namespace { // structural scan
+	constexpr std::array<bool, 256> structural_table = [] {
+		std::array<bool, 256> table{};
+		for (const unsigned char c : { ' ', ';', '=', ':', '\r', '\n' }) { table[c] = true; }
+		return table;
+	}();
+
+#if defined(TWITCH_IRC_SCAN_AVX2)
+	inline std::uint32_t mask_of_32(const char* data) noexcept {
+		const auto bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+		const auto is = [&](char c) { return _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(c)); };
+		const auto any = _mm256_or_si256(
+			_mm256_or_si256(_mm256_or_si256(is(' '), is(';')), _mm256_or_si256(is('='), is(':'))),
+			_mm256_or_si256(is('\r'), is('\n'))
+		);
+		return static_cast<std::uint32_t>(_mm256_movemask_epi8(any));
+	}
+
+	inline std::uint64_t mask_of_64(const char* data) noexcept {
+		return std::uint64_t{ mask_of_32(data) } | (std::uint64_t{ mask_of_32(data + 32) } << 32);
+	}
+#elif defined(TWITCH_IRC_SCAN_SSE2)
+	inline std::uint64_t mask_of_16(const char* data) noexcept {
+		const auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+		const auto is = [&](char c) { return _mm_cmpeq_epi8(bytes, _mm_set1_epi8(c)); };
+		const auto any = _mm_or_si128(
+			_mm_or_si128(_mm_or_si128(is(' '), is(';')), _mm_or_si128(is('='), is(':'))),
+			_mm_or_si128(is('\r'), is('\n'))
 		);
-	};
+		return static_cast<std::uint64_t>(static_cast<std::uint32_t>(_mm_movemask_epi8(any)));
+	}
 
+	inline std::uint64_t mask_of_64(const char* data) noexcept {
+		return mask_of_16(data)
+			| (mask_of_16(data + 16) << 16)
+			| (mask_of_16(data + 32) << 32)
+			| (mask_of_16(data + 48) << 48);
+	}
+#endif
 }
 
 namespace Twitch::irc::message {
-	const std::regex PING::regex{
-		"PING :(.+)[\r\n|\r|\n]?"
-	};
-	std::optional<PING> PING::is(std::string_view raw_message) {
-		std::cmatch match;
-		if (!std::regex_match(raw_message.data(), match, regex)) { return std::nullopt; }
+	std::uint64_t StructuralScanner::block_mask(std::string_view raw, std::size_t offset) noexcept {
+#if defined(TWITCH_IRC_SCAN_AVX2) || defined(TWITCH_IRC_SCAN_SSE2)
+		if (offset >= raw.size()) { return 0; }
+		if (raw.size() - offset >= block_size) { return mask_of_64(raw.data() + offset); }
+
+		// short tail, NUL padding is never structural
+		std::array<char, block_size> tail{};
+		std::copy_n(raw.data() + offset, raw.size() - offset, tail.data());
+		return mask_of_64(tail.data());
+#else
+		return block_mask_scalar(raw, offset);
+#endif
+	}
 
-		constexpr const size_t host = 1;
+	std::uint64_t StructuralScanner::block_mask_scalar(std::string_view raw, std::size_t offset) noexcept {
+		std::uint64_t mask{ 0 };
+		const auto last = std::min(raw.size(), offset + block_size);
+		for (auto i = offset; i < last; ++i) {
+			mask |= std::uint64_t{ structural_table[static_cast<unsigned char>(raw[i])] } << (i - offset);
+		}
+		return mask;
+	}
 
-		return PING{
-			match.str(host)
+	std::string_view StructuralScanner::implementation() noexcept {
+		using namespace std::string_view_literals;
+#if defined(TWITCH_IRC_SCAN_AVX2)
+		return "avx2"sv;
+#elif defined(TWITCH_IRC_SCAN_SSE2)
+		return "sse2"sv;
+#else
+		return "scalar"sv;
+#endif
+	}
+
+	std::optional<TokenizedMessage> TokenizedMessage::tokenize(std::string_view raw_message) noexcept {
+		while (!raw_message.empty()
+			&& (raw_message.back() == '\r' || raw_message.back() == '\n')) {
+			raw_message.remove_suffix(1);
+		}
+
+		TokenizedMessage message;
+		StructuralScanner scanner{ raw_message };
+		std::size_t pos{ 0 };
+		const auto end = raw_message.size();
+
+		const auto skip_spaces = [&] {
+			while (pos < end && raw_message[pos] == ' ') { ++pos; }
 		};
+		// positions only move forward, the ones skip_spaces stepped over are dropped here
+		const auto next_word = [&] {
+			const auto first = pos;
+			for (auto found = scanner.next(); found != StructuralScanner::npos; found = scanner.next()) {
+				if (found >= first && raw_message[found] == ' ') {
+					pos = found;
+					return raw_message.substr(first, pos - first);
+				}
+			}
+			pos = end;
+			return raw_message.substr(first);
+		};
+
+		if (pos < end && raw_message[pos] == '@') {
+			const auto first = pos + 1;
+			pos = message.tag_index.split(raw_message, first, scanner);
+			message.tags = raw_message.substr(first, pos - first);
+			message.tag_index.m_raw = message.tags;
+			skip_spaces();
+		}
+		if (pos < end && raw_message[pos] == ':') {
+			++pos;
+			message.prefix = next_word();
+			skip_spaces();
+		}
+
+		message.command = next_word();
+		if (message.command.empty()) { return std::nullopt; }
+
+		while (true) {
+			skip_spaces();
+			if (pos >= end) { break; }
+
+			if (raw_message[pos] == ':') {
+				message.trailing = raw_message.substr(pos + 1);
+				break;
+			}
+
+			const auto param = next_word();
+			if (message.params_count < max_params) {
+				message.params[message.params_count++] = param;
+			}
+		}
+
+		return message;
+	}
+
+	std::string_view TokenizedMessage::command_of(std::string_view raw_message) noexcept {
+		const auto skip_word = [&] {
+			const auto space = raw_message.find(' ');
+			raw_message.remove_prefix(space == std::string_view::npos ? raw_message.size() : space);
+			while (!raw_message.empty() && raw_message.front() == ' ') { raw_message.remove_prefix(1); }
+		};
+
+		if (!raw_message.empty() && raw_message.front() == '@') { skip_word(); }
+		if (!raw_message.empty() && raw_message.front() == ':') { skip_word(); }
+
+		return raw_message.substr(0, raw_message.find_first_of(" \r\n"));
+	}
+
+	void TagIndex::build() const noexcept {
+		StructuralScanner scanner{ m_raw };
+		split(m_raw, 0, scanner);
+	}
+
+	std::size_t TagIndex::split(std::string_view text, std::size_t first, StructuralScanner& scanner) const noexcept {
+		constexpr auto npos = StructuralScanner::npos;
+		m_built = true;
+
+		auto tag_begin = first;
+		auto equals = npos;
+		bool full{ false };
+		while (true) {
+			const auto found = scanner.next();
+			if (found != npos && found < first) { continue; }
+
+			const auto stop = found == npos ? text.size() : found;
+			const char c = found == npos ? ' ' : text[found];
+			const bool last = c == ' ';
+
+			if (full) {
+				if (!last) { continue; }
+				m_overflow = text.substr(tag_begin, stop - tag_begin);
+				return stop;
+			}
+
+			if (c == '=' && equals == npos) { equals = found; }
+			if (c != ';' && !last) { continue; } // ':' is a plain byte in tag values
+			if (last && stop == tag_begin) { return stop; } // "k=v;" has no empty tag at the end
+
+			if (m_count == inline_capacity) {
+				full = true; // the rest is scanned on a miss, only its end is left to find
+				if (!last) { continue; }
+				m_overflow = text.substr(tag_begin, stop - tag_begin);
+				return stop;
+			}
+
+			m_tags[m_count++] = equals == npos
+				? Tag{ text.substr(tag_begin, stop - tag_begin), std::string_view{} }
+				: Tag{ text.substr(tag_begin, equals - tag_begin), text.substr(equals + 1, stop - equals - 1) };
+
+			if (last) { return stop; }
+			tag_begin = stop + 1;
+			equals = npos;
+		}
+	}
+
+	std::optional<std::string_view> TagIndex::find(std::string_view key) const noexcept {
+		if (!m_built) { build(); }
+
+		for (std::size_t i{ 0 }; i < m_count; ++i) {
+			if (m_tags[i].key == key) { return m_tags[i].value; }
+		}
+
+		if (m_overflow.empty()) { return std::nullopt; }
+		return TokenizedMessage::find_tag(m_overflow, key);
+	}
+
+	std::size_t TagIndex::size() const noexcept {
+		if (!m_built) { build(); }
+		return m_overflow.empty() ? m_count : m_count + 1 + std::count(m_overflow.begin(), m_overflow.end(), ';');
+	}
+
+	std::optional<std::string_view> TokenizedMessage::find_tag(
+		std::string_view raw_tags, std::string_view key
+	) noexcept {
+		while (!raw_tags.empty()) {
+			const auto semicolon = raw_tags.find(';');
+			const auto tag       = raw_tags.substr(0, semicolon);
+
+			if (tag.size() >= key.size()
+				&& tag.compare(0, key.size(), key) == 0
+				&& (tag.size() == key.size() || tag[key.size()] == '=')) {
+				return tag.size() == key.size() ? std::string_view{} : tag.substr(key.size() + 1);
+			}
+
+			if (semicolon == std::string_view::npos) { break; }
+			raw_tags.remove_prefix(semicolon + 1);
+		}
+		return std::nullopt;
+	}
+
+	std::optional<PING> PING::is(std::string_view raw_message) {
+		const auto message = TokenizedMessage::tokenize(raw_message);
+		if (!message) { return std::nullopt; }
+
+		return is(*message);
+	}
+	bool PING::parse(const TokenizedMessage& message, Emplace<PING>& emplace) {
+		if (auto parsed = view::PING::is(message); parsed) { return emplace([&] { return parsed->to_owned(); }); }
+		return false;
 	}
 
 	bool operator==(const PING& lhs, const PING& rhs) {
@@ -167,24 +426,33 @@ namespace Twitch::irc::message {
 		return !(lhs == rhs);
 	}
 
-	const std::regex PRIVMSG::regex{
-		":([^!]+)!(?:[^@]+)@(?:[^.]+).([^ ]+) PRIVMSG (#[^ ]+) :(.+)[\r\n|\r|\n]?"
-	};
 	std::optional<PRIVMSG> PRIVMSG::is(std::string_view raw_message) {
-		std::cmatch match;
-		if (!std::regex_match(raw_message.data(), match, regex)) { return std::nullopt; }
-
-		constexpr const size_t user    = 1;
-		constexpr const size_t host    = 2;
-		constexpr const size_t channel = 3;
-		constexpr const size_t message = 4;
-
-		return PRIVMSG{
-			match.str(user),
-			match.str(host),
-			match.str(channel),
-			match.str(message)
-		};
+		const auto message = TokenizedMessage::tokenize(raw_message);
+		if (!message) { return std::nullopt; }
+
+		return is(*message);
+	}
+	bool PRIVMSG::parse(const TokenizedMessage& message, Emplace<PRIVMSG>& emplace) {
+		using namespace std::string_view_literals;
+		if (message.command != "PRIVMSG"sv || !message.tags.empty()) { return false; }
+
+		const auto channel = message.param(0);
+		if (!is_channel(channel) || !message.trailing || message.trailing->empty()) {
+			return false;
+		}
+
+		const auto user = get_user(message.prefix);
+		const auto host = get_host(message.prefix);
+		if (user.empty() || host.empty()) { return false; }
+
+		return emplace([&] {
+			return PRIVMSG{
+				to_text(user),
+				to_text(host),
+				to_text(channel),
+				to_text(*message.trailing)
+			};
+		});
 	}
 
 	bool operator==(const PRIVMSG& lhs, const PRIVMSG& rhs) {
@@ -200,21 +468,15 @@ namespace Twitch::irc::message {
 
 	namespace cap {
 		namespace membership {
-			const std::regex JOIN::regex{
-				// first 3 groups are identical
-				":(.+)!(?:.+)@(?:.+).tmi.twitch.tv JOIN (#.+)[\r\n|\r|\n]?"
-			};
 			std::optional<JOIN> JOIN::is(std::string_view raw_message) {
-				std::cmatch match;
-				if (!std::regex_match(raw_message.data(), match, regex)) { return std::nullopt; }
-
-				constexpr const size_t user    = 1;
-				constexpr const size_t channel = 2;
+				const auto message = TokenizedMessage::tokenize(raw_message);
+				if (!message) { return std::nullopt; }
 
-				return JOIN{
-					match.str(user),
-					match.str(channel)
-				};
+				return is(*message);
+			}
+			bool JOIN::parse(const TokenizedMessage& message, Emplace<JOIN>& emplace) {
+				if (auto parsed = view::JOIN::is(message); parsed) { return emplace([&] { return parsed->to_owned(); }); }
+				return false;
 			}
 
 			bool operator==(const JOIN& lhs, const JOIN& rhs) {
@@ -226,22 +488,32 @@ namespace Twitch::irc::message {
 				return !(lhs == rhs);
 			}
 
-			const std::regex MODE::regex{
-				":jtv MODE (#.+) ([+-])o (.+)[\r\n|\r|\n]?"
-			};
 			std::optional<MODE> MODE::is(std::string_view raw_message) {
-				std::cmatch match;
-				if (!std::regex_match(raw_message.data(), match, regex)) { return std::nullopt; }
-
-				constexpr const size_t channel = 1;
-				constexpr const size_t symbol  = 2;
-				constexpr const size_t user    = 3;
+				const auto message = TokenizedMessage::tokenize(raw_message);
+				if (!message) { return std::nullopt; }
 
-				return MODE{
-					match.str(channel),
-					match.str(symbol)[0] == '+',
-					match.str(user)
-				};
+				return is(*message);
+			}
+			bool MODE::parse(const TokenizedMessage& message, Emplace<MODE>& emplace) {
+				using namespace std::string_view_literals;
+				if (message.command != "MODE"sv || message.prefix != "jtv"sv) { return false; }
+
+				const auto channel = message.param(0);
+				const auto symbol  = message.param(1);
+				const auto user    = message.params_count > 2
+					? message.param(2)
+					: message.trailing.value_or(std::string_view{});
+
+				if (!is_channel(channel) || user.empty()) { return false; }
+				if (symbol != "+o"sv && symbol != "-o"sv) { return false; }
+
+				return emplace([&] {
+					return MODE{
+						to_text(channel),
+						symbol.front() == '+',
+						to_text(user)
+					};
+				});
 			}
 
 			bool operator==(const MODE& lhs, const MODE& rhs) {
@@ -254,25 +526,39 @@ namespace Twitch::irc::message {
 				return !(lhs == rhs);
 			}
 
-			const std::regex NAMES::regex{
-				":(.+).tmi.twitch.tv (353|366) (?:.+) (?:= )?(#.+) :(.+)[\r\n|\r|\n]?"
-			};
 			std::optional<NAMES> NAMES::is(std::string_view raw_message) {
-				std::cmatch match;
-				if (!std::regex_match(raw_message.data(), match, regex)) { return std::nullopt; }
-
-				constexpr const size_t user    = 1;
-				constexpr const size_t msg_id  = 2;
-				constexpr const size_t channel = 3;
-				constexpr const size_t list    = 4;
-
-				using namespace std::string_literals;
-				return NAMES{
-					match.str(user),
-					match.str(msg_id),
-					match.str(channel),
-					get_list_of_names(match.str(list))
-				};
+				const auto message = TokenizedMessage::tokenize(raw_message);
+				if (!message) { return std::nullopt; }
+
+				return is(*message);
+			}
+			bool NAMES::parse(const TokenizedMessage& message, Emplace<NAMES>& emplace) {
+				using namespace std::string_view_literals;
+				if (message.command != "353"sv && message.command != "366"sv) { return false; }
+				if (message.params_count < 2 || !message.trailing || message.trailing->empty()) {
+					return false;
+				}
+
+				// "<user>.tmi.twitch.tv"
+				constexpr auto host = ".tmi.twitch.tv"sv;
+				const auto prefix   = message.prefix;
+				if (prefix.size() <= host.size()
+					|| prefix.substr(prefix.size() - host.size()) != host) {
+					return false;
+				}
+
+				// 353: <user> = <channel>, 366: <user> <channel>
+				const auto channel = message.param(message.params_count - 1);
+				if (!is_channel(channel)) { return false; }
+
+				return emplace([&] {
+					return NAMES{
+						to_text(prefix.substr(0, prefix.size() - host.size())),
+						to_text(message.command),
+						to_text(channel),
+						get_list_of_names(*message.trailing)
+					};
+				});
 			}
 
 			bool operator==(const NAMES& lhs, const NAMES& rhs) {
@@ -286,21 +572,15 @@ namespace Twitch::irc::message {
 				return !(lhs == rhs);
 			}
 
-			const std::regex PART::regex{
-				// first 3 groups are identical
-				":(.+)!(?:.+)@(?:.+).tmi.twitch.tv PART (#.+)[\r\n|\r|\n]?"
-			};
 			std::optional<PART> PART::is(std::string_view raw_message) {
-				std::cmatch match;
-				if (!std::regex_match(raw_message.data(), match, regex)) { return std::nullopt; }
-
-				constexpr const size_t user = 1;
-				constexpr const size_t channel = 2;
+				const auto message = TokenizedMessage::tokenize(raw_message);
+				if (!message) { return std::nullopt; }
 
-				return PART{
-					match.str(user),
-					match.str(channel)
-				};
+				return is(*message);
+			}
+			bool PART::parse(const TokenizedMessage& message, Emplace<PART>& emplace) {
+				if (auto parsed = view::PART::is(message); parsed) { return emplace([&] { return parsed->to_owned(); }); }
+				return false;
 			}
 
 			bool operator==(const PART& lhs, const PART& rhs) {
@@ -333,44 +613,43 @@ namespace Twitch::irc::message {
 				return !(lhs > rhs);
 			}
 
-			const std::regex CLEARCHAT::regex{
-				"@(?:ban-duration=([0-9]+);)?(?:ban-reason=([^; ]*);)?"
-				"room-id=([^; ]+);(?:target-user-id=([^; ]+);)?tmi-sent-ts=([0-9]+)"
-				" :tmi.twitch.tv CLEARCHAT (#[^ ]+)(?: :(.+))?[\r\n|\r|\n]?"
-			};
 			std::optional<CLEARCHAT> CLEARCHAT::is(std::string_view raw_message) {
-				std::cmatch match;
-				if (!std::regex_match(raw_message.data(), match, regex)) { return std::nullopt; }
-
-				constexpr const size_t duration       = 1;
-				constexpr const size_t reason         = 2;
-				constexpr const size_t room_id        = 3;
-				constexpr const size_t target_user_id = 4;
-				constexpr const size_t tmi_sent_ts    = 5;
-				constexpr const size_t channel        = 6;
-				constexpr const size_t user           = 7;
-
-				return CLEARCHAT{
-					commands::CLEARCHAT{
-						match.str(channel), match.str(user)
-					},
-					get_optional<timestamp_t>(match.str(duration)),
-					get_optional<std::string>(boost::replace_all_copy(match.str(reason), R"(\s)", " ")),
-					match.str(room_id),
-					get_optional<std::string>(match.str(target_user_id)),
-					get_ts(match.str(tmi_sent_ts))
-				};
+				const auto message = TokenizedMessage::tokenize(raw_message);
+				if (!message) { return std::nullopt; }
+
+				return is(*message);
+			}
+			bool CLEARCHAT::parse(const TokenizedMessage& message, Emplace<CLEARCHAT>& emplace) {
+				using namespace std::string_view_literals;
+				if (message.command != "CLEARCHAT"sv || message.tags.empty()) { return false; }
+
+				const auto channel = message.param(0);
+				if (!is_channel(channel)) { return false; }
+
+				return emplace([&] {
+					return CLEARCHAT{
+						commands::CLEARCHAT{
+							to_text(channel),
+							to_text(message.trailing.value_or(std::string_view{}))
+						},
+						get_optional<timestamp_t>(message.tag("ban-duration"sv).value_or(""sv)),
+						get_optional<string_t>(unescape_spaces(get_tag(message, "ban-reason"sv))),
+						get_tag(message, "room-id"sv),
+						get_optional<string_t>(get_tag(message, "target-user-id"sv)),
+						get_ts(message.tag("tmi-sent-ts"sv).value_or(""sv))
+					};
+				});
 			}
 
 			CLEARCHAT::CLEARCHAT(
 				commands::CLEARCHAT&&        t_plain,
 				std::optional<timestamp_t>   t_duration,
-				std::optional<std::string>&& t_reason,
-				std::string&&                t_room_id,
-				std::optional<std::string>&& t_target_user_id,
+				std::optional<string_t>&&    t_reason,
+				string_t&&                   t_room_id,
+				std::optional<string_t>&&    t_target_user_id,
 				timestamp_t                  t_tmi_sent_ts
 			) :
-				cap::commands::CLEARCHAT{ std::move(t_plain) },
+				cap::commands::CLEARCHAT{ copy_text(t_plain.channel), copy_text(t_plain.user) },
 				ban_duration(t_duration),
 				ban_reason(std::move(t_reason)),
 				room_id(std::move(t_room_id)),
@@ -394,30 +673,26 @@ namespace Twitch::irc::message {
 				return !(lhs == rhs);
 			}
 
-			const std::regex GLOBALUSERSTATE::regex{
-				"@badges=([^; ]*);color=([^; ]*);display-name=([^; ]*);"
-				"emote-sets=([^; ]*);user-id=([^; ]+);user-type=([^ ]*)"
-				" :tmi.twitch.tv GLOBALUSERSTATE[\r\n|\r|\n]?"
-			};
 			std::optional<GLOBALUSERSTATE> GLOBALUSERSTATE::is(std::string_view raw_message) {
-				std::cmatch match;
-				if (!std::regex_match(raw_message.data(), match, regex)) { return std::nullopt; }
-
-				constexpr const size_t badges       = 1;
-				constexpr const size_t color        = 2;
-				constexpr const size_t display_name = 3;
-				constexpr const size_t emote_sets   = 4;
-				constexpr const size_t user_id      = 5;
-				constexpr const size_t user_type    = 6;
-
-				return GLOBALUSERSTATE{
-					get_badges(match.str(badges)),
-					get_color(match.str(color)),
-					match.str(display_name),
-					match.str(emote_sets),
-					match.str(user_id),
-					UserType::from_string(match.str(user_type))
-				};
+				const auto message = TokenizedMessage::tokenize(raw_message);
+				if (!message) { return std::nullopt; }
+
+				return is(*message);
+			}
+			bool GLOBALUSERSTATE::parse(const TokenizedMessage& message, Emplace<GLOBALUSERSTATE>& emplace) {
+				using namespace std::string_view_literals;
+				if (message.command != "GLOBALUSERSTATE"sv || message.tags.empty()) { return false; }
+
+				return emplace([&] {
+					return GLOBALUSERSTATE{
+						get_badges(message.tag("badges"sv).value_or(""sv)),
+						get_color(message.tag("color"sv).value_or(""sv)),
+						get_tag(message, "display-name"sv),
+						get_tag(message, "emote-sets"sv),
+						get_tag(message, "user-id"sv),
+						UserType::from_string(message.tag("user-type"sv).value_or(""sv))
+					};
+				});
 			}
 
 			bool operator==(const GLOBALUSERSTATE& lhs, const GLOBALUSERSTATE& rhs) {
@@ -433,78 +708,41 @@ namespace Twitch::irc::message {
 				return !(lhs == rhs);
 			}
 
-			const std::regex PRIVMSG::regex{
-				"@badges=([^;]*);(?:bits=([0-9]+);)?color=([^;]*);display-name=([^;]*);(?:emote-only=([01]);)?"
-				"emotes=([^;]*);id=([^;]+);mod=([01]);room-id=([0-9]+);subscriber=([01]);"
-				"tmi-sent-ts=([0-9]+);turbo=([01]);user-id=([0-9]+);user-type=([^ ]*)"
-				" :([^!]+)!(?:[^@]+)@(?:[^.]+).([^ ]+) PRIVMSG (#.+) :(.+)[\r\n|\r|\n]?"
-			};
 			std::optional<PRIVMSG> PRIVMSG::is(std::string_view raw_message) {
-				std::cmatch match;
-				if (!std::regex_match(raw_message.data(), match, regex)) { return std::nullopt; }
-
-				constexpr const size_t badges       = 1;
-				constexpr const size_t bits         = 2;
-				constexpr const size_t color        = 3;
-				constexpr const size_t display_name = 4;
-				constexpr const size_t emote_only   = 5;
-				constexpr const size_t emotes       = 6;
-				constexpr const size_t id           = 7;
-				constexpr const size_t mod          = 8;
-				constexpr const size_t room_id      = 9;
-				constexpr const size_t subscriber   = 10;
-				constexpr const size_t tmi_sent_ts  = 11;
-				constexpr const size_t turbo        = 12;
-				constexpr const size_t user_id      = 13;
-				constexpr const size_t user_type    = 14;
-				constexpr const size_t user         = 15;
-				constexpr const size_t host         = 16;
-				constexpr const size_t channel      = 17;
-				constexpr const size_t message      = 18;
-
-				return PRIVMSG{
-					message::PRIVMSG{
-						match.str(user),
-						match.str(host),
-						match.str(channel),
-						match.str(message)
-					},
-					get_badges(match.str(badges)),
-					get_bits(match.str(bits)),
-					get_color(match.str(color)),
-					match.str(display_name),
-					get_flag(match.str(emote_only)),
-					match.str(emotes),
-					match.str(id),
-					get_flag(match.str(mod)),
-					match.str(room_id),
-					get_flag(match.str(subscriber)),
-					get_ts(match.str(tmi_sent_ts)),
-					get_flag(match.str(turbo)),
-					match.str(user_id),
-					UserType::from_string(match.str(user_type))
-				};
+				const auto message = TokenizedMessage::tokenize(raw_message);
+				if (!message) { return std::nullopt; }
+
+				return is(*message);
+			}
+			bool PRIVMSG::parse(const TokenizedMessage& message, Emplace<PRIVMSG>& emplace) {
+				if (auto parsed = view::PRIVMSG::is(message); parsed) { return emplace([&] { return parsed->to_owned(); }); }
+				return false;
 			}
 
 			PRIVMSG::PRIVMSG(
 				message::PRIVMSG&&            t_plain,
-				std::map<Badge, BadgeLevel>&& t_badge,
+				Badges        t_badge,
 				unsigned int  t_bits,
 				Color         t_color,
-				std::string&& t_display_name,
+				string_t&&    t_display_name,
 				bool          t_emote_only,
-				std::string&& t_emotes,
-				std::string&& t_id,
+				string_t&&    t_emotes,
+				string_t&&    t_id,
 				bool          t_mod,
-				std::string&& t_room_id,
+				string_t&&    t_room_id,
 				bool          t_subscriber,
 				timestamp_t   t_tmi_sent_ts,
 				bool          t_turbo,
-				std::string&& t_user_id,
+				string_t&&    t_user_id,
 				UserType      t_user_type
 			) :
-				message::PRIVMSG{ std::move(t_plain) },
-				badges(std::move(t_badge)),
+				message::PRIVMSG{
+					copy_text(t_plain.user),
+					copy_text(t_plain.host),
+					copy_text(t_plain.channel),
+					copy_text(t_plain.message)
+				},
+				badges(t_badge),
 				bits(t_bits),
 				color(std::move(t_color)),
 				display_name(std::move(t_display_name)),
@@ -521,6 +759,10 @@ namespace Twitch::irc::message {
 			{
 			}
 
+			EmoteIndex PRIVMSG::emote_index() const {
+				return EmoteIndex::decode(emotes, message);
+			}
+
 			bool operator==(const PRIVMSG& lhs, const PRIVMSG& rhs) {
 				return lhs.id           == rhs.id
 					&& lhs.tmi_sent_ts  == rhs.tmi_sent_ts
@@ -544,58 +786,52 @@ namespace Twitch::irc::message {
 				return !(lhs == rhs);
 			}
 
-			const std::regex ROOMSTATE::regex{
-				"@(?:broadcaster-lang=([^; ]*);)?(?:emote-only=([01]);)?"
-				"(?:followers-only=([0-9]+|-1);)?(?:r9k=([01]);)?"
-				"(?:rituals=([^; ]+);)?room-id=([^; ]+);?"
-				"(?:slow=([0-9]+);?)?(?:subs-only=([01]))?"
-				" :tmi.twitch.tv ROOMSTATE (#.+)[\r\n|\r|\n]?"
-			};
 			std::optional<ROOMSTATE> ROOMSTATE::is(std::string_view raw_message) {
-				std::cmatch match;
-				if (!std::regex_match(raw_message.data(), match, regex)) { return std::nullopt; }
-
-				constexpr const size_t broadcaster_lang = 1;
-				constexpr const size_t emote_only       = 2;
-				constexpr const size_t followers_only   = 3;
-				constexpr const size_t r9k              = 4;
-				constexpr const size_t rituals          = 5;
-				constexpr const size_t room_id          = 6;
-				constexpr const size_t slow             = 7;
-				constexpr const size_t subs_only        = 8;
-				constexpr const size_t channel          = 9;
-
-				return ROOMSTATE{
-					cap::commands::ROOMSTATE{ match.str(channel) },
-					get_optional<std::string>(match.str(broadcaster_lang)),
-					get_optional<bool>(match.str(emote_only)),
-					get_optional<int>(match.str(followers_only)),
-					get_optional<bool>(match.str(r9k)),
-					get_optional<std::string>(match.str(rituals)),
-					match.str(room_id),
-					get_optional<timestamp_t>(match.str(slow)),
-					get_optional<bool>(match.str(subs_only))
-				};
+				const auto message = TokenizedMessage::tokenize(raw_message);
+				if (!message) { return std::nullopt; }
+
+				return is(*message);
+			}
+			bool ROOMSTATE::parse(const TokenizedMessage& message, Emplace<ROOMSTATE>& emplace) {
+				using namespace std::string_view_literals;
+				if (message.command != "ROOMSTATE"sv || message.tags.empty()) { return false; }
+
+				const auto channel = message.param(0);
+				if (!is_channel(channel)) { return false; }
+
+				return emplace([&] {
+					return ROOMSTATE{
+						cap::commands::ROOMSTATE{ to_text(channel) },
+						get_optional<string_t>(get_tag(message, "broadcaster-lang"sv)),
+						get_optional<bool>(message.tag("emote-only"sv).value_or(""sv)),
+						get_optional<int>(message.tag("followers-only"sv).value_or(""sv)),
+						get_optional<bool>(message.tag("r9k"sv).value_or(""sv)),
+						get_optional<string_t>(get_tag(message, "rituals"sv)),
+						get_tag(message, "room-id"sv),
+						get_optional<timestamp_t>(message.tag("slow"sv).value_or(""sv)),
+						get_optional<bool>(message.tag("subs-only"sv).value_or(""sv))
+					};
+				});
 			}
 
 			ROOMSTATE::ROOMSTATE(
 				cap::commands::ROOMSTATE&&   t_roomstate,
-				std::optional<std::string>&& t_lang,
+				std::optional<string_t>&&    t_lang,
 				std::optional<bool>          t_emote_only,
 				std::optional<int>           t_followers_only,
 				std::optional<bool>          t_r9k,
-				std::optional<std::string>&& t_rituals,
-				std::string&&                t_room_id,
+				std::optional<string_t>&&    t_rituals,
+				string_t&&                   t_room_id,
 				std::optional<timestamp_t>   t_slow,
 				std::optional<bool>          t_subs_only
 			) :
-				cap::commands::ROOMSTATE{ t_roomstate },
+				cap::commands::ROOMSTATE{ copy_text(t_roomstate.channel) },
 				broadcaster_lang(std::move(t_lang)),
 				emote_only(t_emote_only),
 				followers_only(t_followers_only),
 				r9k(t_r9k),
-				rituals(t_rituals),
-				room_id(t_room_id),
+				rituals(std::move(t_rituals)),
+				room_id(std::move(t_room_id)),
 				slow(t_slow),
 				subs_only(t_subs_only)
 			{
@@ -632,21 +868,21 @@ namespace Twitch::irc::message {
 				return !(lhs == rhs);
 			}
 
-			const std::regex USERNOTICE::Sub::regex{
-				"msg-id=(?:sub|resub);msg-param-months=([0-9]+);msg-param-sub-plan=([^;]+);msg-param-sub-plan-name=(.+)"
-			};
 			std::optional<USERNOTICE::Sub> USERNOTICE::Sub::is(std::string_view raw_message) {
-				std::cmatch match;
-				if (!std::regex_match(raw_message.data(), match, regex)) { return std::nullopt; }
+				return is(TagIndex{ raw_message });
+			}
+			std::optional<USERNOTICE::Sub> USERNOTICE::Sub::is(const TagIndex& tags) {
+				using namespace std::string_view_literals;
+				const auto msg_id = tags.find("msg-id"sv);
+				if (msg_id != "sub"sv && msg_id != "resub"sv) { return std::nullopt; }
 
-				constexpr const std::size_t months        = 1;
-				constexpr const std::size_t sub_plan      = 2;
-				constexpr const std::size_t sub_plan_name = 3;
+				const auto months = get_optional<int>(tags.find("msg-param-months"sv).value_or(""sv));
+				if (!months) { return std::nullopt; }
 
 				return Sub{
-					std::atoi(match.str(months).c_str()),
-					match.str(sub_plan),
-					boost::replace_all_copy(match.str(sub_plan_name), R"(\s)", " ")
+					*months,
+					get_tag(tags, "msg-param-sub-plan"sv),
+					unescape_spaces(get_tag(tags, "msg-param-sub-plan-name"sv))
 				};
 			}
 
@@ -660,29 +896,23 @@ namespace Twitch::irc::message {
 				return !(lhs == rhs);
 			}
 
-			const std::regex USERNOTICE::Subgift::regex{
-				"msg-id=subgift;msg-param-months=([0-9]+);msg-param-recipient-display-name=([^;]*);"
-				"msg-param-recipient-id=([^;]+);msg-param-recipient-name=([^;]+);"
-				"msg-param-sub-plan-name=([^;]*);msg-param-sub-plan=(.+)"
-			};
 			std::optional<USERNOTICE::Subgift> USERNOTICE::Subgift::is(std::string_view raw_message) {
-				std::cmatch match;
-				if (!std::regex_match(raw_message.data(), match, regex)) { return std::nullopt; }
+				return is(TagIndex{ raw_message });
+			}
+			std::optional<USERNOTICE::Subgift> USERNOTICE::Subgift::is(const TagIndex& tags) {
+				using namespace std::string_view_literals;
+				if (tags.find("msg-id"sv) != "subgift"sv) { return std::nullopt; }
 
-				constexpr const size_t months                 = 1;
-				constexpr const size_t recipient_display_name = 2;
-				constexpr const size_t recipient_id           = 3;
-				constexpr const size_t recipient_name         = 4;
-				constexpr const size_t sub_plan_name          = 5;
-				constexpr const size_t sub_plan               = 6;
+				const auto months = get_optional<int>(tags.find("msg-param-months"sv).value_or(""sv));
+				if (!months) { return std::nullopt; }
 
 				return Subgift{
-					std::atoi(match.str(months).c_str()),
-					match.str(recipient_display_name),
-					match.str(recipient_id),
-					match.str(recipient_name),
-					boost::replace_all_copy(match.str(sub_plan_name), R"(\s)", " "),
-					match.str(sub_plan),
+					*months,
+					get_tag(tags, "msg-param-recipient-display-name"sv),
+					get_tag(tags, "msg-param-recipient-id"sv),
+					get_tag(tags, "msg-param-recipient-name"sv),
+					unescape_spaces(get_tag(tags, "msg-param-sub-plan-name"sv)),
+					get_tag(tags, "msg-param-sub-plan"sv)
 				};
 			}
 
@@ -699,21 +929,17 @@ namespace Twitch::irc::message {
 				return !(lhs == rhs);
 			}
 
-			const std::regex USERNOTICE::Raid::regex{
-				"msg-id=raid;msg-param-displayName=([^;]*);msg-param-login=([^;]+);msg-param-viewerCount=([0-9]*)"
-			};
 			std::optional<USERNOTICE::Raid> USERNOTICE::Raid::is(std::string_view raw_message) {
-				std::cmatch match;
-				if (!std::regex_match(raw_message.data(), match, regex)) { return std::nullopt; }
-
-				constexpr const size_t display_name = 1;
-				constexpr const size_t login        = 2;
-				constexpr const size_t viewer_count = 3;
+				return is(TagIndex{ raw_message });
+			}
+			std::optional<USERNOTICE::Raid> USERNOTICE::Raid::is(const TagIndex& tags) {
+				using namespace std::string_view_literals;
+				if (tags.find("msg-id"sv) != "raid"sv) { return std::nullopt; }
 
 				return Raid{
-					match.str(display_name),
-					match.str(login),
-					std::atoi(match.str(viewer_count).c_str())
+					get_tag(tags, "msg-param-displayName"sv),
+					get_tag(tags, "msg-param-login"sv),
+					get_optional<int>(tags.find("msg-param-viewerCount"sv).value_or(""sv)).value_or(0)
 				};
 			}
 
@@ -728,9 +954,14 @@ namespace Twitch::irc::message {
 			}
 
 			std::optional<USERNOTICE::Ritual> USERNOTICE::Ritual::is(std::string_view raw_message) {
+				return is(TagIndex{ raw_message });
+			}
+			std::optional<USERNOTICE::Ritual> USERNOTICE::Ritual::is(const TagIndex& tags) {
 				using namespace std::string_view_literals;
-				const auto ritual = "msg-id=ritual;msg-param-ritual-name=new_chatter"sv;
-				if (raw_message != ritual) { return std::nullopt; }
+				if (tags.find("msg-id"sv) != "ritual"sv) { return std::nullopt; }
+				if (tags.find("msg-param-ritual-name"sv) != "new_chatter"sv) {
+					return std::nullopt;
+				}
 
 				return Ritual{};
 			}
@@ -743,86 +974,77 @@ namespace Twitch::irc::message {
 				return !(lhs == rhs);
 			}
 
-			const std::regex USERNOTICE::regex{
-				"@badges=(.*);color=(.*);display-name=(.*);emotes=(.*);"
-				"id=(.+);login=(.+);mod=([01]);(msg-id=.+);room-id=(.+);"
-				"subscriber=([01]);system-msg=(.*);tmi-sent-ts=([0-9]+);turbo=([01]);"
-				"user-id=(.+);user-type=(.*) :tmi.twitch.tv USERNOTICE (#[^ ]+)(?: :(.+))?[\r\n|\r|\n]?"
-			};
 			std::optional<USERNOTICE> USERNOTICE::is(std::string_view raw_message) {
-				std::cmatch match;
-				if (!std::regex_match(raw_message.data(), match, regex)) { return std::nullopt; }
-
-				constexpr const size_t badge        = 1;
-				constexpr const size_t color        = 2;
-				constexpr const size_t display_name = 3;
-				constexpr const size_t emotes       = 4;
-				constexpr const size_t id           = 5;
-				constexpr const size_t login        = 6;
-				constexpr const size_t mod          = 7;
-				constexpr const size_t msg_id       = 8;
-				constexpr const size_t room_id      = 9;
-				constexpr const size_t subscriber   = 10;
-				constexpr const size_t system_msg   = 11;
-				constexpr const size_t tmi_sent_ts  = 12;
-				constexpr const size_t turbo        = 13;
-				constexpr const size_t user_id      = 14;
-				constexpr const size_t user_type    = 15;
-				constexpr const size_t channel      = 16;
-				constexpr const size_t message      = 17;
+				const auto message = TokenizedMessage::tokenize(raw_message);
+				if (!message) { return std::nullopt; }
+
+				return is(*message);
+			}
+			bool USERNOTICE::parse(const TokenizedMessage& message, Emplace<USERNOTICE>& emplace) {
+				using namespace std::string_view_literals;
+				if (message.command != "USERNOTICE"sv || message.tags.empty()) { return false; }
+
+				const auto channel = message.param(0);
+				if (!is_channel(channel)) { return false; }
 
 				const auto get_msg_id_details =
 					[&]() -> std::remove_const_t<decltype(USERNOTICE::msg_id)>
 					{
-						const auto raw_msg_id = match.str(msg_id);
-						if (auto parsed = Sub::is(raw_msg_id))     { return std::move(*parsed); }
-						if (auto parsed = Subgift::is(raw_msg_id)) { return std::move(*parsed); }
-						if (auto parsed = Raid::is(raw_msg_id))    { return std::move(*parsed); }
-						if (auto parsed = Ritual::is(raw_msg_id))  { return *parsed; }
-					
+						// details are scattered between msg-id and msg-param-* tags
+						const auto& tags = message.tag_index;
+						if (auto parsed = Sub::is(tags))     { return std::move(*parsed); }
+						if (auto parsed = Subgift::is(tags)) { return std::move(*parsed); }
+						if (auto parsed = Raid::is(tags))    { return std::move(*parsed); }
+						if (auto parsed = Ritual::is(tags))  { return *parsed; }
+
 						return ParseError{};
 					};
-				
-				return USERNOTICE{
-					cap::commands::USERNOTICE{ match.str(channel), match.str(message) },
-					get_badges(match.str(badge)),
-					get_color(match.str(color)),
-					match.str(display_name),
-					match.str(emotes),
-					match.str(id),
-					match.str(login),
-					get_flag(match.str(mod)),
-					get_msg_id_details(),
-					match.str(room_id),
-					get_flag(match.str(subscriber)),
-					boost::replace_all_copy(match.str(system_msg), R"(\s)", " "),
-					get_ts(match.str(tmi_sent_ts)),
-					get_flag(match.str(turbo)),
-					match.str(user_id),
-					UserType::from_string(match.str(user_type))
-				};
+
+				return emplace([&] {
+					return USERNOTICE{
+						cap::commands::USERNOTICE{
+							to_text(channel),
+							to_text(message.trailing.value_or(std::string_view{}))
+						},
+						get_badges(message.tag("badges"sv).value_or(""sv)),
+						get_color(message.tag("color"sv).value_or(""sv)),
+						get_tag(message, "display-name"sv),
+						get_tag(message, "emotes"sv),
+						get_tag(message, "id"sv),
+						get_tag(message, "login"sv),
+						get_flag(message.tag("mod"sv).value_or(""sv)),
+						get_msg_id_details(),
+						get_tag(message, "room-id"sv),
+						get_flag(message.tag("subscriber"sv).value_or(""sv)),
+						unescape_spaces(get_tag(message, "system-msg"sv)),
+						get_ts(message.tag("tmi-sent-ts"sv).value_or(""sv)),
+						get_flag(message.tag("turbo"sv).value_or(""sv)),
+						get_tag(message, "user-id"sv),
+						UserType::from_string(message.tag("user-type"sv).value_or(""sv))
+					};
+				});
 			}
 
 			USERNOTICE::USERNOTICE(
 				cap::commands::USERNOTICE&&   t_usernotice,
-				std::map<Badge, BadgeLevel>&& t_badges,
+				Badges        t_badges,
 				Color         t_color,
-				std::string&& t_display_name,
-				std::string&& t_emotes,
-				std::string&& t_id,
-				std::string&& t_login,
+				string_t&&    t_display_name,
+				string_t&&    t_emotes,
+				string_t&&    t_id,
+				string_t&&    t_login,
 				bool          t_mod,
 				boost::variant<ParseError, Sub, Subgift, Raid, Ritual>&& t_msg_id,
-				std::string&& t_room_id,
+				string_t&&    t_room_id,
 				bool          t_subscriber,
-				std::string&& t_system_msg,
+				string_t&&    t_system_msg,
 				timestamp_t   t_tmi_sent_ts,
 				bool          t_turbo,
-				std::string&& t_user_id,
+				string_t&&    t_user_id,
 				UserType      t_user_type
 			) :
-				cap::commands::USERNOTICE{ std::move(t_usernotice) },
-				badges(std::move(t_badges)),
+				cap::commands::USERNOTICE{ copy_text(t_usernotice.channel), copy_text(t_usernotice.message) },
+				badges(t_badges),
 				color(std::move(t_color)),
 				display_name(std::move(t_display_name)),
 				emotes(std::move(t_emotes)),
@@ -865,50 +1087,45 @@ namespace Twitch::irc::message {
 				return !(lhs == rhs);
 			}
 
-			const std::regex USERSTATE::regex{
-				"@badges=([^; ]*);color=([^; ]*);display-name=([^; ]*);"
-				"emote-sets=([^; ]*);mod=([01]);subscriber=([01]);"
-				"user-type=([^; ]*)"
-				" :tmi.twitch.tv USERSTATE (#.+)[\r\n|\r|\n]?"
-			};
 			std::optional<USERSTATE> USERSTATE::is(std::string_view raw_message) {
-				std::cmatch match;
-				if (!std::regex_match(raw_message.data(), match, regex)) { return std::nullopt; }
-
-				constexpr const size_t badges       = 1;
-				constexpr const size_t color        = 2;
-				constexpr const size_t display_name = 3;
-				constexpr const size_t emote_sets   = 4;
-				constexpr const size_t mod          = 5;
-				constexpr const size_t subscriber   = 6;
-				constexpr const size_t user_type    = 7;
-				constexpr const size_t channel      = 8;
-
-				using namespace std::string_literals;
-				return USERSTATE{
-					cap::commands::USERSTATE{ match.str(channel) },
-					get_badges(match.str(badges)),
-					get_color(match.str(color)),
-					match.str(display_name),
-					match.str(emote_sets),
-					get_flag(match.str(mod)),
-					get_flag(match.str(subscriber)),
-					UserType::from_string(match.str(user_type))
-				};
+				const auto message = TokenizedMessage::tokenize(raw_message);
+				if (!message) { return std::nullopt; }
+
+				return is(*message);
+			}
+			bool USERSTATE::parse(const TokenizedMessage& message, Emplace<USERSTATE>& emplace) {
+				using namespace std::string_view_literals;
+				if (message.command != "USERSTATE"sv || message.tags.empty()) { return false; }
+
+				const auto channel = message.param(0);
+				if (!is_channel(channel)) { return false; }
+
+				return emplace([&] {
+					return USERSTATE{
+						cap::commands::USERSTATE{ to_text(channel) },
+						get_badges(message.tag("badges"sv).value_or(""sv)),
+						get_color(message.tag("color"sv).value_or(""sv)),
+						get_tag(message, "display-name"sv),
+						get_tag(message, "emote-sets"sv),
+						get_flag(message.tag("mod"sv).value_or(""sv)),
+						get_flag(message.tag("subscriber"sv).value_or(""sv)),
+						UserType::from_string(message.tag("user-type"sv).value_or(""sv))
+					};
+				});
 			}
 
 			USERSTATE::USERSTATE(
 				cap::commands::USERSTATE&&    t_userstate,
-				std::map<Badge, BadgeLevel>&& t_badges,
+				Badges        t_badges,
 				Color         t_color,
-				std::string&& t_display_name,
-				std::string&& t_emote_sets,
+				string_t&&    t_display_name,
+				string_t&&    t_emote_sets,
 				bool          t_mod,
 				bool          t_subscriber,
 				UserType      t_user_type
 			) :
-				cap::commands::USERSTATE{ std::move(t_userstate) },
-				badges(std::move(t_badges)),
+				cap::commands::USERSTATE{ copy_text(t_userstate.channel) },
+				badges(t_badges),
 				color(std::move(t_color)),
 				display_name(std::move(t_display_name)),
 				emote_sets(std::move(t_emote_sets)),
@@ -937,20 +1154,28 @@ namespace Twitch::irc::message {
 
 		}
 		namespace commands {
-			const std::regex CLEARCHAT::regex{
-				":tmi.twitch.tv CLEARCHAT (#[^ ]+)(?: :(.+))?[\r\n|\r|\n]?"
-			};
 			std::optional<CLEARCHAT> CLEARCHAT::is(std::string_view raw_message) {
-				std::cmatch match;
-				if (!std::regex_match(raw_message.data(), match, regex)) { return std::nullopt; }
+				const auto message = TokenizedMessage::tokenize(raw_message);
+				if (!message) { return std::nullopt; }
 
-				constexpr const std::size_t channel = 1;
-				constexpr const std::size_t user    = 2;
+				return is(*message);
+			}
+			bool CLEARCHAT::parse(const TokenizedMessage& message, Emplace<CLEARCHAT>& emplace) {
+				using namespace std::string_view_literals;
+				if (message.command != "CLEARCHAT"sv || !message.tags.empty()
+					|| message.prefix != "tmi.twitch.tv"sv) {
+					return false;
+				}
 
-				return CLEARCHAT{
-					match.str(channel),
-					match.str(user)
-				};
+				const auto channel = message.param(0);
+				if (!is_channel(channel)) { return false; }
+
+				return emplace([&] {
+					return CLEARCHAT{
+						to_text(channel),
+						to_text(message.trailing.value_or(std::string_view{}))
+					};
+				});
 			}
 
 			bool operator==(const CLEARCHAT& lhs, const CLEARCHAT& rhs) {
@@ -962,22 +1187,57 @@ namespace Twitch::irc::message {
 				return !(lhs == rhs);
 			}
 
-			const std::regex HOSTTARGET::regex{
-				R"(:tmi.twitch.tv HOSTTARGET (#[^ ]+) (?:([^ ]+)|:-)(?:\[([0-9]*)\]| -)?[\r\n|\r|\n]?)"
-			};
 			std::optional<HOSTTARGET> HOSTTARGET::is(std::string_view raw_message) {
-				std::cmatch match;
-				if (!std::regex_match(raw_message.data(), match, regex)) { return std::nullopt; }
+				const auto message = TokenizedMessage::tokenize(raw_message);
+				if (!message) { return std::nullopt; }
+
+				return is(*message);
+			}
+			bool HOSTTARGET::parse(const TokenizedMessage& message, Emplace<HOSTTARGET>& emplace) {
+				using namespace std::string_view_literals;
+				if (message.command != "HOSTTARGET"sv || !message.tags.empty()
+					|| message.prefix != "tmi.twitch.tv"sv) {
+					return false;
+				}
 
-				constexpr const std::size_t hosting_channel = 1;
-				constexpr const std::size_t target_channel  = 2;
-				constexpr const std::size_t viewers_count   = 3;
+				const auto hosting_channel = message.param(0);
+				if (!is_channel(hosting_channel)) { return false; }
 
-				return HOSTTARGET{
-					match.str(hosting_channel),
-					match.str(target_channel),
-					get_optional<int>(match.str(viewers_count))
-				};
+				// "<channel> [<viewers>]", ":<channel> -" or ":- [<viewers>]"
+				std::array<std::string_view, 2> words{};
+				std::size_t count{ 0 };
+				for (std::size_t i{ 1 }; i < message.params_count && count < words.size(); ++i) {
+					words[count++] = message.param(i);
+				}
+				if (message.trailing) {
+					auto rest = *message.trailing;
+					while (!rest.empty() && count < words.size()) {
+						const auto space = rest.find(' ');
+						words[count++] = rest.substr(0, space);
+						rest = space == std::string_view::npos ? std::string_view{} : rest.substr(space + 1);
+					}
+				}
+				if (count == 0) { return false; }
+
+				const auto target_channel = words[0] == "-"sv ? std::string_view{} : words[0];
+				const auto viewers_count  = [&]() -> std::optional<int> {
+					if (count < 2) { return std::nullopt; }
+
+					auto raw = words[1];
+					if (raw == "-"sv) { return 0; }
+					if (raw.size() >= 2 && raw.front() == '[' && raw.back() == ']') {
+						raw = raw.substr(1, raw.size() - 2);
+					}
+					return get_optional<int>(raw);
+				}();
+
+				return emplace([&] {
+					return HOSTTARGET{
+						to_text(hosting_channel),
+						to_text(target_channel),
+						viewers_count
+					};
+				});
 			}
 
 			bool operator==(const HOSTTARGET& lhs, const HOSTTARGET& rhs) {
@@ -990,22 +1250,28 @@ namespace Twitch::irc::message {
 				return !(lhs == rhs);
 			}
 
-			const std::regex NOTICE::regex{
-				"@msg-id=(.+) :tmi.twitch.tv NOTICE (#.+) :(.+)[\r\n|\r|\n]?"
-			};
 			std::optional<NOTICE> NOTICE::is(std::string_view raw_message) {
-				std::cmatch match;
-				if (!std::regex_match(raw_message.data(), match, regex)) { return std::nullopt; }
-
-				constexpr const std::size_t msg_id  = 1;
-				constexpr const std::size_t channel = 2;
-				constexpr const std::size_t message = 3;
+				const auto message = TokenizedMessage::tokenize(raw_message);
+				if (!message) { return std::nullopt; }
 
-				return NOTICE{
-					match.str(msg_id),
-					match.str(channel),
-					match.str(message)
-				};
+				return is(*message);
+			}
+			bool NOTICE::parse(const TokenizedMessage& message, Emplace<NOTICE>& emplace) {
+				using namespace std::string_view_literals;
+				if (message.command != "NOTICE"sv) { return false; }
+
+				const auto msg_id  = message.tag("msg-id"sv);
+				const auto channel = message.param(0);
+				if (!msg_id || msg_id->empty() || !is_channel(channel)) { return false; }
+				if (!message.trailing || message.trailing->empty()) { return false; }
+
+				return emplace([&] {
+					return NOTICE{
+						to_text(*msg_id),
+						to_text(channel),
+						to_text(*message.trailing)
+					};
+				});
 			}
 
 			bool operator==(const NOTICE& lhs, const NOTICE& rhs) {
@@ -1018,14 +1284,20 @@ namespace Twitch::irc::message {
 				return !(lhs == rhs);
 			}
 
-			const std::regex RECONNECT::regex{
-				":tmi.twitch.tv RECONNECT[\r\n|\r|\n]?"
-			};
 			std::optional<RECONNECT> RECONNECT::is(std::string_view raw_message) {
-				std::cmatch match;
-				if (!std::regex_match(raw_message.data(), match, regex)) { return std::nullopt; }
+				const auto message = TokenizedMessage::tokenize(raw_message);
+				if (!message) { return std::nullopt; }
+
+				return is(*message);
+			}
+			bool RECONNECT::parse(const TokenizedMessage& message, Emplace<RECONNECT>& emplace) {
+				using namespace std::string_view_literals;
+				if (message.command != "RECONNECT"sv || !message.tags.empty()
+					|| message.prefix != "tmi.twitch.tv"sv) {
+					return false;
+				}
 
-				return RECONNECT{};
+				return emplace([&] { return RECONNECT{}; });
 			}
 
 			bool operator==(const RECONNECT& lhs, const RECONNECT& rhs) {
@@ -1036,18 +1308,27 @@ namespace Twitch::irc::message {
 				return !(lhs == rhs);
 			}
 
-			const std::regex ROOMSTATE::regex{
-				":tmi.twitch.tv ROOMSTATE (#.+)[\r\n|\r|\n]?"
-			};
 			std::optional<ROOMSTATE> ROOMSTATE::is(std::string_view raw_message) {
-				std::cmatch match;
-				if (!std::regex_match(raw_message.data(), match, regex)) { return std::nullopt; }
+				const auto message = TokenizedMessage::tokenize(raw_message);
+				if (!message) { return std::nullopt; }
 
-				constexpr const std::size_t channel = 1;
+				return is(*message);
+			}
+			bool ROOMSTATE::parse(const TokenizedMessage& message, Emplace<ROOMSTATE>& emplace) {
+				using namespace std::string_view_literals;
+				if (message.command != "ROOMSTATE"sv || !message.tags.empty()
+					|| message.prefix != "tmi.twitch.tv"sv) {
+					return false;
+				}
 
-				return ROOMSTATE{
-					match.str(channel)
-				};
+				const auto channel = message.param(0);
+				if (!is_channel(channel)) { return false; }
+
+				return emplace([&] {
+					return ROOMSTATE{
+						to_text(channel)
+					};
+				});
 			}
 			
 			bool operator==(const ROOMSTATE& lhs, const ROOMSTATE& rhs) {
@@ -1058,20 +1339,30 @@ namespace Twitch::irc::message {
 				return !(lhs == rhs);
 			}
 
-			const std::regex USERNOTICE::regex{
-				":tmi.twitch.tv USERNOTICE (#.+) :(.+)[\r\n|\r|\n]?"
-			};
 			std::optional<USERNOTICE> USERNOTICE::is(std::string_view raw_message) {
-				std::cmatch match;
-				if (!std::regex_match(raw_message.data(), match, regex)) { return std::nullopt; }
+				const auto message = TokenizedMessage::tokenize(raw_message);
+				if (!message) { return std::nullopt; }
 
-				constexpr const std::size_t channel = 1;
-				constexpr const std::size_t message = 2;
+				return is(*message);
+			}
+			bool USERNOTICE::parse(const TokenizedMessage& message, Emplace<USERNOTICE>& emplace) {
+				using namespace std::string_view_literals;
+				if (message.command != "USERNOTICE"sv || !message.tags.empty()
+					|| message.prefix != "tmi.twitch.tv"sv) {
+					return false;
+				}
 
-				return USERNOTICE{
-					match.str(channel),
-					match.str(message)
-				};
+				const auto channel = message.param(0);
+				if (!is_channel(channel) || !message.trailing || message.trailing->empty()) {
+					return false;
+				}
+
+				return emplace([&] {
+					return USERNOTICE{
+						to_text(channel),
+						to_text(*message.trailing)
+					};
+				});
 			}
 
 			bool operator==(const USERNOTICE& lhs, const USERNOTICE& rhs) {
@@ -1083,18 +1374,27 @@ namespace Twitch::irc::message {
 				return !(lhs == rhs);
 			}
 
-			const std::regex USERSTATE::regex{
-				":tmi.twitch.tv USERSTATE (#.+)[\r\n|\r|\n]?"
-			};
 			std::optional<USERSTATE> USERSTATE::is(std::string_view raw_message) {
-				std::cmatch match;
-				if (!std::regex_match(raw_message.data(), match, regex)) { return std::nullopt; }
+				const auto message = TokenizedMessage::tokenize(raw_message);
+				if (!message) { return std::nullopt; }
 
-				constexpr const std::size_t channel = 1;
+				return is(*message);
+			}
+			bool USERSTATE::parse(const TokenizedMessage& message, Emplace<USERSTATE>& emplace) {
+				using namespace std::string_view_literals;
+				if (message.command != "USERSTATE"sv || !message.tags.empty()
+					|| message.prefix != "tmi.twitch.tv"sv) {
+					return false;
+				}
 
-				return USERSTATE{
-					match.str(channel)
-				};
+				const auto channel = message.param(0);
+				if (!is_channel(channel)) { return false; }
+
+				return emplace([&] {
+					return USERSTATE{
+						to_text(channel)
+					};
+				});
 			}
 
 			bool operator==(const USERSTATE& lhs, const USERSTATE& rhs) {
@@ -1108,68 +1408,212 @@ namespace Twitch::irc::message {
 		} // namespace commands
 	} // namespace cap
 
+	namespace view {
+		std::optional<PING> PING::is(std::string_view raw_message) {
+			const auto message = TokenizedMessage::tokenize(raw_message);
+			if (!message) { return std::nullopt; }
+
+			return is(*message);
+		}
+		std::optional<PING> PING::is(const TokenizedMessage& message) {
+			using namespace std::string_view_literals;
+			if (message.command != "PING"sv || !message.tags.empty() || !message.prefix.empty()) {
+				return std::nullopt;
+			}
+			if (!message.trailing || message.trailing->empty()) { return std::nullopt; }
+
+			return PING{ *message.trailing };
+		}
+
+		message::PING PING::to_owned() const {
+			return message::PING{
+				to_text(host)
+			};
+		}
+
+		std::optional<JOIN> JOIN::is(std::string_view raw_message) {
+			const auto message = TokenizedMessage::tokenize(raw_message);
+			if (!message) { return std::nullopt; }
+
+			return is(*message);
+		}
+		std::optional<JOIN> JOIN::is(const TokenizedMessage& message) {
+			using namespace std::string_view_literals;
+			if (message.command != "JOIN"sv || !message.tags.empty()) { return std::nullopt; }
+
+			const auto user    = get_user(message.prefix);
+			const auto channel = message.param(0);
+			if (user.empty() || !is_channel(channel)) { return std::nullopt; }
+
+			return JOIN{ user, channel };
+		}
+
+		cap::membership::JOIN JOIN::to_owned() const {
+			return cap::membership::JOIN{
+				to_text(user),
+				to_text(channel)
+			};
+		}
+
+		std::optional<PART> PART::is(std::string_view raw_message) {
+			const auto message = TokenizedMessage::tokenize(raw_message);
+			if (!message) { return std::nullopt; }
+
+			return is(*message);
+		}
+		std::optional<PART> PART::is(const TokenizedMessage& message) {
+			using namespace std::string_view_literals;
+			if (message.command != "PART"sv || !message.tags.empty()) { return std::nullopt; }
+
+			const auto user    = get_user(message.prefix);
+			const auto channel = message.param(0);
+			if (user.empty() || !is_channel(channel)) { return std::nullopt; }
+
+			return PART{ user, channel };
+		}
+
+		cap::membership::PART PART::to_owned() const {
+			return cap::membership::PART{
+				to_text(user),
+				to_text(channel)
+			};
+		}
+
+		std::optional<PRIVMSG> PRIVMSG::is(std::string_view raw_message) {
+			const auto message = TokenizedMessage::tokenize(raw_message);
+			if (!message) { return std::nullopt; }
+
+			return is(*message);
+		}
+		std::optional<PRIVMSG> PRIVMSG::is(const TokenizedMessage& message) {
+			using namespace std::string_view_literals;
+			if (message.command != "PRIVMSG"sv || message.tags.empty()) { return std::nullopt; }
+
+			const auto channel = message.param(0);
+			if (!is_channel(channel) || !message.trailing || message.trailing->empty()) {
+				return std::nullopt;
+			}
+
+			const auto user = get_user(message.prefix);
+			const auto host = get_host(message.prefix);
+			if (user.empty() || host.empty()) { return std::nullopt; }
+
+			const auto tag = [&](std::string_view key) {
+				return message.tag(key).value_or(std::string_view{});
+			};
+
+			return PRIVMSG{
+				user,
+				host,
+				channel,
+				*message.trailing,
+				tag("badges"sv),
+				tag("bits"sv),
+				tag("color"sv),
+				tag("display-name"sv),
+				tag("emote-only"sv),
+				tag("emotes"sv),
+				tag("id"sv),
+				tag("mod"sv),
+				tag("room-id"sv),
+				tag("subscriber"sv),
+				tag("tmi-sent-ts"sv),
+				tag("turbo"sv),
+				tag("user-id"sv),
+				tag("user-type"sv)
+			};
+		}
+
+		cap::tags::PRIVMSG PRIVMSG::to_owned() const {
+			using cap::tags::UserType;
+			return cap::tags::PRIVMSG{
+				message::PRIVMSG{
+					to_text(user),
+					to_text(host),
+					to_text(channel),
+					to_text(message)
+				},
+				get_badges(badges),
+				get_bits(bits),
+				get_color(color),
+				to_text(display_name),
+				get_flag(emote_only),
+				to_text(emotes),
+				to_text(id),
+				get_flag(mod),
+				to_text(room_id),
+				get_flag(subscriber),
+				get_ts(tmi_sent_ts),
+				get_flag(turbo),
+				to_text(user_id),
+				UserType::from_string(user_type)
+			};
+		}
+	} // namespace view
+
 	void ParserVisitor::operator()(const ParseError& e) const {
-		BOOST_LOG_SEV(m_lg, severity::error) << "Parse error: " << e.what();
+		TWITCH_IRC_LOG(m_lg, error, "Parse error: ", e.what());
 	}
 	void ParserVisitor::operator()(const PING& ping) const {
 		using namespace std::string_literals;
-		m_controller->enqueue("PONG :"s + ping.host, true);
+		m_controller->enqueue("PONG :"s + std::string{ ping.host }, true);
 
-		BOOST_LOG_SEV(m_lg, severity::trace) << "PING :" << ping.host;
+		TWITCH_IRC_LOG(m_lg, trace, "PING :", ping.host);
 	}
 	void ParserVisitor::operator()(const cap::tags::PRIVMSG& privmsg) const {
-		BOOST_LOG_SEV(m_lg, severity::trace) << privmsg;
+		TWITCH_IRC_LOG(m_lg, trace, privmsg.channel, " <", privmsg.display_name, "> ", privmsg.message);
 		// TODO: add commands
-		if (privmsg.message.size() < m_commands->min_cmd_word_size()) { return; }
+		if (privmsg.message.size() < Commands::min_cmd_word_size()) { return; }
 
 		using namespace std::string_literals;
-		const auto str = privmsg.message.substr(0, privmsg.message.find(' '));
-		if (const auto command{ m_commands->find(str) }; command) {
-			// TODO: find better solution. condition_variable::wait_for()?
-			std::thread async_add(
-				[](auto message, auto command, std::weak_ptr<Twitch::irc::IRCWriter> writer) {
+		const auto& commands = m_channels->commands(privmsg.channel);
+		const auto str = std::string_view{ privmsg.message }.substr(0, privmsg.message.find(' '));
+		Commands::Pin pin; // nested in the batch's one when run by TwitchBot
+		if (const auto* command{ commands->find(str) }; command) {
+			// copied on a hit only, the table may be retired before the task runs
+			const bool accepted = m_executor->submit(
+				[message = privmsg, command = *command, writer = std::weak_ptr<Twitch::irc::IRCWriter>{ m_controller }]() {
 					auto response = command(message);
-					if (!writer.expired()) {
+					if (auto locked = writer.lock(); locked) {
 						using namespace std::string_literals;
-						writer.lock()->enqueue(
-							"PRIVMSG "s + message.channel
+						locked->enqueue(
+							"PRIVMSG "s + std::string{ message.channel }
 							+ " :"s + std::move(response)
 						);
 					}
-				},
-				privmsg,
-				command,
-				m_controller
+				}
 			);
-			async_add.detach();
+			if (!accepted) {
+				TWITCH_IRC_LOG(m_lg, warning, "Command dropped, executor is full: ", str);
+			}
 		}
 	}
 
 	void ParserVisitor::operator()(const cap::membership::JOIN& msg) const {
-		BOOST_LOG_SEV(m_lg, severity::trace) << "Joins: " << msg.user;
+		TWITCH_IRC_LOG(m_lg, trace, "Joins: ", msg.user);
 	}
 	void ParserVisitor::operator()(const cap::membership::PART& msg) const {
-		BOOST_LOG_SEV(m_lg, severity::trace) << "Parts: " << msg.user;
+		TWITCH_IRC_LOG(m_lg, trace, "Parts: ", msg.user);
 	}
 	void ParserVisitor::operator()(const cap::tags::CLEARCHAT& msg) const {
 		if (msg.is_perm()) {
-			BOOST_LOG_SEV(m_lg, severity::trace)
-				<< msg.user
-				<< " has been permanently banned from this channel";
+			TWITCH_IRC_LOG(m_lg, trace, msg.user, " has been permanently banned from this channel");
 		}
 		else if (msg.is_clear()) {
-			BOOST_LOG_SEV(m_lg, severity::trace)
-				<< "Chat has been cleared";
+			TWITCH_IRC_LOG(m_lg, trace, "Chat has been cleared");
 		}
 		else {
-			BOOST_LOG_SEV(m_lg, severity::trace)
-				<< msg.user
-				<< " has been banned for "
-				<< msg.ban_duration.value().count()
-				<< "s from this channel";
+			TWITCH_IRC_LOG(m_lg, trace,
+				msg.user,
+				" has been banned for ",
+				msg.ban_duration.value().count(),
+				"s from this channel"
+			);
 		}
 	}
 	void ParserVisitor::operator()(const cap::tags::USERNOTICE& msg) const {
+		if constexpr (!Logger::enabled(severity::trace)) { return; } // nothing to do but trace
+
 		const std::string response{ [&] {
 			using namespace std::string_literals;
 			using Sub = cap::tags::USERNOTICE::Sub;
@@ -1177,16 +1621,16 @@ namespace Twitch::irc::message {
 			using Raid = cap::tags::USERNOTICE::Raid;
 
 			if (auto* sub_details = boost::get<Sub>(&msg.msg_id); sub_details) {
-				return msg.display_name + " has subscribed to this channel"s;
+				return std::string{ msg.display_name } + " has subscribed to this channel"s;
 			}
 			if (auto* gift_details = boost::get<Subgift>(&msg.msg_id); gift_details) {
-				return gift_details->recipient_display_name
+				return std::string{ gift_details->recipient_display_name }
 					+ " gifted "s + translate_sub_plan(gift_details->sub_plan)
 					+ " subscription to "s
-					+ gift_details->recipient_name;
+					+ std::string{ gift_details->recipient_name };
 			}
 			if (auto* raid_details = boost::get<Raid>(&msg.msg_id); raid_details) {
-				return raid_details->display_name
+				return std::string{ raid_details->display_name }
 					+ " is raiding with a party of "s
 					+ std::to_string(raid_details->viewer_count);
 			}
@@ -1194,175 +1638,289 @@ namespace Twitch::irc::message {
 		}() };
 
 		if (!response.empty()) {
-			BOOST_LOG_SEV(m_lg, severity::trace) << response;
+			TWITCH_IRC_LOG(m_lg, trace, response);
 		}
 	}
 	void ParserVisitor::operator()(const cap::commands::NOTICE& notice) const {
-		BOOST_LOG_SEV(m_lg, severity::trace) << "NOTICE: " << notice.message;
+		TWITCH_IRC_LOG(m_lg, trace, "NOTICE: ", notice.message);
 	}
 	void ParserVisitor::operator()(const cap::tags::USERSTATE& state) const {
-		BOOST_LOG_SEV(m_lg, severity::trace) << state;
+		// sent for the bot's own account, twitch allows mods to chat faster
+		const bool moderator = state.mod || state.badges.contains(Badge::broadcaster);
+		m_channels->add(state.channel).moderator = moderator;
+		m_controller->set_moderator(state.channel, moderator);
+		TWITCH_IRC_LOG(m_lg, trace, "USERSTATE ", state.channel, ' ', state.display_name, moderator ? " (moderator)" : "");
 	}
 	void ParserVisitor::operator()(const cap::membership::MODE& msg) const {
-		BOOST_LOG_SEV(m_lg, severity::trace)
-			<< msg.user
-			<< (msg.gained ? " is now" : " is no longer")
-			<< " a moderator";
+		TWITCH_IRC_LOG(m_lg, trace, msg.user, msg.gained ? " is now" : " is no longer", " a moderator");
 	}
 	void ParserVisitor::operator()(const cap::commands::HOSTTARGET& host) const {
 		if (host.starts()) {
-			BOOST_LOG_SEV(m_lg, severity::trace)
-				<< "This channel is now hosting "
-				<< host.target_channel;
+			TWITCH_IRC_LOG(m_lg, trace, "This channel is now hosting ", host.target_channel);
 		}
 		else {
-			BOOST_LOG_SEV(m_lg, severity::trace)
-				<< "This channel is no longer hosting";
+			TWITCH_IRC_LOG(m_lg, trace, "This channel is no longer hosting");
 		}
 	}
 	void ParserVisitor::operator()(const cap::tags::GLOBALUSERSTATE& state) const {
-		BOOST_LOG_SEV(m_lg, severity::trace) << state;
+		TWITCH_IRC_LOG(m_lg, trace, "GLOBALUSERSTATE ", state.display_name, " user-id=", state.user_id);
 	}
 	void ParserVisitor::operator()(const cap::tags::ROOMSTATE& roomstate) const {
+		auto& room = m_channels->add(roomstate.channel).room;
+		if (roomstate.broadcaster_lang) { room.broadcaster_lang = roomstate.broadcaster_lang; }
+		if (roomstate.emote_only)       { room.emote_only       = roomstate.emote_only;       }
+		if (roomstate.followers_only)   { room.followers_only   = roomstate.followers_only;   }
+		if (roomstate.r9k)              { room.r9k              = roomstate.r9k;              }
+		if (roomstate.slow)             { room.slow             = roomstate.slow;             }
+		if (roomstate.subs_only)        { room.subs_only        = roomstate.subs_only;        }
+		if (!roomstate.room_id.empty()) { room.room_id          = roomstate.room_id;          }
+
 		if (roomstate.is_update()) {
 			if (roomstate.emote_only) {
-				BOOST_LOG_SEV(m_lg, severity::trace)
-					<< (roomstate.emote_only.value()
-						? "Channel is no longer in emote only mode"
-						: "Channel is now in emote only mode");
+				TWITCH_IRC_LOG(m_lg, trace, roomstate.emote_only.value()
+					? "Channel is no longer in emote only mode"
+					: "Channel is now in emote only mode");
 			}
 			else if (roomstate.followers_only) {
 				if (roomstate.followers_only.value() == -1) {
-					BOOST_LOG_SEV(m_lg, severity::trace)
-						<< "Channel is no longer in followers only mode";
+					TWITCH_IRC_LOG(m_lg, trace, "Channel is no longer in followers only mode");
 				}
 				else {
-					BOOST_LOG_SEV(m_lg, severity::trace)
-						<< "Channel is now in "
-						<< roomstate.followers_only.value()
-						<< "s followers only mode";
+					TWITCH_IRC_LOG(m_lg, trace,
+						"Channel is now in ",
+						roomstate.followers_only.value(),
+						"s followers only mode"
+					);
 				}
 			}
 			else if (roomstate.r9k) {
-				BOOST_LOG_SEV(m_lg, severity::trace)
-					<< (roomstate.r9k.value()
-						? "Channel is no longer in r9k mode"
-						: "Channel is now in r9k mode");
+				TWITCH_IRC_LOG(m_lg, trace, roomstate.r9k.value()
+					? "Channel is no longer in r9k mode"
+					: "Channel is now in r9k mode");
 			}
 			else if (roomstate.rituals) {
-				BOOST_LOG_SEV(m_lg, severity::trace)
-					<< roomstate.rituals.value();
+				TWITCH_IRC_LOG(m_lg, trace, roomstate.rituals.value());
 			}
 			else if (roomstate.slow) {
 				using namespace std::chrono_literals;
 				if (roomstate.slow.value() == 0s) {
-					BOOST_LOG_SEV(m_lg, severity::trace)
-						<< "Channel is no longer in slow mode";
+					TWITCH_IRC_LOG(m_lg, trace, "Channel is no longer in slow mode");
 				}
 				else {
-					BOOST_LOG_SEV(m_lg, severity::trace)
-						<< "Channel is now in "
-						<< roomstate.slow.value().count()
-						<< "s slow mode";
+					TWITCH_IRC_LOG(m_lg, trace,
+						"Channel is now in ",
+						roomstate.slow.value().count(),
+						"s slow mode"
+					);
 				}
 			}
 			else if (roomstate.subs_only) {
-				BOOST_LOG_SEV(m_lg, severity::trace)
-					<< (roomstate.subs_only.value()
-						? "Channel is no longer in sub only mode"
-						: "Channel is now in sub only mode");
+				TWITCH_IRC_LOG(m_lg, trace, roomstate.subs_only.value()
+					? "Channel is no longer in sub only mode"
+					: "Channel is now in sub only mode");
 			}
 		}
 		else {
-			BOOST_LOG_SEV(m_lg, severity::trace) << roomstate;
+			using namespace std::chrono_literals;
+			TWITCH_IRC_LOG(m_lg, trace,
+				"ROOMSTATE ", roomstate.channel,
+				" room-id=", roomstate.room_id,
+				" emote-only=", roomstate.emote_only.value_or(false),
+				" followers-only=", roomstate.followers_only.value_or(-1),
+				" r9k=", roomstate.r9k.value_or(false),
+				" slow=", roomstate.slow.value_or(0s).count(),
+				" subs-only=", roomstate.subs_only.value_or(false)
+			);
 		}
 	}
 	void ParserVisitor::operator()(const cap::membership::NAMES& list) const {
 		if (list.is_end_of_list()) {
-			BOOST_LOG_SEV(m_lg, severity::trace)
-				<< "End of /NAMES list";
+			TWITCH_IRC_LOG(m_lg, trace, "End of /NAMES list");
 		}
 		else {
-			BOOST_LOG_SEV(m_lg, severity::trace)
-				<< list.channel << " viewers: " << list.names;
+			TWITCH_IRC_LOG(m_lg, trace, list.channel, " viewers: ", list.names);
+		}
+	}
+	Subscription ParserVisitor::subscription() noexcept {
+		// every other handler only traces, keep feeding them while trace is compiled in
+		if constexpr (Logger::enabled(severity::trace)) {
+			return Subscription::all();
 		}
+
+		// JOIN/PART/NAMES and friends are only traced, in big channels they are most of the traffic
+		return Subscription::of<
+			PING,
+			cap::commands::RECONNECT,
+			cap::tags::PRIVMSG,
+			cap::tags::ROOMSTATE,
+			cap::tags::USERSTATE
+		>();
 	}
+
 	void ParserVisitor::operator()([[maybe_unused]] const cap::commands::RECONNECT&) const {
-		BOOST_LOG_SEV(m_lg, severity::trace) << "Reconnecting...";
+		TWITCH_IRC_LOG(m_lg, info, "Reconnecting...");
 
-		while (const error_code_t error = m_controller->reconnect()) {
-			BOOST_LOG_SEV(m_lg, severity::trace) << error.message();
+		// async controllers retry on their loop and report the outcome there
+		if (const error_code_t error = m_controller->reconnect(); error) {
+			TWITCH_IRC_LOG(m_lg, error, "Reconnect failed: ", error.message());
 		}
 	}
 
 	ParserVisitor::ParserVisitor(
 		std::shared_ptr<Twitch::irc::IController>  t_controller,
-		std::shared_ptr<Twitch::irc::Commands> t_commands,
+		std::shared_ptr<Twitch::irc::Channels> t_channels,
+		std::shared_ptr<Twitch::irc::CommandExecutor> t_executor,
 		Twitch::irc::logger_t& t_logger
 	) :
 		m_controller(t_controller),
-		m_commands(t_commands),
+		m_channels(t_channels),
+		m_executor(t_executor),
 		m_lg(t_logger)
 	{}
 
-	MessageParser::result_t MessageParser::process(std::string_view recived_message) {
-		try
+	namespace { // dispatch table, built from parsed_types_t at compile time
+		using result_t = MessageParser::result_t;
+		using parse_fn_t = result_t (*)(const TokenizedMessage&, std::string_view);
+
+		struct Route
 		{
-			namespace commands   = Twitch::irc::message::cap::commands;
-			namespace membership = Twitch::irc::message::cap::membership;
-			namespace tags       = Twitch::irc::message::cap::tags;
-			// TODO: simplify, iterate through types
-			// sorted by priority
-			if (auto parsed = PING::is(recived_message); parsed) {
-				return *parsed;
-			}
-			if (auto parsed = tags::PRIVMSG::is(recived_message); parsed) {
-				return *parsed;
-			}
-			if (auto parsed = membership::JOIN::is(recived_message); parsed) {
-				return *parsed;
-			}
-			if (auto parsed = membership::PART::is(recived_message); parsed) {
-				return *parsed;
-			}
-			if (auto parsed = tags::CLEARCHAT::is(recived_message); parsed) {
-				return *parsed;
-			}
-			if (auto parsed = tags::USERNOTICE::is(recived_message); parsed) {
-				return *parsed;
-			}
-			if (auto parsed = commands::NOTICE::is(recived_message); parsed) {
-				return *parsed;
-			}
-			if (auto parsed = tags::USERSTATE::is(recived_message); parsed) {
-				return *parsed;
-			}
+			std::string_view keyword;
+			int which{ 0 }; // result_t alternative
+			parse_fn_t parse{ nullptr };
+		};
 
-			// only once or very rarely
-			if (auto parsed = membership::MODE::is(recived_message); parsed) {
-				return *parsed;
-			}
-			if (auto parsed = commands::HOSTTARGET::is(recived_message); parsed) {
-				return *parsed;
+		result_t not_handled(std::string_view raw) {
+			using namespace std::string_literals;
+			return ParseError{ "Message type not handled: "s + std::string{ raw }, ParseError::Reason::not_handled };
+		}
+
+		// built straight into its pool block, no optional and no copy on the way
+		template<class Message_t>
+		result_t parse_as(const TokenizedMessage& message, std::string_view raw) {
+			auto parsed = Pooled<Message_t>::make([&](Emplace<Message_t>& into) {
+				return Message_t::parse(message, into);
+			});
+			if (!parsed) { return not_handled(raw); }
+
+			return result_t{ std::in_place_type<Pooled<Message_t>>, std::move(parsed) };
+		}
+
+		template<class... Ts>
+		constexpr auto make_routes(TypeList<Ts...>) {
+			std::array<Route, (std::tuple_size_v<decltype(Ts::keywords)> + ...)> routes{};
+			std::size_t i{ 0 };
+			int which{ 1 }; // 0 is ParseError
+			const auto add = [&](const auto& keywords, parse_fn_t parse) {
+				for (const auto keyword : keywords) { routes[i++] = Route{ keyword, which, parse }; }
+				++which;
+			};
+			(add(Ts::keywords, &parse_as<Ts>), ...);
+			return routes;
+		}
+
+		constexpr auto routes = make_routes(parsed_types_t{});
+
+		constexpr bool unique_keywords() {
+			for (std::size_t i{ 0 }; i < routes.size(); ++i) {
+				for (std::size_t j{ i + 1 }; j < routes.size(); ++j) {
+					if (routes[i].keyword == routes[j].keyword) { return false; }
+				}
 			}
-			if (auto parsed = tags::GLOBALUSERSTATE::is(recived_message); parsed) {
-				return *parsed;
+			return true;
+		}
+		static_assert(unique_keywords(), "two message types claim the same command keyword");
+
+		constexpr std::size_t table_size = [] {
+			std::size_t size{ 1 };
+			while (size < routes.size() * 2) { size <<= 1; }
+			return size;
+		}();
+		constexpr std::uint64_t table_mask = table_size - 1;
+
+		constexpr std::uint64_t table_seed = [] {
+			for (std::uint64_t seed{ 0 }; ; ++seed) {
+				std::array<bool, table_size> used{};
+				bool collision{ false };
+				for (const auto& route : routes) {
+					auto& slot = used[seeded_hash(route.keyword, seed) & table_mask];
+					collision = collision || slot;
+					slot = true;
+				}
+				if (!collision) { return seed; }
 			}
-			if (auto parsed = tags::ROOMSTATE::is(recived_message); parsed) {
-				return *parsed;
+		}();
+
+		constexpr auto table = [] {
+			std::array<Route, table_size> slots{};
+			for (const auto& route : routes) {
+				slots[seeded_hash(route.keyword, table_seed) & table_mask] = route;
 			}
-			if (auto parsed = membership::NAMES::is(recived_message); parsed) {
-				return *parsed;
+			return slots;
+		}();
+
+		// one hash, one compare
+		inline const Route* find_route(std::string_view command) noexcept {
+			const auto& route = table[seeded_hash(command, table_seed) & table_mask];
+			return route.parse && route.keyword == command ? &route : nullptr;
+		}
+	}
+
+	std::optional<int> MessageParser::route(std::string_view command) noexcept {
+		if (const auto* found = find_route(command); found) { return found->which; }
+		return std::nullopt;
+	}
+
+	namespace {
+		// ParseError, then every parsed type, then Skipped, as laid out in result_t
+		template<class... Ts>
+		std::vector<std::string_view> kind_names(TypeList<Ts...>) {
+			return { "ParseError", Ts::name..., "Skipped" };
+		}
+	}
+
+	MessageParser::MessageParser(Subscription t_subscription) :
+		m_metrics(
+			kind_names(parsed_types_t{}),
+			std::vector<std::string_view>(std::begin(ParseError::reasons), std::end(ParseError::reasons))
+		),
+		m_subscription(t_subscription)
+	{
+		static_assert(std::variant_size_v<result_t> == parsed_types_t::size + 2);
+	}
+
+	MessageParser::result_t MessageParser::process(std::string_view recived_message) {
+		const auto start = metrics::clock_t::now();
+		auto result = parse(recived_message);
+		m_metrics.parsed(result.index(), metrics::clock_t::now() - start);
+		if (const auto* error = std::get_if<ParseError>(&result); error) {
+			m_metrics.error(static_cast<std::size_t>(error->reason));
+		}
+		return result;
+	}
+
+	MessageParser::result_t MessageParser::parse(std::string_view recived_message) {
+		try
+		{
+			using namespace std::string_literals;
+
+			if (!m_subscription.is_all()) {
+				const auto* found = find_route(TokenizedMessage::command_of(recived_message));
+				if (found && !m_subscription.contains(found->which)) {
+					++m_skipped[found->which];
+					++m_skipped_total;
+					return Skipped{ found->which };
+				}
 			}
-			if (auto parsed = commands::RECONNECT::is(recived_message); parsed) {
-				return *parsed;
+
+			const auto message = TokenizedMessage::tokenize(recived_message);
+			if (!message) {
+				return ParseError{ "Malformed message: "s + std::string{ recived_message }, ParseError::Reason::malformed };
 			}
 
-			using namespace std::string_literals;
-			return ParseError{ "Message type not handled: "s + recived_message.data() };
-		}
-		catch (const std::regex_error& e) {
-			return ParseError{ e.what() };
+			if (const auto* found = find_route(message->command); found) {
+				return found->parse(*message, recived_message);
+			}
+			return not_handled(recived_message);
 		}
 		catch (const std::exception& e) {
 			return ParseError{ e.what() };
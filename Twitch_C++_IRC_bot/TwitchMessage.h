@@ -2,20 +2,28 @@
 #define TWITCHMESSAGE_H
 #include "Logger.h"
 #include "IRC_Bot.h"
+#include "Metrics.h"
 #include "TwitchMessageParams.h"
 #include <boost\variant.hpp>
 #include <boost\algorithm\string\predicate.hpp>
+#include <boost\algorithm\string\replace.hpp>
+#include <array>
 #include <chrono>
+#include <cstdint>
 #include <memory>
+#include <memory_resource>
+#include <new>
 #include <optional>
-#include <regex>
 #include <string>
 #include <string_view>
+#include <type_traits>
+#include <utility>
+#include <variant>
 #include <vector>
 // Boost.Log print names // TODO: improve type-safety
 namespace boost::log {
 	template<class Logger>
-	Logger& operator<<(Logger& logger, const std::vector<std::string>& names) {
+	Logger& operator<<(Logger& logger, const std::pmr::vector<std::pmr::string>& names) {
 		if (!names.empty()) {
 			const auto first = std::begin(names);
 			logger << *first;
@@ -38,6 +46,8 @@ namespace helpers {
 namespace Twitch {
 	namespace irc {
 		struct Commands;
+		class Channels;
+		class CommandExecutor;
 		struct IRCWriter;
 		struct IController;
 		class Controller;
@@ -45,12 +55,268 @@ namespace Twitch {
 } // namespace Twitch
 
 namespace Twitch::irc::message {
+	/// structural bytes of a raw line: ' ', ';', '=', ':', '\r' and '\n'
+	/// a 64 byte block is classified into one bit mask at a time (AVX2, SSE2 or a table)
+	/// and positions are handed out in order, simdjson stage 1 style
+	/// build with TWITCH_IRC_SCAN_SCALAR to force the table everywhere
+	class StructuralScanner
+	{
+	public:
+		static constexpr std::size_t npos = std::string_view::npos;
+		static constexpr std::size_t block_size = 64;
+
+		explicit constexpr StructuralScanner(std::string_view t_raw) noexcept : m_raw(t_raw) {}
+
+		// position of the next structural byte, npos once the line is exhausted
+		inline std::size_t next() noexcept {
+			while (m_mask == 0) {
+				if (m_next_block >= m_raw.size()) { return npos; }
+				m_base = m_next_block;
+				m_mask = block_mask(m_raw, m_base);
+				m_next_block += block_size;
+			}
+			const auto bit = lowest_bit(m_mask);
+			m_mask &= m_mask - 1;
+			return m_base + bit;
+		}
+
+		// bit i is set when raw[offset + i] is structural, bytes past the end never are
+		static std::uint64_t block_mask(std::string_view raw, std::size_t offset) noexcept;
+		// byte at a time reference, block_mask has to agree with it
+		static std::uint64_t block_mask_scalar(std::string_view raw, std::size_t offset) noexcept;
+		// "avx2", "sse2" or "scalar", whatever block_mask was compiled to
+		static std::string_view implementation() noexcept;
+
+		// index of the lowest set bit, mask must not be 0 (de Bruijn, no intrinsics)
+		static constexpr unsigned lowest_bit(std::uint64_t mask) noexcept {
+			constexpr std::uint64_t debruijn = 0x03f79d71b4cb0a89;
+			constexpr std::array<unsigned char, 64> index{
+				 0,  1, 48,  2, 57, 49, 28,  3, 61, 58, 50, 42, 38, 29, 17,  4,
+				62, 55, 59, 36, 53, 51, 43, 22, 45, 39, 33, 30, 24, 18, 12,  5,
+				63, 47, 56, 27, 60, 41, 37, 16, 54, 35, 52, 21, 44, 32, 23, 11,
+				46, 26, 40, 15, 34, 20, 31, 10, 25, 14, 19,  9, 13,  8,  7,  6
+			};
+			return index[((mask & (~mask + 1)) * debruijn) >> 58];
+		}
+
+	private:
+		std::string_view m_raw;
+		std::size_t m_next_block{ 0 };
+		std::size_t m_base{ 0 };
+		std::uint64_t m_mask{ 0 };
+	};
+
+	/// flat key/value views over raw "k1=v1;k2=v2" tags, split on first lookup
+	/// or right away by the tokenizer, which walks over every tag anyway
+	/// order doesn't matter, tags nobody asks for are never decoded
+	/// lazily built, so a const instance still can't be shared between threads
+	class TagIndex
+	{
+	public:
+		static constexpr std::size_t inline_capacity = 32; // twitch sends ~20 on PRIVMSG
+
+		constexpr TagIndex() noexcept = default;
+		explicit constexpr TagIndex(std::string_view t_raw) noexcept : m_raw(t_raw) {}
+
+		std::optional<std::string_view> find(std::string_view key) const noexcept;
+		std::size_t size() const noexcept;
+		inline std::string_view raw() const noexcept { return m_raw; }
+
+	private:
+		struct Tag
+		{
+			std::string_view key;
+			std::string_view value;
+		};
+
+		void build() const noexcept;
+		// splits the tags starting at text[first] on the scanner's positions,
+		// stops on the first space and returns where that is (text.size() without one)
+		std::size_t split(std::string_view text, std::size_t first, StructuralScanner& scanner) const noexcept;
+
+		friend struct TokenizedMessage; // splits tags in the same pass as the line
+
+		std::string_view m_raw;
+		mutable std::array<Tag, inline_capacity> m_tags{};
+		mutable std::size_t m_count{ 0 };
+		mutable std::string_view m_overflow; // whatever didn't fit, scanned on a miss
+		mutable bool m_built{ false };
+	};
+
+	/// single pass IRCv3 tokenizer over StructuralScanner, all fields are views into the raw line
+	/// [@tags ][:prefix ]command[ params][ :trailing][\r\n]
+	struct TokenizedMessage
+	{
+		static constexpr std::size_t max_params = 15; // RFC 1459
+
+		static std::optional<TokenizedMessage> tokenize(std::string_view raw_message) noexcept;
+		// just the command token, skips tags and prefix without splitting them
+		static std::string_view command_of(std::string_view raw_message) noexcept;
+
+		// looks up "key=value" in raw "k1=v1;k2=v2" block
+		static std::optional<std::string_view> find_tag(
+			std::string_view raw_tags, std::string_view key
+		) noexcept;
+
+		inline std::optional<std::string_view> tag(std::string_view key) const noexcept {
+			return tag_index.find(key);
+		}
+
+		inline std::string_view param(std::size_t i) const noexcept {
+			return i < params_count ? params[i] : std::string_view{};
+		}
+
+		std::string_view tags;    // without leading '@'
+		TagIndex tag_index;       // over tags
+		std::string_view prefix;  // without leading ':'
+		std::string_view command;
+		std::array<std::string_view, max_params> params{};
+		std::size_t params_count{ 0 };
+		std::optional<std::string_view> trailing; // without leading ':'
+	};
+
+	/// owned message text, taken from the thread's BatchArena while a batch is parsed
+	using string_t = std::pmr::string;
+	using names_t = std::pmr::vector<string_t>;
+
+	/// raw storage a parser builds its result into
+	/// build() returns the message as a prvalue, so it initializes the storage directly
+	/// (guaranteed elision): messages with const members are never copied on the way out
+	template<class T>
+	class Emplace
+	{
+	public:
+		explicit Emplace(void* t_storage) noexcept : m_storage(t_storage) {}
+
+		template<class Build>
+		bool operator()(Build&& build) {
+			::new (m_storage) T(std::forward<Build>(build)());
+			m_built = true;
+			return true;
+		}
+
+		inline bool built() const noexcept { return m_built; }
+
+	private:
+		void* m_storage;
+		bool m_built{ false };
+	};
+
+	/// recycled blocks for parsed messages, one free list per type and thread
+	/// a block freed on another thread just joins that thread's list
+	template<class T>
+	class MessagePool
+	{
+	public:
+		static constexpr std::size_t max_free = 64;
+
+		static void* allocate() {
+			auto& blocks = free_list().blocks;
+			if (blocks.empty()) { return ::operator new(sizeof(T)); }
+
+			void* block = blocks.back();
+			blocks.pop_back();
+			return block;
+		}
+
+		static void deallocate(void* block) noexcept {
+			auto& blocks = free_list().blocks;
+			if (blocks.size() < max_free) { blocks.push_back(block); } // reserved, never throws
+			else { ::operator delete(block); }
+		}
+
+	private:
+		struct FreeList
+		{
+			std::vector<void*> blocks;
+
+			FreeList() { blocks.reserve(max_free); }
+			~FreeList() {
+				for (void* block : blocks) { ::operator delete(block); }
+			}
+		};
+
+		static FreeList& free_list() {
+			thread_local FreeList list;
+			return list;
+		}
+	};
+
+	/// owning handle to a message built in MessagePool storage, move only
+	template<class T>
+	class Pooled
+	{
+	public:
+		// parse gets an Emplace<T> over a pooled block, empty handle if it declines
+		template<class Parse>
+		static Pooled make(Parse&& parse) {
+			void* block = MessagePool<T>::allocate();
+			Emplace<T> into{ block };
+			try {
+				std::forward<Parse>(parse)(into);
+			}
+			catch (...) {
+				if (into.built()) { std::launder(static_cast<T*>(block))->~T(); }
+				MessagePool<T>::deallocate(block);
+				throw;
+			}
+
+			if (!into.built()) {
+				MessagePool<T>::deallocate(block);
+				return Pooled{};
+			}
+			return Pooled{ std::launder(static_cast<T*>(block)) };
+		}
+
+		Pooled() noexcept = default;
+		Pooled(Pooled&& other) noexcept : m_value(std::exchange(other.m_value, nullptr)) {}
+		Pooled& operator=(Pooled&& other) noexcept {
+			if (this != &other) {
+				reset();
+				m_value = std::exchange(other.m_value, nullptr);
+			}
+			return *this;
+		}
+		Pooled(const Pooled&) = delete;
+		Pooled& operator=(const Pooled&) = delete;
+		~Pooled() { reset(); }
+
+		inline explicit operator bool() const noexcept { return m_value != nullptr; }
+		inline const T* get() const noexcept { return m_value; }
+		inline const T& operator*() const noexcept { return *m_value; }
+		inline const T* operator->() const noexcept { return m_value; }
+
+	private:
+		explicit Pooled(T* t_value) noexcept : m_value(t_value) {}
+
+		void reset() noexcept {
+			if (!m_value) { return; }
+			m_value->~T();
+			MessagePool<T>::deallocate(m_value);
+			m_value = nullptr;
+		}
+
+		T* m_value{ nullptr };
+	};
+
+	// is() for callers that want a plain value, costs the one copy out of the pool
+	template<class T>
+	std::optional<T> parse_optional(const TokenizedMessage& message) {
+		const auto parsed = Pooled<T>::make([&](Emplace<T>& into) { return T::parse(message, into); });
+		if (!parsed) { return std::nullopt; }
+
+		return *parsed;
+	}
+
 	struct PING
 	{
-		static const std::regex regex;
 		static std::optional<PING> is(std::string_view raw_message);
+		static std::optional<PING> is(const TokenizedMessage& message) { return parse_optional<PING>(message); }
+		static bool parse(const TokenizedMessage& message, Emplace<PING>& emplace);
+		static constexpr std::array<std::string_view, 1> keywords{ "PING" }; // command tokens MessageParser dispatches on
+		static constexpr std::string_view name{ "PING" }; // label the type is reported under in metrics
 
-		std::string host;
+		string_t host;
 
 		friend bool operator==(const PING& lhs, const PING& rhs);
 		friend bool operator!=(const PING& lhs, const PING& rhs);
@@ -60,13 +326,16 @@ namespace Twitch::irc::message {
 	};
 	struct PRIVMSG
 	{
-		static const std::regex regex;
 		static std::optional<PRIVMSG> is(std::string_view raw_message);
+		static std::optional<PRIVMSG> is(const TokenizedMessage& message) { return parse_optional<PRIVMSG>(message); }
+		static bool parse(const TokenizedMessage& message, Emplace<PRIVMSG>& emplace);
+		static constexpr std::array<std::string_view, 1> keywords{ "PRIVMSG" };
+		static constexpr std::string_view name{ "PRIVMSG" };
 
-		const std::string user;
-		const std::string host;
-		const std::string channel;
-		const std::string message;
+		const string_t user;
+		const string_t host;
+		const string_t channel;
+		const string_t message;
 
 		friend bool operator==(const PRIVMSG& lhs, const PRIVMSG& rhs);
 		friend bool operator!=(const PRIVMSG& lhs, const PRIVMSG& rhs);
@@ -96,11 +365,14 @@ namespace Twitch::irc::message {
 			/// raw, extended by cap tags
 			struct CLEARCHAT
 			{
-				static const std::regex regex;
 				static std::optional<CLEARCHAT> is(std::string_view raw_message);
+				static std::optional<CLEARCHAT> is(const TokenizedMessage& message) { return parse_optional<CLEARCHAT>(message); }
+				static bool parse(const TokenizedMessage& message, Emplace<CLEARCHAT>& emplace);
+				static constexpr std::array<std::string_view, 1> keywords{ "CLEARCHAT" };
+				static constexpr std::string_view name{ "CLEARCHAT" };
 				
-				const std::string channel;
-				const std::string user;
+				const string_t channel;
+				const string_t user;
 
 				friend bool operator==(const CLEARCHAT& lhs, const CLEARCHAT& rhs);
 				friend bool operator!=(const CLEARCHAT& lhs, const CLEARCHAT& rhs);
@@ -110,15 +382,18 @@ namespace Twitch::irc::message {
 			};
 			struct HOSTTARGET
 			{
-				static const std::regex regex;
 				static std::optional<HOSTTARGET> is(std::string_view raw_message);
+				static std::optional<HOSTTARGET> is(const TokenizedMessage& message) { return parse_optional<HOSTTARGET>(message); }
+				static bool parse(const TokenizedMessage& message, Emplace<HOSTTARGET>& emplace);
+				static constexpr std::array<std::string_view, 1> keywords{ "HOSTTARGET" };
+				static constexpr std::string_view name{ "HOSTTARGET" };
 
 				inline bool starts() const noexcept {
 					return !target_channel.empty();
 				}
 
-				const std::string hosting_channel;
-				const std::string target_channel;
+				const string_t hosting_channel;
+				const string_t target_channel;
 				const std::optional<int> viewers_count;
 
 				friend bool operator==(const HOSTTARGET& lhs, const HOSTTARGET& rhs);
@@ -129,12 +404,15 @@ namespace Twitch::irc::message {
 			};
 			struct NOTICE
 			{
-				static const std::regex regex;
 				static std::optional<NOTICE> is(std::string_view raw_message);
+				static std::optional<NOTICE> is(const TokenizedMessage& message) { return parse_optional<NOTICE>(message); }
+				static bool parse(const TokenizedMessage& message, Emplace<NOTICE>& emplace);
+				static constexpr std::array<std::string_view, 1> keywords{ "NOTICE" };
+				static constexpr std::string_view name{ "NOTICE" };
 
-				const std::string msg_id;
-				const std::string channel;
-				const std::string message;
+				const string_t msg_id;
+				const string_t channel;
+				const string_t message;
 
 				friend bool operator==(const NOTICE& lhs, const NOTICE& rhs);
 				friend bool operator!=(const NOTICE& lhs, const NOTICE& rhs);
@@ -144,8 +422,11 @@ namespace Twitch::irc::message {
 			};
 			struct RECONNECT
 			{
-				static const std::regex regex;
 				static std::optional<RECONNECT> is(std::string_view raw_message);
+				static std::optional<RECONNECT> is(const TokenizedMessage& message) { return parse_optional<RECONNECT>(message); }
+				static bool parse(const TokenizedMessage& message, Emplace<RECONNECT>& emplace);
+				static constexpr std::array<std::string_view, 1> keywords{ "RECONNECT" };
+				static constexpr std::string_view name{ "RECONNECT" };
 
 				friend bool operator==(const RECONNECT& lhs, const RECONNECT& rhs);
 				friend bool operator!=(const RECONNECT& lhs, const RECONNECT& rhs);
@@ -156,10 +437,13 @@ namespace Twitch::irc::message {
 			/// raw, extended by cap tags
 			struct ROOMSTATE
 			{
-				static const std::regex regex;
 				static std::optional<ROOMSTATE> is(std::string_view raw_message);
+				static std::optional<ROOMSTATE> is(const TokenizedMessage& message) { return parse_optional<ROOMSTATE>(message); }
+				static bool parse(const TokenizedMessage& message, Emplace<ROOMSTATE>& emplace);
+				static constexpr std::array<std::string_view, 1> keywords{ "ROOMSTATE" };
+				static constexpr std::string_view name{ "ROOMSTATE" };
 				
-				const std::string channel;
+				const string_t channel;
 
 				friend bool operator==(const ROOMSTATE& lhs, const ROOMSTATE& rhs);
 				friend bool operator!=(const ROOMSTATE& lhs, const ROOMSTATE& rhs);
@@ -170,11 +454,14 @@ namespace Twitch::irc::message {
 			/// raw, extended by cap tags
 			struct USERNOTICE
 			{
-				static const std::regex regex;
 				static std::optional<USERNOTICE> is(std::string_view raw_message);
+				static std::optional<USERNOTICE> is(const TokenizedMessage& message) { return parse_optional<USERNOTICE>(message); }
+				static bool parse(const TokenizedMessage& message, Emplace<USERNOTICE>& emplace);
+				static constexpr std::array<std::string_view, 1> keywords{ "USERNOTICE" };
+				static constexpr std::string_view name{ "USERNOTICE" };
 
-				const std::string channel;
-				const std::string message;
+				const string_t channel;
+				const string_t message;
 
 				friend bool operator==(const USERNOTICE& lhs, const USERNOTICE& rhs);
 				friend bool operator!=(const USERNOTICE& lhs, const USERNOTICE& rhs);
@@ -185,10 +472,13 @@ namespace Twitch::irc::message {
 			/// raw, extended by cap tags
 			struct USERSTATE
 			{
-				static const std::regex regex;
 				static std::optional<USERSTATE> is(std::string_view raw_message);
+				static std::optional<USERSTATE> is(const TokenizedMessage& message) { return parse_optional<USERSTATE>(message); }
+				static bool parse(const TokenizedMessage& message, Emplace<USERSTATE>& emplace);
+				static constexpr std::array<std::string_view, 1> keywords{ "USERSTATE" };
+				static constexpr std::string_view name{ "USERSTATE" };
 
-				const std::string channel;
+				const string_t channel;
 
 				friend bool operator==(const USERSTATE& lhs, const USERSTATE& rhs);
 				friend bool operator!=(const USERSTATE& lhs, const USERSTATE& rhs);
@@ -245,11 +535,14 @@ namespace Twitch::irc::message {
 		namespace membership {
 			struct JOIN
 			{
-				static const std::regex regex;
 				static std::optional<JOIN> is(std::string_view raw_message);
+				static std::optional<JOIN> is(const TokenizedMessage& message) { return parse_optional<JOIN>(message); }
+				static bool parse(const TokenizedMessage& message, Emplace<JOIN>& emplace);
+				static constexpr std::array<std::string_view, 1> keywords{ "JOIN" };
+				static constexpr std::string_view name{ "JOIN" };
 
-				const std::string user;
-				const std::string channel;
+				const string_t user;
+				const string_t channel;
 
 				friend bool operator==(const JOIN& lhs, const JOIN& rhs);
 				friend bool operator!=(const JOIN& lhs, const JOIN& rhs);
@@ -259,12 +552,15 @@ namespace Twitch::irc::message {
 			};
 			struct MODE
 			{
-				static const std::regex regex;
 				static std::optional<MODE> is(std::string_view raw_message);
+				static std::optional<MODE> is(const TokenizedMessage& message) { return parse_optional<MODE>(message); }
+				static bool parse(const TokenizedMessage& message, Emplace<MODE>& emplace);
+				static constexpr std::array<std::string_view, 1> keywords{ "MODE" };
+				static constexpr std::string_view name{ "MODE" };
 
-				const std::string channel;
+				const string_t channel;
 				const bool gained; // true == +o; false == -o
-				const std::string user;
+				const string_t user;
 
 				friend bool operator==(const MODE& lhs, const MODE& rhs);
 				friend bool operator!=(const MODE& lhs, const MODE& rhs);
@@ -274,18 +570,21 @@ namespace Twitch::irc::message {
 			};
 			struct NAMES
 			{
-				static const std::regex regex;
 				static std::optional<NAMES> is(std::string_view raw_message);
+				static std::optional<NAMES> is(const TokenizedMessage& message) { return parse_optional<NAMES>(message); }
+				static bool parse(const TokenizedMessage& message, Emplace<NAMES>& emplace);
+				static constexpr std::array<std::string_view, 2> keywords{ "353", "366" }; // RPL_NAMREPLY, RPL_ENDOFNAMES
+				static constexpr std::string_view name{ "NAMES" };
 
 				inline bool is_end_of_list() const noexcept {
-					using namespace std::string_literals;
-					return msg_id == "366"s;
+					using namespace std::string_view_literals;
+					return msg_id == "366"sv;
 				}
 
-				const std::string user;
-				const std::string msg_id;
-				const std::string channel;
-				const std::vector<std::string> names;
+				const string_t user;
+				const string_t msg_id;
+				const string_t channel;
+				const names_t names;
 
 				friend bool operator==(const NAMES& lhs, const NAMES& rhs);
 				friend bool operator!=(const NAMES& lhs, const NAMES& rhs);
@@ -295,11 +594,14 @@ namespace Twitch::irc::message {
 			};
 			struct PART
 			{
-				static const std::regex regex;
 				static std::optional<PART> is(std::string_view raw_message);
+				static std::optional<PART> is(const TokenizedMessage& message) { return parse_optional<PART>(message); }
+				static bool parse(const TokenizedMessage& message, Emplace<PART>& emplace);
+				static constexpr std::array<std::string_view, 1> keywords{ "PART" };
+				static constexpr std::string_view name{ "PART" };
 
-				const std::string user;
-				const std::string channel;
+				const string_t user;
+				const string_t channel;
 
 				friend bool operator==(const PART& lhs, const PART& rhs);
 				friend bool operator!=(const PART& lhs, const PART& rhs);
@@ -349,13 +651,17 @@ namespace Twitch::irc::message {
 			using parameters::Color;
 			using parameters::BadgeLevel;
 			using parameters::Badge;
+			using parameters::Badges;
 			using parameters::UserPrivilegesLevel;
 			using parameters::UserType;
+			using parameters::Emote;
+			using parameters::EmoteIndex;
 
 			struct CLEARCHAT : public cap::commands::CLEARCHAT
 			{
-				static const std::regex regex;
 				static std::optional<CLEARCHAT> is(std::string_view raw_message);
+				static std::optional<CLEARCHAT> is(const TokenizedMessage& message) { return parse_optional<CLEARCHAT>(message); }
+				static bool parse(const TokenizedMessage& message, Emplace<CLEARCHAT>& emplace);
 
 				inline bool is_perm() const noexcept {
 					return ban_duration == timestamp_t{ 0 }
@@ -372,17 +678,17 @@ namespace Twitch::irc::message {
 				}
 				
 				const std::optional<timestamp_t> ban_duration{ 0 }; // default == permanent
-				const std::optional<std::string> ban_reason;
-				const std::string                room_id;
-				const std::optional<std::string> target_user_id;
+				const std::optional<string_t>    ban_reason;
+				const string_t                   room_id;
+				const std::optional<string_t>    target_user_id;
 				const timestamp_t                tmi_sent_ts;
 				
 				CLEARCHAT(
 					commands::CLEARCHAT&&        t_plain,
 					std::optional<timestamp_t>   t_duration,
-					std::optional<std::string>&& t_reason,
-					std::string&&                t_room_id,
-					std::optional<std::string>&& t_target_user_id,
+					std::optional<string_t>&&    t_reason,
+					string_t&&                   t_room_id,
+					std::optional<string_t>&&    t_target_user_id,
 					timestamp_t                  t_tmi_sent_ts
 				);
 
@@ -394,14 +700,17 @@ namespace Twitch::irc::message {
 			};
 			struct GLOBALUSERSTATE
 			{
-				static const std::regex regex;
 				static std::optional<GLOBALUSERSTATE> is(std::string_view raw_message);
+				static std::optional<GLOBALUSERSTATE> is(const TokenizedMessage& message) { return parse_optional<GLOBALUSERSTATE>(message); }
+				static bool parse(const TokenizedMessage& message, Emplace<GLOBALUSERSTATE>& emplace);
+				static constexpr std::array<std::string_view, 1> keywords{ "GLOBALUSERSTATE" };
+				static constexpr std::string_view name{ "GLOBALUSERSTATE" };
 
-				const std::map<Badge, BadgeLevel> badges;
+				const Badges badges;
 				const Color       color;
-				const std::string display_name;
-				const std::string emote_set;
-				const std::string user_id;
+				const string_t    display_name;
+				const string_t    emote_set;
+				const string_t    user_id;
 				const UserType    user_type;
 
 				friend bool operator==(const GLOBALUSERSTATE& lhs, const GLOBALUSERSTATE& rhs);
@@ -412,8 +721,9 @@ namespace Twitch::irc::message {
 			};
 			struct PRIVMSG : public message::PRIVMSG
 			{
-				static const std::regex regex;
 				static std::optional<PRIVMSG> is(std::string_view raw_message);
+				static std::optional<PRIVMSG> is(const TokenizedMessage& message) { return parse_optional<PRIVMSG>(message); }
+				static bool parse(const TokenizedMessage& message, Emplace<PRIVMSG>& emplace);
 
 				inline bool is_bitsmsg() const noexcept {
 					return bits != 0;
@@ -425,45 +735,54 @@ namespace Twitch::irc::message {
 				}
 
 				inline auto get_privileges_level() const {
-					if (badges.empty())                                { return UserPrivilegesLevel::normal     ; }
-					if (helpers::contains(badges, Badge::broadcaster)) { return UserPrivilegesLevel::broadcaster; }
-					if (helpers::contains(badges, Badge::moderator))   { return UserPrivilegesLevel::moderator  ; }
-					if (helpers::contains(badges, Badge::subscriber))  { return UserPrivilegesLevel::subscriber ; }
-					if (is_regular())                                  { return UserPrivilegesLevel::regular    ; }
+					constexpr auto broadcaster = Badges::mask_of(Badge::broadcaster);
+					constexpr auto moderator   = Badges::mask_of(Badge::moderator);
+					constexpr auto subscriber  = Badges::mask_of(Badge::subscriber);
+
+					const auto mask = badges.mask();
+					if (mask == 0)           { return UserPrivilegesLevel::normal     ; }
+					if (mask & broadcaster)  { return UserPrivilegesLevel::broadcaster; }
+					if (mask & moderator)    { return UserPrivilegesLevel::moderator  ; }
+					if (mask & subscriber)   { return UserPrivilegesLevel::subscriber ; }
+					if (is_regular())        { return UserPrivilegesLevel::regular    ; }
 
 					return UserPrivilegesLevel::normal;
 				}
 
-				const std::map<Badge, BadgeLevel> badges;
+				// decoded on every call, keep the index while using it, resolve ids with index.get(emotes, i)
+				// ranges are byte offsets into message
+				EmoteIndex emote_index() const;
+
+				const Badges badges;
 				const unsigned int bits{ 0 }; // default == not bits msg
 				const Color       color;
-				const std::string display_name;
+				const string_t    display_name;
 				const bool        emote_only{ false };
-				const std::string emotes; // list of emotes and their pos in message, left unprocessed
-				const std::string id;
+				const string_t    emotes; // raw "id:b-e,b-e/id:b-e", see emote_index()
+				const string_t    id;
 				const bool        mod;
-				const std::string room_id;
+				const string_t    room_id;
 				const bool        subscriber;
 				const timestamp_t tmi_sent_ts;
 				const bool        turbo;
-				const std::string user_id;
+				const string_t    user_id;
 				const UserType    user_type;
 
 				PRIVMSG(
 					message::PRIVMSG&&            t_plain,
-					std::map<Badge, BadgeLevel>&& t_badge,
+					Badges        t_badge,
 					unsigned int  t_bits,
 					Color         t_color,
-					std::string&& t_display_name,
+					string_t&&    t_display_name,
 					bool          t_emote_only,
-					std::string&& t_emotes,
-					std::string&& t_id,
+					string_t&&    t_emotes,
+					string_t&&    t_id,
 					bool          t_mod,
-					std::string&& t_room_id,
+					string_t&&    t_room_id,
 					bool          t_subscriber,
 					timestamp_t   t_tmi_sent_ts,
 					bool          t_turbo,
-					std::string&& t_user_id,
+					string_t&&    t_user_id,
 					UserType      t_user_type
 				);
 
@@ -475,8 +794,9 @@ namespace Twitch::irc::message {
 			};
 			struct ROOMSTATE : cap::commands::ROOMSTATE
 			{
-				static const std::regex regex;
 				static std::optional<ROOMSTATE> is(std::string_view raw_message);
+				static std::optional<ROOMSTATE> is(const TokenizedMessage& message) { return parse_optional<ROOMSTATE>(message); }
+				static bool parse(const TokenizedMessage& message, Emplace<ROOMSTATE>& emplace);
 
 				inline bool is_update() const noexcept {
 					return 1 == static_cast<int>(broadcaster_lang.has_value())
@@ -489,23 +809,23 @@ namespace Twitch::irc::message {
 				}
 
 				// empty if not enabled
-				const std::optional<std::string> broadcaster_lang{ std::nullopt };
+				const std::optional<string_t>    broadcaster_lang{ std::nullopt };
 				const std::optional<bool>        emote_only;
 				const std::optional<int>         followers_only; // -1 == disabled
 				const std::optional<bool>        r9k;
-				const std::optional<std::string> rituals; // doc doesn't say a word... std::string for safety
-				const std::string                room_id;
+				const std::optional<string_t>    rituals; // doc doesn't say a word... std::string for safety
+				const string_t                   room_id;
 				const std::optional<timestamp_t> slow;
 				const std::optional<bool>        subs_only;
 				
 				ROOMSTATE(
 					cap::commands::ROOMSTATE&&   t_roomstate,
-					std::optional<std::string>&& t_lang,
+					std::optional<string_t>&&    t_lang,
 					std::optional<bool>          t_emote_only,
 					std::optional<int>           t_followers_only,
 					std::optional<bool>          t_r9k,
-					std::optional<std::string>&& t_rituals,
-					std::string&&                t_room_id,
+					std::optional<string_t>&&    t_rituals,
+					string_t&&                   t_room_id,
 					std::optional<timestamp_t> t_slow,
 					std::optional<bool>          t_subs_only
 				);
@@ -529,12 +849,12 @@ namespace Twitch::irc::message {
 				};
 				struct Sub
 				{
-					static const std::regex regex;
 					static std::optional<Sub> is(std::string_view raw_message);
+					static std::optional<Sub> is(const TagIndex& tags);
 
 					const int months;
-					const std::string sub_plan;
-					const std::string sub_plan_name;
+					const string_t sub_plan;
+					const string_t sub_plan_name;
 
 					friend bool operator==(const Sub& lhs, const Sub& rhs);
 					friend bool operator!=(const Sub& lhs, const Sub& rhs);
@@ -542,15 +862,15 @@ namespace Twitch::irc::message {
 				};
 				struct Subgift
 				{
-					static const std::regex regex;
 					static std::optional<Subgift> is(std::string_view raw_message);
+					static std::optional<Subgift> is(const TagIndex& tags);
 
 					const int months;
-					const std::string recipient_display_name;
-					const std::string recipient_id;
-					const std::string recipient_name;
-					const std::string sub_plan_name;
-					const std::string sub_plan;
+					const string_t recipient_display_name;
+					const string_t recipient_id;
+					const string_t recipient_name;
+					const string_t sub_plan_name;
+					const string_t sub_plan;
 
 					friend bool operator==(const Subgift& lhs, const Subgift& rhs);
 					friend bool operator!=(const Subgift& lhs, const Subgift& rhs);
@@ -558,11 +878,11 @@ namespace Twitch::irc::message {
 				};
 				struct Raid
 				{
-					static const std::regex regex;
 					static std::optional<Raid> is(std::string_view raw_message);
+					static std::optional<Raid> is(const TagIndex& tags);
 
-					const std::string display_name;
-					const std::string login;
+					const string_t display_name;
+					const string_t login;
 					const int viewer_count;
 
 					friend bool operator==(const Raid& lhs, const Raid& rhs);
@@ -572,47 +892,49 @@ namespace Twitch::irc::message {
 				struct Ritual
 				{
 					static std::optional<Ritual> is(std::string_view raw_message);
+					static std::optional<Ritual> is(const TagIndex& tags);
 
 					friend bool operator==(const Ritual& lhs, const Ritual& rhs);
 					friend bool operator!=(const Ritual& lhs, const Ritual& rhs);
 
 				};
 
-				static const std::regex regex;
 				static std::optional<USERNOTICE> is(std::string_view raw_message);
+				static std::optional<USERNOTICE> is(const TokenizedMessage& message) { return parse_optional<USERNOTICE>(message); }
+				static bool parse(const TokenizedMessage& message, Emplace<USERNOTICE>& emplace);
 
-				const std::map<Badge, BadgeLevel> badges;
+				const Badges badges;
 				const Color       color;
-				const std::string display_name;
-				const std::string emotes;
-				const std::string id;
-				const std::string login;
+				const string_t    display_name;
+				const string_t    emotes;
+				const string_t    id;
+				const string_t    login;
 				const bool        mod;
 				const boost::variant<ParseError, Sub, Subgift, Raid, Ritual> msg_id;
-				const std::string room_id;
+				const string_t    room_id;
 				const bool        subscriber;
-				const std::string system_msg;
+				const string_t    system_msg;
 				const timestamp_t tmi_sent_ts;
 				const bool        turbo;
-				const std::string user_id;
+				const string_t    user_id;
 				const UserType    user_type;
 
 				USERNOTICE(
 					cap::commands::USERNOTICE&&   t_usernotice,
-					std::map<Badge, BadgeLevel>&& t_badges,
+					Badges        t_badges,
 					Color         t_color,
-					std::string&& t_display_name,
-					std::string&& t_emotes,
-					std::string&& t_id,
-					std::string&& t_login,
+					string_t&&    t_display_name,
+					string_t&&    t_emotes,
+					string_t&&    t_id,
+					string_t&&    t_login,
 					bool          t_mod,
 					boost::variant<ParseError, Sub, Subgift, Raid, Ritual>&& t_msg_id,
-					std::string&& t_room_id,
+					string_t&&    t_room_id,
 					bool          t_subscriber,
-					std::string&& t_system_msg,
+					string_t&&    t_system_msg,
 					timestamp_t t_tmi_sent_ts,
 					bool          t_turbo,
-					std::string&& t_user_id,
+					string_t&&    t_user_id,
 					UserType      t_user_type
 				);
 
@@ -624,23 +946,24 @@ namespace Twitch::irc::message {
 			};
 			struct USERSTATE : public cap::commands::USERSTATE
 			{
-				static const std::regex regex;
 				static std::optional<USERSTATE> is(std::string_view raw_message);
+				static std::optional<USERSTATE> is(const TokenizedMessage& message) { return parse_optional<USERSTATE>(message); }
+				static bool parse(const TokenizedMessage& message, Emplace<USERSTATE>& emplace);
 
-				const std::map<Badge, BadgeLevel> badges;
+				const Badges badges;
 				const Color       color;
-				const std::string display_name;
-				const std::string emote_sets;
+				const string_t    display_name;
+				const string_t    emote_sets;
 				const bool        mod;
 				const bool        subscriber;
 				const UserType    user_type;
 
 				USERSTATE(
 					cap::commands::USERSTATE&&    t_userstate,
-					std::map<Badge, BadgeLevel>&& t_badges,
+					Badges        t_badges,
 					Color         t_color,
-					std::string&& t_display_name,
-					std::string&& t_emote_sets,
+					string_t&&    t_display_name,
+					string_t&&    t_emote_sets,
 					bool          t_mod,
 					bool          t_subscriber,
 					UserType      t_user_type
@@ -826,14 +1149,137 @@ namespace Twitch::irc::message {
 		} // namespace tags
 	} // namespace cap
 
+	/// non-owning counterparts of the most frequent messages,
+	/// fields are views into the raw line and live only as long as it does
+	namespace view {
+		struct PING
+		{
+			static std::optional<PING> is(std::string_view raw_message);
+			static std::optional<PING> is(const TokenizedMessage& message);
+
+			message::PING to_owned() const;
+
+			std::string_view host;
+
+			template<class Logger>
+			friend Logger& operator<<(Logger& logger, const PING& msg);
+		};
+		struct JOIN
+		{
+			static std::optional<JOIN> is(std::string_view raw_message);
+			static std::optional<JOIN> is(const TokenizedMessage& message);
+
+			cap::membership::JOIN to_owned() const;
+
+			std::string_view user;
+			std::string_view channel;
+
+			template<class Logger>
+			friend Logger& operator<<(Logger& logger, const JOIN& msg);
+		};
+		struct PART
+		{
+			static std::optional<PART> is(std::string_view raw_message);
+			static std::optional<PART> is(const TokenizedMessage& message);
+
+			cap::membership::PART to_owned() const;
+
+			std::string_view user;
+			std::string_view channel;
+
+			template<class Logger>
+			friend Logger& operator<<(Logger& logger, const PART& msg);
+		};
+		/// tagged PRIVMSG, tag values are kept raw and decoded by to_owned()
+		struct PRIVMSG
+		{
+			static std::optional<PRIVMSG> is(std::string_view raw_message);
+			static std::optional<PRIVMSG> is(const TokenizedMessage& message);
+
+			cap::tags::PRIVMSG to_owned() const;
+
+			std::string_view user;
+			std::string_view host;
+			std::string_view channel;
+			std::string_view message;
+
+			std::string_view badges;
+			std::string_view bits;
+			std::string_view color;
+			std::string_view display_name;
+			std::string_view emote_only;
+			std::string_view emotes;
+			std::string_view id;
+			std::string_view mod;
+			std::string_view room_id;
+			std::string_view subscriber;
+			std::string_view tmi_sent_ts;
+			std::string_view turbo;
+			std::string_view user_id;
+			std::string_view user_type;
+
+			template<class Logger>
+			friend Logger& operator<<(Logger& logger, const PRIVMSG& msg);
+		};
+
+		template<class Logger>
+		Logger& operator<<(Logger& logger, const PING& msg) {
+			return logger << "PING :" << msg.host;
+		}
+		template<class Logger>
+		Logger& operator<<(Logger& logger, const JOIN& msg) {
+			return logger << ':' << msg.user << '!' << msg.user << '@'
+				<< msg.user << ".tmi.twitch.tv JOIN " << msg.channel;
+		}
+		template<class Logger>
+		Logger& operator<<(Logger& logger, const PART& msg) {
+			return logger << ':' << msg.user << '!' << msg.user << '@'
+				<< msg.user << ".tmi.twitch.tv PART " << msg.channel;
+		}
+		template<class Logger>
+		Logger& operator<<(Logger& logger, const PRIVMSG& msg) {
+			logger
+				<< "@badges=" << msg.badges << ';'
+				<< "color="   << msg.color  << ';';
+			if (!msg.bits.empty()) {
+				logger << "bits=" << msg.bits << ';';
+			}
+			logger
+				<< "display-name=" << msg.display_name << ';'
+				<< "emotes="       << msg.emotes       << ';'
+				<< "id="           << msg.id           << ';'
+				<< "mod="          << msg.mod          << ';'
+				<< "room-id="      << msg.room_id      << ';'
+				<< "subscriber="   << msg.subscriber   << ';'
+				<< "tmi-sent-ts="  << msg.tmi_sent_ts  << ';'
+				<< "turbo="        << msg.turbo        << ';'
+				<< "user-id="      << msg.user_id      << ';'
+				<< "user-type="    << msg.user_type
+				<< " :" << msg.user << '!' << msg.user << '@' << msg.user << '.' << msg.host
+				<< " PRIVMSG " << msg.channel << " :" << msg.message;
+			return logger;
+		}
+	} // namespace view
+
 	struct ParseError {
+		enum class Reason { malformed, not_handled, exception };
+		static constexpr std::array<std::string_view, 3> reasons{ "malformed", "not_handled", "exception" };
+
 		const std::string err;
+		const Reason reason{ Reason::exception };
 
 		inline std::string what() const noexcept { return err; }
 	};
 
-	struct ParserVisitor : public boost::static_visitor<void>
-	{ // TODO: add stats
+	/// line of a kind the parser isn't subscribed to, only classified and counted
+	struct Skipped {
+		int which; // result_t::index() it would have been parsed into
+	};
+
+	class Subscription;
+
+	struct ParserVisitor
+	{
 	private:
 		inline std::string translate_sub_plan(const std::string_view raw_sub_plan) const {
 			using namespace std::string_view_literals;
@@ -848,7 +1294,7 @@ namespace Twitch::irc::message {
 
 		inline void handle_error(const boost::system::error_code& e) const noexcept {
 			if (e) {
-				BOOST_LOG_SEV(m_lg, severity::debug) << "Error: " << e.message();
+				TWITCH_IRC_LOG(m_lg, debug, "Error: ", e.message());
 			}
 		}
 
@@ -856,6 +1302,7 @@ namespace Twitch::irc::message {
 		using severity = boost::log::trivial::severity_level;
 
 		void operator()(const ParseError& e) const;
+		void operator()([[maybe_unused]] const Skipped&) const noexcept {}
 		void operator()(const PING& ping) const;
 		void operator()(const cap::tags::PRIVMSG& privmsg) const;
 
@@ -872,52 +1319,184 @@ namespace Twitch::irc::message {
 		void operator()(const cap::membership::NAMES& list) const;
 		void operator()([[maybe_unused]] const cap::commands::RECONNECT&) const;
 
+		// kinds this visitor does more than trace, everything else can be skipped,
+		// all of them when trace records are compiled in
+		static Subscription subscription() noexcept;
+
 		ParserVisitor(
 			std::shared_ptr<Twitch::irc::IController> m_controller,
-			std::shared_ptr<Twitch::irc::Commands> t_commands,
+			std::shared_ptr<Twitch::irc::Channels> t_channels,
+			std::shared_ptr<Twitch::irc::CommandExecutor> t_executor,
 			Twitch::irc::logger_t& t_logger
 		);
 
 	private:
 		std::shared_ptr<Twitch::irc::IController>  m_controller;
-		std::shared_ptr<Twitch::irc::Commands>     m_commands;
+		std::shared_ptr<Twitch::irc::Channels>     m_channels;
+		std::shared_ptr<Twitch::irc::CommandExecutor> m_executor;
 		Twitch::irc::logger_t& m_lg;
 	};
 
+	template<class... Ts>
+	struct TypeList {
+		static constexpr std::size_t size = sizeof...(Ts);
+	};
+
+	template<class T>
+	struct TypeTag { using type = T; };
+
+	template<class... Ts, class Fn>
+	constexpr void for_each_type(TypeList<Ts...>, Fn&& fn) {
+		(fn(TypeTag<Ts>{}), ...);
+	}
+
+	// position of T in the list, -1 if it isn't there
+	template<class T, class... Ts>
+	constexpr int index_of(TypeList<Ts...>) noexcept {
+		constexpr std::array<bool, sizeof...(Ts)> same{ std::is_same_v<T, Ts>... };
+		for (std::size_t i{ 0 }; i < same.size(); ++i) {
+			if (same[i]) { return static_cast<int>(i); }
+		}
+		return -1;
+	}
+
+	/// every type MessageParser::process produces, each one declares its command keywords
+	/// adding one here is all it takes, dispatch table is built from this list at compile time
+	using parsed_types_t = TypeList<
+		PING,
+		cap::commands::HOSTTARGET,
+		cap::commands::NOTICE,
+		cap::commands::RECONNECT,
+		cap::tags::CLEARCHAT,
+		cap::tags::GLOBALUSERSTATE,
+		cap::tags::PRIVMSG,
+		cap::tags::ROOMSTATE,
+		cap::tags::USERNOTICE,
+		cap::tags::USERSTATE,
+		cap::membership::JOIN,
+		cap::membership::MODE,
+		cap::membership::NAMES,
+		cap::membership::PART
+	>;
+
+	/// set of parsed_types_t a parser builds, bit n is result_t::index() n
+	class Subscription
+	{
+	public:
+		template<class... Ts>
+		static constexpr Subscription of() noexcept {
+			return Subscription{ (bit<Ts>() | ... | std::uint32_t{ 0 }) };
+		}
+		static constexpr Subscription all() noexcept {
+			return Subscription{ ((std::uint32_t{ 1 } << parsed_types_t::size) - 1) << 1 };
+		}
+
+		inline constexpr bool contains(int which) const noexcept {
+			return which > 0 && (m_mask >> which) & 1u;
+		}
+		inline constexpr bool is_all() const noexcept { return m_mask == all().m_mask; }
+		inline constexpr std::uint32_t mask() const noexcept { return m_mask; }
+
+	private:
+		explicit constexpr Subscription(std::uint32_t t_mask) noexcept : m_mask(t_mask) {}
+
+		template<class T>
+		static constexpr std::uint32_t bit() noexcept {
+			constexpr int index = index_of<T>(parsed_types_t{});
+			static_assert(index >= 0, "only parsed_types_t can be subscribed to");
+			return std::uint32_t{ 1 } << (index + 1); // 0 is ParseError
+		}
+
+		std::uint32_t m_mask;
+	};
+	static_assert(parsed_types_t::size < 31, "Subscription mask is 32 bits wide");
+
+	// ParseError inline, every message alternative is a pointer into its pool
+	// Skipped goes last so message alternatives keep their indices
+	template<class List> struct parse_result;
+	template<class... Ts> struct parse_result<TypeList<Ts...>> {
+		using type = std::variant<ParseError, Pooled<Ts>..., Skipped>;
+	};
+
+	namespace details {
+		inline const ParseError& unwrap(const ParseError& e) noexcept { return e; }
+		inline const Skipped& unwrap(const Skipped& skipped) noexcept { return skipped; }
+		template<class T>
+		inline const T& unwrap(const Pooled<T>& message) noexcept { return *message; }
+	}
+
+	// calls visitor with the parsed message itself, pooled handles are unwrapped
+	template<class Visitor, class Result>
+	decltype(auto) apply(Visitor&& visitor, const Result& result) {
+		return std::visit([&](const auto& alternative) -> decltype(auto) {
+			return visitor(details::unwrap(alternative));
+		}, result);
+	}
+
+	// parsed message of type T or nullptr
+	template<class T, class Result>
+	const T* get_parsed(const Result& result) noexcept {
+		if constexpr (std::is_same_v<T, ParseError> || std::is_same_v<T, Skipped>) { return std::get_if<T>(&result); }
+		else {
+			const auto* pooled = std::get_if<Pooled<T>>(&result);
+			return pooled ? pooled->get() : nullptr;
+		}
+	}
+
 	// for all caps
 	class MessageParser
 	{
 	public:
-		using result_t = boost::variant<
-			ParseError,
-			PING,
-			cap::commands::HOSTTARGET,
-			cap::commands::NOTICE,
-			cap::commands::RECONNECT,
-			cap::tags::CLEARCHAT,
-			cap::tags::GLOBALUSERSTATE,
-			cap::tags::PRIVMSG,
-			cap::tags::ROOMSTATE,
-			cap::tags::USERNOTICE,
-			cap::tags::USERSTATE,
-			cap::membership::JOIN,
-			cap::membership::MODE,
-			cap::membership::NAMES,
-			cap::membership::PART
-		>;
+		using result_t = typename parse_result<parsed_types_t>::type;
 
+		/// lines of unsubscribed kinds are classified by their command token alone
+		/// and come back as Skipped, nothing is tokenized or allocated for them
+		/// counted and timed per result_t alternative in metrics()
 		result_t process(std::string_view recived_message);
 
-		inline ParserVisitor get_visitor(
+		// visits result with visitor like apply() and times the handler
+		template<class Visitor>
+		void dispatch(Visitor&& visitor, const result_t& result) {
+			const auto start = metrics::clock_t::now();
+			apply(visitor, result);
+			m_metrics.handled(result.index(), metrics::clock_t::now() - start);
+		}
+
+		// result_t::index() a command token is dispatched to, nullopt if nothing handles it
+		static std::optional<int> route(std::string_view command) noexcept;
+
+		// built on first use, every parser (and so every connection) has its own
+		inline const ParserVisitor& get_visitor(
 			std::shared_ptr<IController> t_controller,
-			std::shared_ptr<Commands> t_commands,
+			std::shared_ptr<Channels> t_channels,
+			std::shared_ptr<CommandExecutor> t_executor,
 			logger_t& lg
 		) {
-			static ParserVisitor visitor{ t_controller, t_commands, lg };
-			return visitor;
+			if (!m_visitor) { m_visitor.emplace(t_controller, t_channels, t_executor, lg); }
+			return *m_visitor;
 		}
 
-		MessageParser() = default;
+		// lines skipped so far, in total or of one result_t::index()
+		inline std::uint64_t skipped() const noexcept { return m_skipped_total; }
+		inline std::uint64_t skipped(int which) const noexcept {
+			return which >= 0 && static_cast<std::size_t>(which) < m_skipped.size() ? m_skipped[which] : 0;
+		}
+
+		inline Subscription subscription() const noexcept { return m_subscription; }
+
+		// safe to read from any thread while process() runs
+		inline const metrics::ParserMetrics& metrics() const noexcept { return m_metrics; }
+
+		explicit MessageParser(Subscription t_subscription = Subscription::all());
+
+	private:
+		result_t parse(std::string_view recived_message);
+
+		std::optional<ParserVisitor> m_visitor;
+		metrics::ParserMetrics m_metrics;
+		Subscription m_subscription;
+		std::array<std::uint64_t, parsed_types_t::size + 1> m_skipped{};
+		std::uint64_t m_skipped_total{ 0 };
 	};
 
 } // namespace Twitch::irc::message
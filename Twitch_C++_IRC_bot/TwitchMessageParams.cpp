@@ -1,7 +1,43 @@
 #include "stdafx.h"
 #include "TwitchMessageParams.h"
+#include <algorithm>
+#include <charconv>
+#include <limits>
+
+namespace {
+	constexpr std::uint8_t not_hex = 0x10;
+
+	// hex digit value or not_hex, lets Color::from_string decode without branching per digit
+	constexpr auto hex_table = []() {
+		std::array<std::uint8_t, 256> table{};
+		for (std::size_t c{ 0 }; c < table.size(); ++c) {
+			if (c >= '0' && c <= '9')      { table[c] = static_cast<std::uint8_t>(c - '0'); }
+			else if (c >= 'a' && c <= 'f') { table[c] = static_cast<std::uint8_t>(c - 'a' + 10); }
+			else if (c >= 'A' && c <= 'F') { table[c] = static_cast<std::uint8_t>(c - 'A' + 10); }
+			else                           { table[c] = not_hex; }
+		}
+		return table;
+	}();
+}
 
 namespace Twitch::irc::parameters {
+	Parsed<Color> Color::from_string(std::string_view raw) noexcept {
+		if (raw.empty()) { return { std::nullopt, ParseError::empty }; }
+		if (raw.size() != 7 || raw.front() != '#') { return { std::nullopt, ParseError::invalid }; }
+
+		const auto* digits = reinterpret_cast<const unsigned char*>(raw.data() + 1);
+		const auto digit = [&](std::size_t i) -> unsigned { return hex_table[digits[i]]; };
+
+		const unsigned d0 = digit(0), d1 = digit(1), d2 = digit(2);
+		const unsigned d3 = digit(3), d4 = digit(4), d5 = digit(5);
+		if ((d0 | d1 | d2 | d3 | d4 | d5) & not_hex) { return { std::nullopt, ParseError::invalid }; }
+
+		return {
+			Color{ static_cast<int>(d0 << 4 | d1), static_cast<int>(d2 << 4 | d3), static_cast<int>(d4 << 4 | d5) },
+			ParseError::none
+		};
+	}
+
 	bool operator==(const Color& lhs, const Color& rhs) {
 		if (lhs.initialized != rhs.initialized) { return false; }
 
@@ -12,4 +48,144 @@ namespace Twitch::irc::parameters {
 	bool operator!=(const Color& lhs, const Color& rhs) {
 		return !(lhs == rhs);
 	}
-}
\ No newline at end of file
+
+	EmoteIndex EmoteIndex::decode(std::string_view raw) {
+		EmoteIndex index;
+		if (raw.empty()) { return index; }
+		// offsets are 16 bit, twitch messages are far shorter
+		if (raw.size() > std::numeric_limits<std::uint16_t>::max()) {
+			index.m_valid = false;
+			return index;
+		}
+
+		const auto invalid = [&]() {
+			index.m_valid = false;
+			return index;
+		};
+
+		std::size_t pos{ 0 };
+		while (pos < raw.size()) {
+			const auto group_end = std::min(raw.find('/', pos), raw.size());
+			const auto colon = raw.find(':', pos);
+			if (colon == std::string_view::npos || colon == pos || colon + 1 >= group_end) { return invalid(); }
+
+			const auto id_offset = static_cast<std::uint16_t>(pos);
+			const auto id_size = static_cast<std::uint16_t>(colon - pos);
+
+			for (auto cur = colon + 1; cur < group_end;) {
+				const auto range_end = std::min(raw.find(',', cur), group_end);
+				const char* first = raw.data() + cur;
+				const char* last = raw.data() + range_end;
+
+				std::uint16_t begin{ 0 }, end{ 0 };
+				const auto [dash, begin_err] = std::from_chars(first, last, begin);
+				if (begin_err != std::errc{} || dash == last || *dash != '-') { return invalid(); }
+				const auto [stop, end_err] = std::from_chars(dash + 1, last, end);
+				if (end_err != std::errc{} || stop != last || end < begin) { return invalid(); }
+
+				index.push(Range{ id_offset, id_size, begin, end });
+				cur = range_end + 1;
+			}
+
+			pos = group_end + 1;
+		}
+
+		return index;
+	}
+
+	namespace {
+		// code point -> its bytes in UTF-8 text, walks on from the last lookup when it's further in
+		class CodePoints
+		{
+		public:
+			explicit CodePoints(std::string_view t_text) noexcept : m_text(t_text) {}
+
+			// first and last byte of the code point, nullopt past the end of text
+			std::optional<std::pair<std::size_t, std::size_t>> at(std::size_t index) noexcept {
+				if (index < m_index) { m_index = 0; m_byte = 0; }
+				while (m_index < index && m_byte < m_text.size()) {
+					m_byte = next(m_byte);
+					++m_index;
+				}
+				if (m_byte >= m_text.size()) { return std::nullopt; }
+				return std::pair{ m_byte, next(m_byte) - 1 };
+			}
+
+		private:
+			std::size_t next(std::size_t byte) const noexcept {
+				do { ++byte; } while (byte < m_text.size() && (static_cast<unsigned char>(m_text[byte]) & 0xC0) == 0x80);
+				return byte;
+			}
+
+			std::string_view m_text;
+			std::size_t m_index{ 0 };
+			std::size_t m_byte{ 0 };
+		};
+	}
+
+	EmoteIndex EmoteIndex::decode(std::string_view raw, std::string_view text) {
+		auto index = decode(raw);
+		if (text.size() > std::numeric_limits<std::uint16_t>::max()) {
+			index.truncate(0);
+			index.m_valid = false;
+			return index;
+		}
+
+		CodePoints code_points{ text };
+		for (std::size_t i{ 0 }; i < index.size(); ++i) {
+			auto& r = index.range(i);
+			const auto first = code_points.at(r.begin);
+			const auto last = code_points.at(r.end);
+			if (!first || !last) {
+				index.truncate(i);
+				index.m_valid = false;
+				return index;
+			}
+
+			r.begin = static_cast<std::uint16_t>(first->first);
+			r.end = static_cast<std::uint16_t>(last->second);
+		}
+		return index;
+	}
+
+	Emote EmoteIndex::get(std::string_view raw, std::size_t i) const noexcept {
+		const auto& r = range(i);
+		return Emote{ raw.substr(r.id_offset, r.id_size), r.begin, r.end };
+	}
+
+	void EmoteIndex::push(Range range) {
+		if (m_size < inline_capacity) {
+			m_inline[m_size++] = range;
+			return;
+		}
+
+		if (m_spill.empty()) { m_spill.reserve(inline_capacity); }
+		m_spill.push_back(range);
+		++m_size;
+	}
+
+	void EmoteIndex::truncate(std::size_t size) noexcept {
+		if (size >= m_size) { return; }
+		m_spill.resize(size > inline_capacity ? size - inline_capacity : 0);
+		m_size = size;
+	}
+
+	const EmoteIndex::Range& EmoteIndex::range(std::size_t i) const noexcept {
+		return i < inline_capacity ? m_inline[i] : m_spill[i - inline_capacity];
+	}
+
+	void EmoteStats::add(std::string_view raw_emotes) {
+		const auto index = EmoteIndex::decode(raw_emotes);
+		for (std::size_t i{ 0 }; i < index.size(); ++i) {
+			const auto id = index.get(raw_emotes, i).id;
+			if (auto it = m_counts.find(id); it != std::end(m_counts)) { ++it->second; }
+			else { m_counts.emplace(std::string{ id }, 1); }
+		}
+		m_total += index.size();
+	}
+
+	std::size_t EmoteStats::count(std::string_view id) const noexcept {
+		const auto it = m_counts.find(id);
+		return it != std::end(m_counts) ? it->second : 0;
+	}
+}
@@ -1,30 +1,70 @@
 #ifndef TWITCHMESSAGEPARAMS_H
 #define TWITCHMESSAGEPARAMS_H
 
+#include <array>
+#include <charconv>
 #include <chrono>
+#include <cstdint>
+#include <initializer_list>
+#include <ios>
 #include <string>
 #include <string_view>
 #include <optional>
 #include <map>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace Twitch::irc::parameters {
 	using timestamp_t = std::chrono::seconds;
 
+	enum class ParseError {
+		none = 0,
+		empty,        // tag present without value
+		invalid,      // not a number / not #RRGGBB
+		out_of_range  // doesn't fit the target type
+	};
+
+	/// parsed tag value or the reason there is none, tag parsing never throws
+	template<class T>
+	struct Parsed {
+		std::optional<T> value;
+		ParseError error{ ParseError::none };
+
+		constexpr explicit operator bool() const noexcept { return value.has_value(); }
+		constexpr T value_or(T fallback) const { return value ? *value : fallback; }
+	};
+
+	// whole string has to be a number, no whitespace, no locale
+	template<class Integer>
+	Parsed<Integer> parse_integer(std::string_view raw) noexcept {
+		static_assert(std::is_integral_v<Integer>, "parse_integer expects an integral type");
+		if (raw.empty()) { return { std::nullopt, ParseError::empty }; }
+
+		Integer value{ 0 };
+		const char* last = raw.data() + raw.size();
+		const auto [stop, err] = std::from_chars(raw.data(), last, value);
+		if (err == std::errc::result_out_of_range) { return { std::nullopt, ParseError::out_of_range }; }
+		if (err != std::errc{} || stop != last) { return { std::nullopt, ParseError::invalid }; }
+
+		return { value, ParseError::none };
+	}
+
+	inline Parsed<timestamp_t> parse_seconds(std::string_view raw) noexcept {
+		const auto count = parse_integer<timestamp_t::rep>(raw);
+		if (!count) { return { std::nullopt, count.error }; }
+
+		return { timestamp_t{ *count.value }, ParseError::none };
+	}
+
 	// TODO: separate classes for users, add user list for channel
 	struct NoColor {};
 	struct Color {
 		bool initialized{ false };
 		const int r{ 0 }, g{ 0 }, b{ 0 };
 
-		static inline auto from_string(
-			const std::string& r, const std::string& g, const std::string& b
-		) {
-			auto hex_to_int = [](const std::string& raw_hex) {
-				return std::stoi(raw_hex, 0, 16);
-			};
-
-			return Color{ hex_to_int(r), hex_to_int(g), hex_to_int(b) };
-		}
+		// "#RRGGBB", either case
+		static Parsed<Color> from_string(std::string_view raw) noexcept;
 
 		constexpr Color(NoColor) {};
 		constexpr Color(int t_r, int t_g, int t_b) noexcept
@@ -91,6 +131,156 @@ namespace Twitch::irc::parameters {
 		return "unhandled_badge";
 	}
 
+	// one use of an emote in a message, begin/end are inclusive positions:
+	// byte offsets into the message when decoded against it, code points as twitch sends them otherwise
+	struct Emote {
+		std::string_view id;
+		std::size_t begin{ 0 };
+		std::size_t end{ 0 };
+
+		friend constexpr bool operator==(const Emote& lhs, const Emote& rhs) noexcept {
+			return lhs.id == rhs.id && lhs.begin == rhs.begin && lhs.end == rhs.end;
+		}
+		friend constexpr bool operator!=(const Emote& lhs, const Emote& rhs) noexcept {
+			return !(lhs == rhs);
+		}
+	};
+
+	/// decoded "emotes" tag: "id:b-e,b-e/id:b-e"
+	/// keeps offsets only, so it stays valid when the owning string is moved;
+	/// ids are resolved against the same raw string on access
+	/// a plain value, decoded when asked for, the caller owns it
+	class EmoteIndex
+	{
+	public:
+		static constexpr std::size_t inline_capacity = 8; // spills to one heap block past that
+
+		static EmoteIndex decode(std::string_view raw);
+		// twitch counts code points, ranges are turned into byte offsets into the UTF-8 text
+		// a range past the end of text makes the index invalid
+		static EmoteIndex decode(std::string_view raw, std::string_view text);
+
+		// raw has to be the string this index was decoded from
+		Emote get(std::string_view raw, std::size_t i) const noexcept;
+
+		inline std::size_t size() const noexcept { return m_size; }
+		inline bool empty() const noexcept { return m_size == 0; }
+		// false if raw was malformed, ranges before the error are kept
+		inline bool valid() const noexcept { return m_valid; }
+
+	private:
+		struct Range
+		{
+			std::uint16_t id_offset;
+			std::uint16_t id_size;
+			std::uint16_t begin;
+			std::uint16_t end;
+		};
+
+		void push(Range range);
+		void truncate(std::size_t size) noexcept; // drops ranges from size on
+		const Range& range(std::size_t i) const noexcept;
+		inline Range& range(std::size_t i) noexcept { return i < inline_capacity ? m_inline[i] : m_spill[i - inline_capacity]; }
+
+		std::array<Range, inline_capacity> m_inline{};
+		std::vector<Range> m_spill;
+		std::size_t m_size{ 0 };
+		bool m_valid{ true };
+	};
+
+	/// emote id -> number of uses, accumulated over any number of messages
+	/// works straight on the raw tag, so view::PRIVMSG can be fed without an owned copy
+	class EmoteStats
+	{
+	public:
+		using counts_t = std::map<std::string, std::size_t, std::less<>>;
+
+		void add(std::string_view raw_emotes);
+
+		// anything with an "emotes" member: tags::PRIVMSG, view::PRIVMSG
+		template<class Messages>
+		void add_all(const Messages& messages) {
+			for (const auto& message : messages) { add(message.emotes); }
+		}
+
+		std::size_t count(std::string_view id) const noexcept;
+		inline std::size_t total() const noexcept { return m_total; }
+		inline const counts_t& counts() const noexcept { return m_counts; }
+
+	private:
+		counts_t m_counts;
+		std::size_t m_total{ 0 };
+	};
+
+	/// fixed capacity badge set: bit per Badge::Type plus level slot, no allocations
+	/// unhandled badges share one slot, first one wins (same as map::emplace did)
+	class Badges
+	{
+	public:
+		using mask_t = std::uint16_t;
+		static constexpr std::size_t capacity = Badge::staff + 2; // + unhandled_badge
+
+		static constexpr mask_t mask_of(Badge badge) noexcept {
+			return static_cast<mask_t>(1u << slot(badge));
+		}
+
+		constexpr Badges() noexcept = default;
+		constexpr Badges(std::initializer_list<std::pair<Badge, BadgeLevel>> badges) noexcept {
+			for (const auto& [badge, level] : badges) { insert(badge, level); }
+		}
+
+		constexpr bool insert(Badge badge, BadgeLevel level) noexcept {
+			if (contains(badge)) { return false; }
+			m_mask |= mask_of(badge);
+			m_levels[slot(badge)] = level;
+			return true;
+		}
+
+		constexpr bool contains(Badge badge) const noexcept { return any_of(mask_of(badge)); }
+		constexpr bool any_of(mask_t mask) const noexcept { return (m_mask & mask) != 0; }
+		constexpr std::optional<BadgeLevel> level(Badge badge) const noexcept {
+			if (!contains(badge)) { return std::nullopt; }
+			return m_levels[slot(badge)];
+		}
+
+		constexpr mask_t mask() const noexcept { return m_mask; }
+		constexpr bool empty() const noexcept { return m_mask == 0; }
+		constexpr std::size_t size() const noexcept {
+			std::size_t count{ 0 };
+			for (auto mask = m_mask; mask != 0; mask &= mask - 1) { ++count; }
+			return count;
+		}
+
+		// ascending Badge::Type order, unhandled_badge first
+		template<class Fn>
+		void for_each(Fn&& fn) const {
+			for (std::size_t i{ 0 }; i < capacity; ++i) {
+				if (m_mask & (1u << i)) {
+					fn(Badge{ static_cast<Badge::Type>(static_cast<int>(i) - 1) }, m_levels[i]);
+				}
+			}
+		}
+
+		friend constexpr bool operator==(const Badges& lhs, const Badges& rhs) noexcept {
+			if (lhs.m_mask != rhs.m_mask) { return false; }
+			for (std::size_t i{ 0 }; i < capacity; ++i) {
+				if (lhs.m_levels[i] != rhs.m_levels[i]) { return false; }
+			}
+			return true;
+		}
+		friend constexpr bool operator!=(const Badges& lhs, const Badges& rhs) noexcept {
+			return !(lhs == rhs);
+		}
+
+	private:
+		static constexpr std::size_t slot(Badge badge) noexcept {
+			return static_cast<std::size_t>(badge.type + 1);
+		}
+
+		mask_t m_mask{ 0 };
+		std::array<BadgeLevel, capacity> m_levels{};
+	};
+
 	enum class UserPrivilegesLevel : int {
 		normal = 0, regular, subscriber, moderator, broadcaster
 	};
@@ -155,16 +345,13 @@ namespace Twitch::irc::parameters {
 		return logger << Badge::to_string(badge);
 	}
 	template<class Logger>
-	Logger& operator<<(Logger& logger, const std::map<Badge, BadgeLevel>& badges) {
-		const auto first = std::begin(badges);
-		const auto end = std::end(badges);
-
-		if (first == end) { return logger; }
-
-		logger << first->first << '/' << first->second;
-		for (auto it = std::next(first); it != end; ++it) {
-			logger << ' ' << it->first << '/' << it->second;
-		}
+	Logger& operator<<(Logger& logger, const Badges& badges) {
+		bool first{ true };
+		badges.for_each([&](Badge badge, BadgeLevel level) {
+			if (!first) { logger << ' '; }
+			logger << badge << '/' << level;
+			first = false;
+		});
 
 		return logger;
 	}
@@ -4,10 +4,18 @@
 #include "IRC_Bot.h"
 #include "Logger.h"
 #include "TwitchMessage.h"
+#include "Metrics.h"
+#include "Capture.h"
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
 #include <iostream>
 #include <string_view>
 #include <fstream>
 #include <optional>
+#include <vector>
+#include <thread>
+#include <algorithm>
 
 namespace {
 	bool starts_with(std::string_view str, std::string_view with) {
@@ -32,25 +40,39 @@ namespace {
 		return str;
 	}
 	
+	// "#first,#second" -> { "#first", "#second" }
+	std::vector<std::string> split_channels(std::string_view list) {
+		std::vector<std::string> channels;
+		while (!list.empty()) {
+			const auto end = list.find(',');
+			if (const auto channel = list.substr(0, end); !channel.empty()) {
+				channels.emplace_back(channel);
+			}
+			if (end == std::string_view::npos) { break; }
+			list.remove_prefix(end + 1);
+		}
+		return channels;
+	}
+
 	struct Config
 	{
 		inline bool is_good() {
 			return
-				!server.empty()  &&
-			    !port.empty()    &&
-				!channel.empty() &&
-			    !nick.empty()    &&
-			    !token.empty()   &&
-				starts_with(channel, "#") &&
+				!server.empty()   &&
+			    !port.empty()     &&
+				!channels.empty() &&
+			    !nick.empty()     &&
+			    !token.empty()    &&
 				starts_with(token, "oauth:")
 			;
 		}
 
 		std::string server;
 		std::string port;
-		std::string channel; // should start with '#'
+		std::vector<std::string> channels; // comma separated in config.txt, each should start with '#'
 		std::string nick;	 // all lower case
 		std::string token;   // should start with "oauth:"
+		std::string metrics; // optional, Prometheus text is dumped there periodically
 	};
 
 	std::optional<Config> get_config() {
@@ -64,9 +86,10 @@ namespace {
 		std::string temp;
 		file >> temp >> temp; config.server  = std::move(temp);
 		file >> temp >> temp; config.port    = std::move(temp);
-		file >> temp >> temp; config.channel = std::move(temp);
+		file >> temp >> temp; config.channels = split_channels(temp);
 		file >> temp >> temp; config.nick    = std::move(to_lower(temp));
 		file >> temp >> temp; config.token   = std::move(temp);
+		if (file >> temp >> temp) { config.metrics = std::move(temp); }
 		
 		if(!config.is_good()) {
 			std::cerr << "Error: config.txt is not properly filled out\n";
@@ -74,9 +97,11 @@ namespace {
 		}
 		
 		using namespace std::string_view_literals;
-		if (!starts_with(config.channel, "#"sv)) {
-			std::cerr << "Error: channel have to start with \"#\"\n";
-			return std::nullopt;
+		for (const auto& channel : config.channels) {
+			if (!starts_with(channel, "#"sv)) {
+				std::cerr << "Error: channel have to start with \"#\"\n";
+				return std::nullopt;
+			}
 		}
 
 		if (!starts_with(config.token, "oauth:"sv)) {
@@ -86,42 +111,158 @@ namespace {
 
 		return config;
 	}
-}
 
-int main() {
-	const auto config = get_config();
-	if (!config) {
-		return 1;
+	struct Arguments
+	{
+		std::string capture; // every line read is recorded there
+		std::string replay;  // runs over this capture instead of connecting, config.txt isn't needed
+		double speed{ 1.0 }; // of the replay
+	};
+
+	// "max", or a positive number taking up the whole argument, e.g. "2" or "0.5"
+	std::optional<double> get_speed(const char* argument) {
+		using Twitch::irc::capture::ReplayController;
+		if (std::string_view{ argument } == "max") { return ReplayController::as_fast_as_possible; }
+
+		char* end{ nullptr };
+		const auto speed = std::strtod(argument, &end);
+		if (end == argument || *end != '\0' || !std::isfinite(speed) || speed <= 0.0) { return std::nullopt; }
+		return speed;
 	}
 
-	Logger::init();
+	std::optional<Arguments> get_arguments(int argc, char* argv[]) {
+		Arguments arguments;
+		for (int i = 1; i < argc; ++i) {
+			const std::string_view argument{ argv[i] };
+			bool valid{ true };
+			if (argument == "--capture" && i + 1 < argc) {
+				arguments.capture = argv[++i];
+			}
+			else if (argument == "--replay" && i + 1 < argc) {
+				arguments.replay = argv[++i];
+				if (i + 1 < argc && !starts_with(argv[i + 1], "--")) {
+					const auto speed = get_speed(argv[++i]);
+					valid = speed.has_value();
+					arguments.speed = speed.value_or(arguments.speed);
+				}
+			}
+			else {
+				valid = false;
+			}
 
-	auto controller{
-		std::make_shared<Twitch::irc::Controller>(
-			config->server, config->port, config->channel,
-			config->nick, config->token,
-			std::chrono::milliseconds{ 667 }
-		)
-	};
+			if (!valid) {
+				std::cerr << "usage: Twitch_C++_IRC_bot [--capture <file>] [--replay <file> [speed|max]]\n";
+				return std::nullopt;
+			}
+		}
+		return arguments;
+	}
 
-	using Twitch::irc::message::cap::tags::PRIVMSG;
-	auto commands{
-		std::make_shared<Twitch::irc::Commands>(
+	auto make_commands() {
+		using Twitch::irc::message::cap::tags::PRIVMSG;
+		return std::make_shared<Twitch::irc::Commands>(
 			std::initializer_list<Twitch::irc::Commands::value_type>{
 				{
 					"!Hello",
 					[](const PRIVMSG& msg) {
-						return '@' + msg.display_name + " World!";
+						return '@' + std::string{ msg.display_name } + " World!";
 					}
 				}
 			}
-		)
-	};
+		);
+	}
+
+	// whole pipeline over a capture, what it measured goes to stdout as Prometheus text
+	int replay(const Arguments& arguments) {
+		Logger::Options options;
+		options.console = false; // stdout is for the metrics
+		Logger::init(options);
 
-	Twitch::irc::TwitchBot bot(
+		std::shared_ptr<Twitch::irc::capture::ReplayController> controller;
+		try {
+			controller = std::make_shared<Twitch::irc::capture::ReplayController>(arguments.replay, arguments.speed);
+		} catch (const std::exception& e) {
+			std::cerr << "Error: " << e.what() << '\n';
+			return 1;
+		}
+
+		Twitch::irc::TwitchBot bot(
+			make_commands(),
+			controller,
+			std::make_unique<Twitch::irc::message::MessageParser>(Twitch::irc::message::ParserVisitor::subscription())
+		);
+
+		const auto start = std::chrono::steady_clock::now();
+		bot.run_async(); // until the capture ends
+		const std::chrono::duration<double> elapsed{ std::chrono::steady_clock::now() - start };
+
+		const auto snapshot = bot.metrics("replay");
+		std::cout << Twitch::irc::metrics::to_prometheus({ snapshot });
+		std::cerr << snapshot.socket.lines_read << " lines in " << elapsed.count() << "s\n";
+		if (!controller->reader().complete()) {
+			std::cerr << "Error: capture ends in a truncated or corrupt record\n";
+		}
+
+		Logger::shutdown();
+		return 0;
+	}
+}
+
+int main(int argc, char* argv[]) {
+	const auto arguments = get_arguments(argc, argv);
+	if (!arguments) {
+		return 1;
+	}
+	if (!arguments->replay.empty()) {
+		return replay(*arguments);
+	}
+
+	const auto config = get_config();
+	if (!config) {
+		return 1;
+	}
+
+	Logger::init();
+
+	auto commands{ make_commands() };
+
+	// a connection per core, more when the cores can't fit a hundred channels each
+	Twitch::irc::ConnectionPool pool(
+		config->channels,
+		std::max(1u, std::thread::hardware_concurrency()),
+		[&](std::vector<std::string> channels) {
+			return std::make_shared<Twitch::irc::Controller>(
+				config->server, config->port, std::move(channels),
+				config->nick, config->token
+			);
+		},
 		commands,
-		controller,
-		std::make_unique<Twitch::irc::message::MessageParser>()
+		std::make_shared<Twitch::irc::CommandExecutor>(
+			2,  // threads
+			64, // queued commands
+			Twitch::irc::CommandExecutor::Overflow::drop
+		)
 	);
-	bot.run();
+
+	// shared with the shards, the last one to let go flushes what is left
+	std::shared_ptr<Twitch::irc::capture::Writer> capture;
+	if (!arguments->capture.empty()) {
+		try {
+			capture = std::make_shared<Twitch::irc::capture::Writer>(arguments->capture);
+		} catch (const std::exception& e) {
+			std::cerr << "Error: " << e.what() << '\n';
+			return 1;
+		}
+		pool.set_capture(capture);
+	}
+
+	// stopped before the pool goes away, writes the final numbers on the way out
+	std::optional<Twitch::irc::metrics::Reporter> reporter;
+	if (!config->metrics.empty()) {
+		using namespace std::chrono_literals;
+		reporter.emplace([&pool]() { return pool.metrics(); }, config->metrics, 15s);
+	}
+	pool.run();
+
+	Logger::shutdown(); // writes out what is still queued
 }
\ No newline at end of file